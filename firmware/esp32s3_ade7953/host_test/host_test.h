@@ -0,0 +1,22 @@
+#pragma once
+
+#include <stdio.h>
+
+// Minimal checks for the host tests: a failed check is printed and counted, main() returns the count
+extern int host_test_failures;
+
+#define CHECK(condition, ...) do {                                                  \
+        if (!(condition)) {                                                         \
+            host_test_failures++;                                                   \
+            printf("FAIL %s:%d: %s: ", __FILE__, __LINE__, #condition);             \
+            printf(__VA_ARGS__);                                                    \
+            printf("\n");                                                           \
+        }                                                                           \
+    } while (0)
+
+// Run one test function and report it
+#define RUN_TEST(test) do {                                                         \
+        int failures_before = host_test_failures;                                   \
+        test();                                                                     \
+        printf("%s %s\n", host_test_failures == failures_before ? "PASS" : "FAIL", #test); \
+    } while (0)
@@ -0,0 +1,4 @@
+#pragma once
+
+// Host stand-in: pin numbers only
+typedef int gpio_num_t;
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Host stand-in: the types ade7953.h declares its handle with, no bus
+typedef struct spi_device_t *spi_device_handle_t;
+
+typedef struct {
+    uint32_t flags;
+    size_t length;
+    size_t rxlength;
+    void *user;
+    const void *tx_buffer;
+    void *rx_buffer;
+} spi_transaction_t;
@@ -0,0 +1,3 @@
+#pragma once
+
+// Host stand-in: nothing of SNTP is used by the modules under test
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <stdint.h>
+
+// Host stand-in: the handle and tick types the module headers declare, no scheduler
+typedef uint32_t TickType_t;
+typedef int32_t BaseType_t;
+typedef uint32_t UBaseType_t;
+typedef struct { int lock; } portMUX_TYPE;
+typedef struct tskTaskControlBlock *TaskHandle_t;
+typedef struct QueueDefinition *QueueHandle_t;
+typedef QueueHandle_t SemaphoreHandle_t;
@@ -0,0 +1,3 @@
+#pragma once
+
+// Host build: no CONFIG_IDF_TARGET_*, so modules pick their portable paths
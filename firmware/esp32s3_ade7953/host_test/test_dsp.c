@@ -0,0 +1,65 @@
+#include <math.h>
+#include "host_test.h"
+#include "dsp.h"
+#include "esp_timer.h"
+#include "waveform.h"
+
+// Throughput of the scalar kernels on one two-cycle window. A desktop takes a few microseconds per
+// window; the bound is far above that and only catches a gross regression, such as a kernel gone
+// quadratic. The device budget (one DFT per line cycle, one Goertzel per synchrophasor report) is
+// measured on the target by dsp_benchmark() against esp-dsp.
+#define DSP_TEST_THROUGHPUT_ITERATIONS  20000
+#define DSP_TEST_MAX_WINDOW_US          50.0
+
+int host_test_failures = 0;
+
+// The scalar backend against the double-precision reference; the device runs the same check on esp-dsp
+static void test_dsp_scalar_matches_reference(void) {
+    CHECK(dsp_init() == DSP_OK, "init");
+    CHECK(dsp_self_test() == 0, "see the errors above");
+}
+
+// The waveform estimator's phase DFT (two dot products against the reference tables) and the
+// synchrophasor's windowed Goertzel, both over WAVEFORM_DFT_MAX_WINDOW_SIZE samples of a 50 Hz sine
+static void test_dsp_scalar_throughput(void) {
+    static float input[WAVEFORM_DFT_MAX_WINDOW_SIZE], window[WAVEFORM_DFT_MAX_WINDOW_SIZE];
+    static float ref_cos[WAVEFORM_DFT_MAX_WINDOW_SIZE], ref_sin[WAVEFORM_DFT_MAX_WINDOW_SIZE];
+    static float work[WAVEFORM_DFT_MAX_WINDOW_SIZE];
+    const int n = WAVEFORM_DFT_MAX_WINDOW_SIZE;
+    const double step = 2.0 * M_PI * 50.0 / WAVEFORM_SAMPLE_RATE_HZ;
+    
+    CHECK(dsp_init() == DSP_OK, "init");
+    dsp_window_hann(window, n);
+    for (int i = 0; i < n; i++) {
+        input[i] = (float)(1e6 * sin(step * i + 0.3));
+        ref_cos[i] = window[i] * (float)cos(step * i);
+        ref_sin[i] = window[i] * (float)sin(step * i);
+    }
+    
+    volatile float sink = 0.0f;
+    int64_t start_us = esp_timer_get_time();
+    for (int i = 0; i < DSP_TEST_THROUGHPUT_ITERATIONS; i++) {
+        sink += dsp_dotprod(input, ref_cos, n) - dsp_dotprod(input, ref_sin, n);
+    }
+    double dft_us = (double)(esp_timer_get_time() - start_us) / DSP_TEST_THROUGHPUT_ITERATIONS;
+    
+    start_us = esp_timer_get_time();
+    for (int i = 0; i < DSP_TEST_THROUGHPUT_ITERATIONS; i++) {
+        float amplitude, phase;
+        dsp_multiply(input, window, work, n);
+        dsp_goertzel(work, n, (float)(50.0 / WAVEFORM_SAMPLE_RATE_HZ), &amplitude, &phase);
+        sink += amplitude + phase;
+    }
+    double goertzel_us = (double)(esp_timer_get_time() - start_us) / DSP_TEST_THROUGHPUT_ITERATIONS;
+    
+    printf("%s, %d samples: DFT %.2f us (%.1f Msamples/s), windowed Goertzel %.2f us (%.1f Msamples/s)\n",
+           dsp_backend_name(), n, dft_us, n / dft_us, goertzel_us, n / goertzel_us);
+    CHECK(dft_us < DSP_TEST_MAX_WINDOW_US, "DFT took %.2f us per window", dft_us);
+    CHECK(goertzel_us < DSP_TEST_MAX_WINDOW_US, "Goertzel took %.2f us per window", goertzel_us);
+}
+
+int main(void) {
+    RUN_TEST(test_dsp_scalar_matches_reference);
+    RUN_TEST(test_dsp_scalar_throughput);
+    return host_test_failures != 0;
+}
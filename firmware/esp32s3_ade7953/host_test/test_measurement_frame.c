@@ -0,0 +1,107 @@
+#include <stdint.h>
+#include <string.h>
+#include "host_test.h"
+#include "measurement_frame.h"
+#include "json_writer.h"
+
+int host_test_failures = 0;
+
+// Stand-in for the calibration table in ade7953.c: the default set, with the factors the reference
+// encoder in tools/measurement_frame_decoder.py defaults to
+static const ade7953_calibration_t g_calibration = {
+    .id = ADE7953_DEFAULT_CALIBRATION_ID,
+    .period_clock_hz = GRID_FREQUENCY_CONVERSION_FACTOR,
+    .volts_per_lsb = VOLTAGE_CONVERSION_FACTOR,
+};
+
+const ade7953_calibration_t *ade7953_get_calibration(uint8_t calibration_id) {
+    return calibration_id == g_calibration.id ? &g_calibration : NULL;
+}
+
+// Only measurement_frame_benchmark() calls these, it is not run here
+float ade7953_measurement_frequency(const measurement_t *measurement) { return 0.0f; }
+float ade7953_measurement_voltage(const measurement_t *measurement) { return 0.0f; }
+void json_writer_init(json_writer_t *writer, char *buffer, size_t size) { }
+void json_writer_object_begin(json_writer_t *writer, const char *key) { }
+void json_writer_object_end(json_writer_t *writer) { }
+void json_writer_int(json_writer_t *writer, const char *key, int64_t value) { }
+void json_writer_uint(json_writer_t *writer, const char *key, uint64_t value) { }
+void json_writer_float(json_writer_t *writer, const char *key, double value, uint8_t decimals) { }
+const char *json_writer_finish(json_writer_t *writer, size_t *length) { return NULL; }
+
+#define FRAME_TEST_BASE_US      1760000000000000LL
+
+static const uint8_t g_device_id[MEASUREMENT_FRAME_DEVICE_ID_LEN] = { 0xA0, 0xB1, 0xC2, 0xD3, 0xE4, 0xF5 };
+
+// One waveform-mode frame: 20 ms cycles with a few us of timestamp jitter, two samples lost across the
+// sequence wrap and three later on (with the time they took), and a 14 mHz / 0.7 V step down in between
+static const measurement_t g_samples[] = {
+    { FRAME_TEST_BASE_US + 0,      0xFFFFFFFC, 50001200, 5930000, MEASUREMENT_FREQUENCY_UNIT_MICROHERTZ, ADE7953_DEFAULT_CALIBRATION_ID },
+    { FRAME_TEST_BASE_US + 20003,  0xFFFFFFFD, 50001350, 5930110, MEASUREMENT_FREQUENCY_UNIT_MICROHERTZ, ADE7953_DEFAULT_CALIBRATION_ID },
+    { FRAME_TEST_BASE_US + 39998,  0xFFFFFFFE, 50001410, 5929950, MEASUREMENT_FREQUENCY_UNIT_MICROHERTZ, ADE7953_DEFAULT_CALIBRATION_ID },
+    { FRAME_TEST_BASE_US + 100011, 0x00000001, 50001380, 5930020, MEASUREMENT_FREQUENCY_UNIT_MICROHERTZ, ADE7953_DEFAULT_CALIBRATION_ID },
+    { FRAME_TEST_BASE_US + 119990, 0x00000002, 49987250, 5912400, MEASUREMENT_FREQUENCY_UNIT_MICROHERTZ, ADE7953_DEFAULT_CALIBRATION_ID },
+    { FRAME_TEST_BASE_US + 140004, 0x00000003, 49987300, 5912480, MEASUREMENT_FREQUENCY_UNIT_MICROHERTZ, ADE7953_DEFAULT_CALIBRATION_ID },
+    { FRAME_TEST_BASE_US + 160000, 0x00000004, 49987190, 5912390, MEASUREMENT_FREQUENCY_UNIT_MICROHERTZ, ADE7953_DEFAULT_CALIBRATION_ID },
+    { FRAME_TEST_BASE_US + 240017, 0x00000008, 49990020, 5915000, MEASUREMENT_FREQUENCY_UNIT_MICROHERTZ, ADE7953_DEFAULT_CALIBRATION_ID },
+    { FRAME_TEST_BASE_US + 259986, 0x00000009, 49990110, 5915030, MEASUREMENT_FREQUENCY_UNIT_MICROHERTZ, ADE7953_DEFAULT_CALIBRATION_ID },
+    { FRAME_TEST_BASE_US + 280001, 0x0000000A, 49990060, 5914970, MEASUREMENT_FREQUENCY_UNIT_MICROHERTZ, ADE7953_DEFAULT_CALIBRATION_ID },
+};
+#define FRAME_TEST_SAMPLE_COUNT (sizeof(g_samples) / sizeof(g_samples[0]))
+#define FRAME_TEST_SEQUENCE     41
+
+// The same samples through the reference encoder, from tools/:
+//   encode_columnar_frame("a0b1c2d3e4f5", 41, [(timestamp_us, frequency_code, voltage_code, sequence), ...])
+static const uint8_t g_golden_frame[] = {
+    0x4F, 0x47, 0x03, 0x01, 0xA0, 0xB1, 0xC2, 0xD3, 0xE4, 0xF5, 0x0A, 0x00,
+    0x29, 0x00, 0x00, 0x00, 0x00, 0x00, 0xCE, 0xEE, 0xB5, 0x40, 0x06, 0x00,
+    0x01, 0x01, 0x80, 0x81, 0x5A, 0x48, 0x72, 0xB2, 0x22, 0x38, 0xFC, 0xFF,
+    0xFF, 0xFF, 0x02, 0x03, 0x02, 0x04, 0x03, 0x00, 0xC6, 0xB8, 0x02, 0x0F,
+    0xA4, 0xF1, 0x04, 0xC3, 0xF1, 0x04, 0x46, 0x23, 0xEA, 0xA9, 0x07, 0x9F,
+    0xAA, 0x07, 0x5C, 0xE0, 0xD4, 0xD7, 0x2F, 0xAC, 0x02, 0x78, 0x3B, 0xE3,
+    0xDC, 0x01, 0x64, 0xDB, 0x01, 0x9C, 0x2C, 0xB4, 0x01, 0x63, 0xA0, 0xF0,
+    0xD3, 0x05, 0xDC, 0x01, 0xBF, 0x02, 0x8C, 0x01, 0xA7, 0x93, 0x02, 0xA0,
+    0x01, 0xB3, 0x01, 0xE4, 0x28, 0x3C, 0x77,
+};
+
+static measurement_frame_t g_frame;
+
+// The firmware encoder must produce the reference encoder's bytes, which the decoder is tested against
+static void test_golden_frame(void) {
+    CHECK(measurement_frame_init(&g_frame, g_device_id, MEASUREMENT_FRAME_MAX_SAMPLES, 1) == MEASUREMENT_FRAME_OK, "init");
+    g_frame.sequence = FRAME_TEST_SEQUENCE;
+    for (size_t i = 0; i < FRAME_TEST_SAMPLE_COUNT; i++) {
+        CHECK(measurement_frame_add(&g_frame, &g_samples[i]), "sample %zu refused", i);
+    }
+    
+    size_t length = measurement_frame_finish(&g_frame);
+    CHECK(length == sizeof(g_golden_frame), "%zu bytes, expected %zu", length, sizeof(g_golden_frame));
+    for (size_t i = 0; i < length && i < sizeof(g_golden_frame); i++) {
+        if (g_frame.buffer[i] != g_golden_frame[i]) {
+            CHECK(g_frame.buffer[i] == g_golden_frame[i], "first difference at byte %zu: 0x%02X, expected 0x%02X",
+                  i, g_frame.buffer[i], g_golden_frame[i]);
+            break;
+        }
+    }
+}
+
+// A sample that goes back in time or in sequence must start a new frame instead
+static void test_fits(void) {
+    CHECK(measurement_frame_init(&g_frame, g_device_id, MEASUREMENT_FRAME_MAX_SAMPLES, 1) == MEASUREMENT_FRAME_OK, "init");
+    CHECK(measurement_frame_add(&g_frame, &g_samples[1]), "first sample");
+    CHECK(!measurement_frame_fits(&g_frame, &g_samples[0]), "earlier sample accepted");
+    
+    measurement_t repeated = g_samples[2];
+    repeated.sequence = g_samples[1].sequence;
+    CHECK(!measurement_frame_fits(&g_frame, &repeated), "repeated sequence accepted");
+    
+    measurement_t next_second = g_samples[2];
+    next_second.timestamp_us = FRAME_TEST_BASE_US + 1000000;
+    CHECK(!measurement_frame_fits(&g_frame, &next_second), "sample of the next second accepted");
+}
+
+int main(void) {
+    RUN_TEST(test_golden_frame);
+    RUN_TEST(test_fits);
+    return host_test_failures;
+}
@@ -0,0 +1,137 @@
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "host_test.h"
+#include "quantile.h"
+
+#define QUANTILE_TEST_SAMPLES           1000000
+
+// Fraction of the samples between the estimate and the exact quantile. P² assumes a stationary series:
+// after a step its markers keep heights from before. A step of one noise deviation a third of the way in costs
+// about 2.7 % at p95, the half-deviation step below about 1 %.
+#define QUANTILE_TEST_MAX_RANK_ERROR        0.005
+#define QUANTILE_TEST_MAX_STEP_RANK_ERROR   0.015
+
+int host_test_failures = 0;
+
+static const float g_quantiles[] = { 0.01f, 0.05f, 0.5f, 0.95f, 0.99f };
+#define QUANTILE_TEST_COUNT (sizeof(g_quantiles) / sizeof(g_quantiles[0]))
+
+static uint32_t g_state;
+
+// Uniform in [0, 1) from a fixed LCG
+static float uniform(void) {
+    g_state = g_state * 1664525u + 1013904223u;
+    return (float)(g_state >> 8) / (float)(1u << 24);
+}
+
+// Standard normal, Box-Muller
+static float normal(void) {
+    float u = uniform();
+    float v = uniform();
+    return sqrtf(-2.0f * logf(1.0f - u)) * cosf(2.0f * (float)M_PI * v);
+}
+
+static int compare_float(const void *a, const void *b) {
+    float x = *(const float *)a, y = *(const float *)b;
+    return (x > y) - (x < y);
+}
+
+// Feed the series through one estimator per quantile in a single pass, then compare each estimate's
+// rank among the sorted samples with the exact rank
+static void check_series(const char *name, float *values, uint32_t samples, double max_rank_error) {
+    quantile_p2_t estimators[QUANTILE_TEST_COUNT];
+    
+    for (size_t j = 0; j < QUANTILE_TEST_COUNT; j++) {
+        CHECK(quantile_p2_init(&estimators[j], g_quantiles[j]) == QUANTILE_OK, "init p%g", g_quantiles[j]);
+    }
+    for (uint32_t i = 0; i < samples; i++) {
+        for (size_t j = 0; j < QUANTILE_TEST_COUNT; j++) {
+            quantile_p2_add(&estimators[j], values[i]);
+        }
+    }
+    
+    qsort(values, samples, sizeof(float), compare_float);
+    
+    for (size_t j = 0; j < QUANTILE_TEST_COUNT; j++) {
+        float estimate = quantile_p2_get(&estimators[j]);
+        uint32_t exact_rank = (uint32_t)(g_quantiles[j] * (samples - 1));
+        
+        // Rank of the estimate among the sorted samples
+        uint32_t low = 0, high = samples;
+        while (low < high) {
+            uint32_t mid = (low + high) / 2;
+            if (values[mid] < estimate) {
+                low = mid + 1;
+            } else {
+                high = mid;
+            }
+        }
+        double rank_error = ((double)low - exact_rank) / samples;
+        
+        printf("  %s p%.0f: estimate %.6f, exact %.6f, rank error %+.4f\n", name, g_quantiles[j] * 100.0f,
+               estimate, values[exact_rank], rank_error);
+        CHECK(fabs(rank_error) <= max_rank_error, "%s p%.0f rank error %+.4f", name,
+              g_quantiles[j] * 100.0f, rank_error);
+    }
+}
+
+static void test_uniform(void) {
+    float *values = malloc(QUANTILE_TEST_SAMPLES * sizeof(float));
+    
+    g_state = 1;
+    for (uint32_t i = 0; i < QUANTILE_TEST_SAMPLES; i++) {
+        values[i] = uniform();
+    }
+    check_series("uniform", values, QUANTILE_TEST_SAMPLES, QUANTILE_TEST_MAX_RANK_ERROR);
+    free(values);
+}
+
+// Frequency deviation in Hz with a 20 mHz spread
+static void test_normal(void) {
+    float *values = malloc(QUANTILE_TEST_SAMPLES * sizeof(float));
+    
+    g_state = 2;
+    for (uint32_t i = 0; i < QUANTILE_TEST_SAMPLES; i++) {
+        values[i] = 0.02f * normal();
+    }
+    check_series("normal", values, QUANTILE_TEST_SAMPLES, QUANTILE_TEST_MAX_RANK_ERROR);
+    free(values);
+}
+
+// Halfway through, the grid settles 10 mHz lower after a generator trip: the estimators must follow the
+// new level with their markers already spread around the old one
+static void test_step_change(void) {
+    float *values = malloc(QUANTILE_TEST_SAMPLES * sizeof(float));
+    
+    g_state = 3;
+    for (uint32_t i = 0; i < QUANTILE_TEST_SAMPLES; i++) {
+        values[i] = 0.02f * normal() - (i < QUANTILE_TEST_SAMPLES / 2 ? 0.0f : 0.01f);
+    }
+    check_series("step", values, QUANTILE_TEST_SAMPLES, QUANTILE_TEST_MAX_STEP_RANK_ERROR);
+    free(values);
+}
+
+// Slow wander plus skewed noise (a sum of uniforms, squared on one side), like a frequency deviation
+static void test_drifting_skewed(void) {
+    float *values = malloc(QUANTILE_TEST_SAMPLES * sizeof(float));
+    float wander = 0.0f;
+    
+    g_state = 12345;
+    for (uint32_t i = 0; i < QUANTILE_TEST_SAMPLES; i++) {
+        float noise = uniform() + uniform() + uniform() - 1.5f;
+        wander += noise * 0.0005f;
+        wander *= 0.999f;
+        values[i] = wander + (noise > 0.0f ? noise * noise * 0.02f : noise * 0.01f);
+    }
+    check_series("drifting", values, QUANTILE_TEST_SAMPLES, QUANTILE_TEST_MAX_RANK_ERROR);
+    free(values);
+}
+
+int main(void) {
+    RUN_TEST(test_uniform);
+    RUN_TEST(test_normal);
+    RUN_TEST(test_step_change);
+    RUN_TEST(test_drifting_skewed);
+    return host_test_failures != 0;
+}
@@ -0,0 +1,209 @@
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <string.h>
+#include "host_test.h"
+#include "ring_buffer.h"
+
+#define SPSC_TEST_COUNT         2000000
+#define SPSC_TEST_CAPACITY      64
+#define SPSC_TEST_BULK_SIZE     16
+#define MPSC_TEST_PRODUCERS     4
+#define MPSC_TEST_COUNT         250000  // Per producer
+#define MPSC_TEST_CAPACITY      32
+
+int host_test_failures = 0;
+
+// Element about the size of a queued measurement, check catches torn copies
+typedef struct {
+    uint32_t sequence;
+    uint32_t check;
+    int64_t payload;
+    uint32_t producer;
+    uint32_t padding;
+} ring_test_element_t;
+
+typedef struct {
+    spsc_ring_t ring;
+    bool retry;                         // Producer spins on a full ring instead of dropping
+    uint32_t full_pushes;               // Pushes the ring refused, read after the producer is joined
+    uint32_t lost;                      // Elements given up on
+    atomic_bool done;
+} spsc_test_t;
+
+static ring_test_element_t make_element(uint32_t producer, uint32_t sequence) {
+    ring_test_element_t element = {
+        .sequence = sequence,
+        .check = ~sequence,
+        .payload = (int64_t)sequence * 20000 + producer,
+        .producer = producer,
+    };
+    return element;
+}
+
+static bool element_intact(const ring_test_element_t *element) {
+    return element->check == ~element->sequence &&
+           element->payload == (int64_t)element->sequence * 20000 + element->producer;
+}
+
+// Push SPSC_TEST_COUNT elements, either waiting for room or giving up on the element
+static void *spsc_producer(void *arg) {
+    spsc_test_t *test = arg;
+    
+    for (uint32_t i = 0; i < SPSC_TEST_COUNT; i++) {
+        ring_test_element_t element = make_element(0, i);
+        while (!spsc_ring_push(&test->ring, &element)) {
+            test->full_pushes++;
+            if (!test->retry) {
+                test->lost++;
+                break;
+            }
+            sched_yield();
+        }
+    }
+    atomic_store(&test->done, true);
+    return NULL;
+}
+
+// One producer thread and the consumer on this thread: every element arrives intact and in order,
+// gaps only where the producer gave up, and the ring's drop counter agrees
+static void run_spsc(bool retry) {
+    static ring_test_element_t storage[SPSC_TEST_CAPACITY];
+    ring_test_element_t elements[SPSC_TEST_BULK_SIZE];
+    spsc_test_t test = { .retry = retry };
+    pthread_t producer;
+    
+    atomic_init(&test.done, false);
+    
+    CHECK(spsc_ring_init(&test.ring, storage, SPSC_TEST_CAPACITY, sizeof(ring_test_element_t)) == RING_BUFFER_OK, "init");
+    CHECK(pthread_create(&producer, NULL, spsc_producer, &test) == 0, "thread");
+    
+    uint32_t received = 0, torn = 0, out_of_order = 0;
+    int64_t last = -1;
+    while (true) {
+        // Read before popping: once the producer is done, an empty pop means the ring is drained
+        bool done = atomic_load(&test.done);
+        size_t n = spsc_ring_pop_bulk(&test.ring, elements, SPSC_TEST_BULK_SIZE);
+        if (n == 0) {
+            if (done) {
+                break;
+            }
+            sched_yield();
+            continue;
+        }
+        for (size_t i = 0; i < n; i++) {
+            torn += !element_intact(&elements[i]);
+            out_of_order += (int64_t)elements[i].sequence <= last;
+            last = elements[i].sequence;
+        }
+        received += n;
+    }
+    pthread_join(producer, NULL);
+    
+    spsc_ring_stats_t stats;
+    spsc_ring_get_stats(&test.ring, &stats);
+    CHECK(torn == 0, "%u torn elements", torn);
+    CHECK(out_of_order == 0, "%u elements out of order", out_of_order);
+    CHECK(received + test.lost == SPSC_TEST_COUNT, "received %u + lost %u != %u", received, test.lost, SPSC_TEST_COUNT);
+    CHECK(stats.drop_count == test.full_pushes, "drop count %u, full pushes %u", stats.drop_count, test.full_pushes);
+    CHECK(stats.high_water <= SPSC_TEST_CAPACITY, "high water %zu", stats.high_water);
+    printf("  %u received, %u lost, %u full pushes, high water %zu/%d\n", received, test.lost, test.full_pushes,
+           stats.high_water, SPSC_TEST_CAPACITY);
+}
+
+static void test_spsc_lossless(void) {
+    run_spsc(true);
+}
+
+static void test_spsc_drops_counted(void) {
+    run_spsc(false);
+}
+
+static void test_spsc_rejects_bad_capacity(void) {
+    spsc_ring_t ring;
+    uint8_t storage[3 * sizeof(uint32_t)];
+    CHECK(spsc_ring_init(&ring, storage, 3, sizeof(uint32_t)) == RING_BUFFER_ERROR_INVALID_PARAM, "capacity 3");
+    CHECK(spsc_ring_init(&ring, NULL, 4, sizeof(uint32_t)) == RING_BUFFER_ERROR_INVALID_PARAM, "no storage");
+}
+
+static mpsc_ring_t g_mpsc_ring;
+
+// Push MPSC_TEST_COUNT elements of this producer, waiting for room
+static void *mpsc_producer(void *arg) {
+    uint32_t producer = (uint32_t)(uintptr_t)arg;
+    
+    for (uint32_t i = 0; i < MPSC_TEST_COUNT; i++) {
+        ring_test_element_t element = make_element(producer, i);
+        while (!mpsc_ring_push(&g_mpsc_ring, &element)) {
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+// Several producer threads: nothing lost or duplicated, each producer's elements in its own order
+static void test_mpsc_producers(void) {
+    static uint8_t storage[MPSC_RING_STORAGE_SIZE(MPSC_TEST_CAPACITY, sizeof(ring_test_element_t))]
+        __attribute__((aligned(sizeof(atomic_size_t))));
+    pthread_t producers[MPSC_TEST_PRODUCERS];
+    int64_t last[MPSC_TEST_PRODUCERS];
+    uint32_t received = 0, torn = 0, out_of_order = 0;
+    
+    CHECK(mpsc_ring_init(&g_mpsc_ring, storage, MPSC_TEST_CAPACITY, sizeof(ring_test_element_t)) == RING_BUFFER_OK, "init");
+    for (int p = 0; p < MPSC_TEST_PRODUCERS; p++) {
+        last[p] = -1;
+        CHECK(pthread_create(&producers[p], NULL, mpsc_producer, (void *)(uintptr_t)p) == 0, "thread %d", p);
+    }
+    
+    while (received < MPSC_TEST_PRODUCERS * MPSC_TEST_COUNT) {
+        ring_test_element_t element;
+        if (!mpsc_ring_pop(&g_mpsc_ring, &element)) {
+            sched_yield();
+            continue;
+        }
+        if (element.producer >= MPSC_TEST_PRODUCERS || !element_intact(&element)) {
+            torn++;
+        } else {
+            out_of_order += (int64_t)element.sequence != last[element.producer] + 1;
+            last[element.producer] = element.sequence;
+        }
+        received++;
+    }
+    for (int p = 0; p < MPSC_TEST_PRODUCERS; p++) {
+        pthread_join(producers[p], NULL);
+    }
+    
+    ring_test_element_t extra;
+    CHECK(!mpsc_ring_pop(&g_mpsc_ring, &extra), "element left over");
+    CHECK(torn == 0, "%u torn elements", torn);
+    CHECK(out_of_order == 0, "%u elements out of order or missing", out_of_order);
+    for (int p = 0; p < MPSC_TEST_PRODUCERS; p++) {
+        CHECK(last[p] == MPSC_TEST_COUNT - 1, "producer %d ended at %lld", p, (long long)last[p]);
+    }
+}
+
+// A full MPSC ring refuses the push instead of overwriting
+static void test_mpsc_full(void) {
+    static uint8_t storage[MPSC_RING_STORAGE_SIZE(4, sizeof(uint32_t))] __attribute__((aligned(sizeof(atomic_size_t))));
+    mpsc_ring_t ring;
+    uint32_t value;
+    
+    mpsc_ring_init(&ring, storage, 4, sizeof(uint32_t));
+    for (value = 0; value < 4; value++) {
+        CHECK(mpsc_ring_push(&ring, &value), "push %u", value);
+    }
+    CHECK(!mpsc_ring_push(&ring, &value), "push into a full ring");
+    for (uint32_t expected = 0; expected < 4; expected++) {
+        CHECK(mpsc_ring_pop(&ring, &value) && value == expected, "pop %u", expected);
+    }
+    CHECK(!mpsc_ring_pop(&ring, &value), "pop from an empty ring");
+}
+
+int main(void) {
+    RUN_TEST(test_spsc_lossless);
+    RUN_TEST(test_spsc_drops_counted);
+    RUN_TEST(test_spsc_rejects_bad_capacity);
+    RUN_TEST(test_mpsc_producers);
+    RUN_TEST(test_mpsc_full);
+    return host_test_failures != 0;
+}
@@ -1,4 +1,7 @@
 #include "ade7953.h"
+#include "dsp.h"
+#include "binlog.h"
+#include <math.h>
 
 static const char *TAG = "ade7953";
 
@@ -31,7 +34,7 @@ static ade7953_error_t ade7953_configure_gpio(void) {
         return ADE7953_ERROR_INIT;
     }
     
-    // Configure interrupt pin as input (for future use)
+    // Configure interrupt pin as input (edge interrupt is attached when interrupt acquisition starts)
     io_conf.mode = GPIO_MODE_INPUT;
     io_conf.pin_bit_mask = (1ULL << ADE7953_INTERRUPT_PIN);
     io_conf.pull_up_en = 1;
@@ -45,6 +48,14 @@ static ade7953_error_t ade7953_configure_gpio(void) {
     return ADE7953_OK;
 }
 
+// Release the SPI DMA buffers
+static void ade7953_free_dma_buffers(ade7953_handle_t *handle) {
+    heap_caps_free(handle->spi_tx_buffer);
+    heap_caps_free(handle->spi_rx_buffer);
+    handle->spi_tx_buffer = NULL;
+    handle->spi_rx_buffer = NULL;
+}
+
 // Configure SPI interface
 static ade7953_error_t ade7953_configure_spi(ade7953_handle_t *handle) {
     spi_bus_config_t buscfg = {
@@ -68,15 +79,26 @@ static ade7953_error_t ade7953_configure_spi(ade7953_handle_t *handle) {
         .input_delay_ns = 0,
         .spics_io_num = ADE7953_SS_PIN,
         .flags = 0,
-        .queue_size = 1,
+        .queue_size = ADE7953_SPI_QUEUE_SIZE,
         .pre_cb = NULL,
         .post_cb = NULL,
     };
     
+    // Allocate word-aligned DMA buffers once so that no transaction needs a stack or bounce buffer
+    size_t buffer_size = ADE7953_SPI_QUEUE_SIZE * ADE7953_SPI_DMA_SLOT_SIZE;
+    handle->spi_tx_buffer = heap_caps_aligned_calloc(ADE7953_SPI_DMA_ALIGNMENT, 1, buffer_size, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+    handle->spi_rx_buffer = heap_caps_aligned_calloc(ADE7953_SPI_DMA_ALIGNMENT, 1, buffer_size, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+    if (!handle->spi_tx_buffer || !handle->spi_rx_buffer) {
+        ESP_LOGE(TAG, "Failed to allocate SPI DMA buffers");
+        ade7953_free_dma_buffers(handle);
+        return ADE7953_ERROR_INIT;
+    }
+    
     // Initialize the SPI bus
     esp_err_t ret = spi_bus_initialize(ADE7953_SPI_HOST, &buscfg, SPI_DMA_CH_AUTO);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to initialize SPI bus: %s", esp_err_to_name(ret));
+        ade7953_free_dma_buffers(handle);
         return ADE7953_ERROR_INIT;
     }
     
@@ -85,25 +107,60 @@ static ade7953_error_t ade7953_configure_spi(ade7953_handle_t *handle) {
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to add SPI device: %s", esp_err_to_name(ret));
         spi_bus_free(ADE7953_SPI_HOST);
+        ade7953_free_dma_buffers(handle);
         return ADE7953_ERROR_INIT;
     }
     
     return ADE7953_OK;
 }
 
-// Write to ADE7953 register
-ade7953_error_t ade7953_write_register(ade7953_handle_t *handle, uint16_t reg_addr, uint8_t n_bits, uint32_t data) {
-    if (!handle || !handle->initialized) {
-        return ADE7953_ERROR_INIT;
-    }
+// Prepare a read transaction in a DMA slot
+static void ade7953_prepare_read(ade7953_handle_t *handle, size_t slot, uint16_t reg_addr, uint8_t n_bits) {
+    uint8_t *tx_data = handle->spi_tx_buffer + slot * ADE7953_SPI_DMA_SLOT_SIZE;
+    spi_transaction_t *trans = &handle->spi_transactions[slot];
     
-    // Take mutex with timeout
-    if (xSemaphoreTake(handle->spi_mutex, pdMS_TO_TICKS(100)) != pdTRUE) {
-        ESP_LOGE(TAG, "Failed to acquire SPI mutex");
-        return ADE7953_ERROR_TIMEOUT;
+    memset(tx_data, 0, ADE7953_SPI_DMA_SLOT_SIZE);
+    tx_data[0] = (reg_addr >> 8) & 0xFF;  // Address high byte
+    tx_data[1] = reg_addr & 0xFF;         // Address low byte
+    tx_data[2] = READ_TRANSFER;           // Read command
+    
+    // Address (2) + command (1) + data, rounded up to a whole DMA word so the driver can DMA straight
+    // into the slot. The extra clocks after the register value are ignored by the chip and CS ends the read.
+    size_t total_len = 3 + n_bits / 8;
+    total_len = (total_len + ADE7953_SPI_DMA_ALIGNMENT - 1) & ~(ADE7953_SPI_DMA_ALIGNMENT - 1);
+    
+    memset(trans, 0, sizeof(spi_transaction_t));
+    trans->length = total_len * 8;  // Length in bits
+    trans->tx_buffer = tx_data;
+    trans->rx_buffer = handle->spi_rx_buffer + slot * ADE7953_SPI_DMA_SLOT_SIZE;
+    handle->spi_pending_bits[slot] = n_bits;
+}
+
+// Extract a register value from a completed read slot
+static uint32_t ade7953_extract_read(ade7953_handle_t *handle, size_t slot) {
+    const uint8_t *rx_data = handle->spi_rx_buffer + slot * ADE7953_SPI_DMA_SLOT_SIZE;
+    uint8_t data_bytes = handle->spi_pending_bits[slot] / 8;
+    uint32_t data = 0;
+    
+    // Skip first 3 bytes which are echo of command
+    for (int i = 0; i < data_bytes; i++) {
+        data = (data << 8) | rx_data[3 + i];
+    }
+    return data;
+}
+
+// True for the task allowed to touch the SPI device: the acquisition task, or anyone before it starts
+static inline bool ade7953_is_spi_owner(const ade7953_handle_t *handle) {
+    return !handle->task_handle || xTaskGetCurrentTaskHandle() == handle->task_handle;
+}
+
+// Write to ADE7953 register (SPI owner only)
+static ade7953_error_t ade7953_spi_write_register(ade7953_handle_t *handle, uint16_t reg_addr, uint8_t n_bits, uint32_t data) {
+    if (n_bits != 8 && n_bits != 16 && n_bits != 24 && n_bits != 32) {
+        return ADE7953_ERROR_COMMUNICATION;
     }
     
-    uint8_t tx_data[8];  // Max 2 bytes address + 1 byte command + 4 bytes data + 1 byte padding
+    uint8_t *tx_data = handle->spi_tx_buffer;  // Slot 0, no batch is in flight between owner calls
     uint8_t tx_len = 3 + (n_bits / 8);  // Address (2) + command (1) + data
     
     // Prepare transmission data
@@ -112,25 +169,11 @@ ade7953_error_t ade7953_write_register(ade7953_handle_t *handle, uint16_t reg_ad
     tx_data[2] = WRITE_TRANSFER;          // Write command
     
     // Add data bytes (MSB first)
-    if (n_bits == 32) {
-        tx_data[3] = (data >> 24) & 0xFF;
-        tx_data[4] = (data >> 16) & 0xFF;
-        tx_data[5] = (data >> 8) & 0xFF;
-        tx_data[6] = data & 0xFF;
-    } else if (n_bits == 24) {
-        tx_data[3] = (data >> 16) & 0xFF;
-        tx_data[4] = (data >> 8) & 0xFF;
-        tx_data[5] = data & 0xFF;
-    } else if (n_bits == 16) {
-        tx_data[3] = (data >> 8) & 0xFF;
-        tx_data[4] = data & 0xFF;
-    } else if (n_bits == 8) {
-        tx_data[3] = data & 0xFF;
-    } else {
-        xSemaphoreGive(handle->spi_mutex);
-        return ADE7953_ERROR_COMMUNICATION;
+    for (int i = 0; i < n_bits / 8; i++) {
+        tx_data[3 + i] = (data >> (n_bits - 8 * (i + 1))) & 0xFF;
     }
     
+    // Writes are never padded: extra bytes would be clocked into the chip
     spi_transaction_t trans = {
         .length = tx_len * 8,  // Length in bits
         .tx_buffer = tx_data,
@@ -138,69 +181,124 @@ ade7953_error_t ade7953_write_register(ade7953_handle_t *handle, uint16_t reg_ad
     };
     
     esp_err_t ret = spi_device_transmit(handle->spi_handle, &trans);
-    xSemaphoreGive(handle->spi_mutex);
-    
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "SPI write failed: %s", esp_err_to_name(ret));
         return ADE7953_ERROR_SPI;
     }
     
-    ESP_LOGD(TAG, "Write register 0x%04X: 0x%08lX (%d bits)", reg_addr, data, n_bits);
+    BINLOG_D(TAG, "Write register 0x%04X: 0x%08lX (%d bits)", reg_addr, data, n_bits);
     return ADE7953_OK;
 }
 
-// Read from ADE7953 register
-ade7953_error_t ade7953_read_register(ade7953_handle_t *handle, uint16_t reg_addr, uint8_t n_bits, uint32_t *data) {
-    if (!handle || !handle->initialized || !data) {
-        return ADE7953_ERROR_INIT;
+// Read from ADE7953 register (SPI owner only)
+static ade7953_error_t ade7953_spi_read_register(ade7953_handle_t *handle, uint16_t reg_addr, uint8_t n_bits, uint32_t *data) {
+    const ade7953_reg_desc_t reg = { .address = reg_addr, .n_bits = n_bits };
+    ade7953_error_t ret = ade7953_read_registers(handle, &reg, 1, data, NULL);
+    if (ret != ADE7953_OK) {
+        return ret;
     }
     
-    // Take mutex with timeout
-    if (xSemaphoreTake(handle->spi_mutex, pdMS_TO_TICKS(100)) != pdTRUE) {
-        ESP_LOGE(TAG, "Failed to acquire SPI mutex");
-        return ADE7953_ERROR_TIMEOUT;
+    BINLOG_D(TAG, "Read register 0x%04X: 0x%08lX (%d bits)", reg_addr, *data, n_bits);
+    return ADE7953_OK;
+}
+
+// Queue a batch of register reads; they are clocked out by DMA while the caller continues
+ade7953_error_t ade7953_queue_registers(ade7953_handle_t *handle, const ade7953_reg_desc_t *regs, size_t n, int64_t *timestamp_us) {
+    if (!handle || !handle->initialized || !regs || n == 0 || n > ADE7953_MAX_BATCH_REGISTERS ||
+        !ade7953_is_spi_owner(handle)) {
+        return ADE7953_ERROR_INIT;
     }
     
-    uint8_t tx_data[3];
-    uint8_t rx_data[8];  // Max 4 bytes data + some padding
-    uint8_t data_bytes = n_bits / 8;
-    uint8_t total_len = 3 + data_bytes;  // Address (2) + command (1) + data
+    for (size_t i = 0; i < n; i++) {
+        if (regs[i].n_bits != 8 && regs[i].n_bits != 16 && regs[i].n_bits != 24 && regs[i].n_bits != 32) {
+            return ADE7953_ERROR_COMMUNICATION;
+        }
+    }
     
-    // Prepare command
-    tx_data[0] = (reg_addr >> 8) & 0xFF;  // Address high byte
-    tx_data[1] = reg_addr & 0xFF;         // Address low byte
-    tx_data[2] = READ_TRANSFER;           // Read command
+    // Keep the bus for the whole batch so that no other device can interleave
+    esp_err_t ret = spi_device_acquire_bus(handle->spi_handle, portMAX_DELAY);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to acquire SPI bus: %s", esp_err_to_name(ret));
+        return ADE7953_ERROR_SPI;
+    }
     
-    spi_transaction_t trans = {
-        .length = total_len * 8,  // Length in bits
-        .tx_buffer = tx_data,
-        .rx_buffer = rx_data,
-    };
+    if (timestamp_us) {
+        *timestamp_us = esp_timer_get_time();
+    }
     
-    esp_err_t ret = spi_device_transmit(handle->spi_handle, &trans);
-    xSemaphoreGive(handle->spi_mutex);
+    handle->spi_pending_count = 0;
+    for (size_t i = 0; i < n; i++) {
+        ade7953_prepare_read(handle, i, regs[i].address, regs[i].n_bits);
+        
+        // The queue is sized for a full batch, so this never blocks
+        ret = spi_device_queue_trans(handle->spi_handle, &handle->spi_transactions[i], 0);
+        if (ret != ESP_OK) {
+            break;
+        }
+        handle->spi_pending_count++;
+    }
     
     if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "SPI read failed: %s", esp_err_to_name(ret));
+        ESP_LOGE(TAG, "SPI queue failed: %s", esp_err_to_name(ret));
+        uint32_t discard[ADE7953_MAX_BATCH_REGISTERS];
+        ade7953_collect_registers(handle, discard);
         return ADE7953_ERROR_SPI;
     }
     
-    // Extract data from response (skip first 3 bytes which are echo of command)
-    *data = 0;
-    for (int i = 0; i < data_bytes; i++) {
-        *data = (*data << 8) | rx_data[3 + i];
+    return ADE7953_OK;
+}
+
+// Wait for a queued batch, extract the values and release the bus
+ade7953_error_t ade7953_collect_registers(ade7953_handle_t *handle, uint32_t *out) {
+    if (!handle || !out) {
+        return ADE7953_ERROR_INIT;
+    }
+    
+    esp_err_t ret = ESP_OK;
+    for (size_t i = 0; i < handle->spi_pending_count; i++) {
+        spi_transaction_t *done;
+        esp_err_t err = spi_device_get_trans_result(handle->spi_handle, &done, portMAX_DELAY);
+        if (err != ESP_OK) {
+            ret = err;
+            continue;
+        }
+        
+        // Transactions complete in queue order, so the slot index is the position in the batch
+        size_t slot = done - handle->spi_transactions;
+        out[slot] = ade7953_extract_read(handle, slot);
+    }
+    handle->spi_pending_count = 0;
+    
+    spi_device_release_bus(handle->spi_handle);
+    
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "SPI batch read failed: %s", esp_err_to_name(ret));
+        return ADE7953_ERROR_SPI;
     }
     
-    ESP_LOGD(TAG, "Read register 0x%04X: 0x%08lX (%d bits)", reg_addr, *data, n_bits);
     return ADE7953_OK;
 }
 
-// Write to ADE7953 register with communication verification
-ade7953_error_t ade7953_write_register_verified(ade7953_handle_t *handle, uint16_t reg_addr, uint8_t n_bits, uint32_t data) {
+// Read several registers back to back while holding the bus once
+ade7953_error_t ade7953_read_registers(ade7953_handle_t *handle, const ade7953_reg_desc_t *regs, size_t n, uint32_t *out, int64_t *timestamp_us) {
+    if (!out) {
+        return ADE7953_ERROR_INIT;
+    }
+    
+    ade7953_error_t ret = ade7953_queue_registers(handle, regs, n, timestamp_us);
+    if (ret != ADE7953_OK) {
+        return ret;
+    }
+    
+    return ade7953_collect_registers(handle, out);
+}
+
+// Write to ADE7953 register with communication verification (SPI owner only)
+static ade7953_error_t ade7953_spi_write_register_verified(ade7953_handle_t *handle, uint16_t reg_addr, uint8_t n_bits, uint32_t data) {
     ade7953_error_t ret;
     
     // Perform the write operation
-    ret = ade7953_write_register(handle, reg_addr, n_bits, data);
+    ret = ade7953_spi_write_register(handle, reg_addr, n_bits, data);
     if (ret != ADE7953_OK) {
         return ret;
     }
@@ -215,12 +313,12 @@ ade7953_error_t ade7953_write_register_verified(ade7953_handle_t *handle, uint16
     return ADE7953_OK;
 }
 
-// Read from ADE7953 register with communication verification
-ade7953_error_t ade7953_read_register_verified(ade7953_handle_t *handle, uint16_t reg_addr, uint8_t n_bits, uint32_t *data) {
+// Read from ADE7953 register with communication verification (SPI owner only)
+static ade7953_error_t ade7953_spi_read_register_verified(ade7953_handle_t *handle, uint16_t reg_addr, uint8_t n_bits, uint32_t *data) {
     ade7953_error_t ret;
     
     // Perform the read operation
-    ret = ade7953_read_register(handle, reg_addr, n_bits, data);
+    ret = ade7953_spi_read_register(handle, reg_addr, n_bits, data);
     if (ret != ADE7953_OK) {
         return ret;
     }
@@ -235,6 +333,196 @@ ade7953_error_t ade7953_read_register_verified(ade7953_handle_t *handle, uint16_
     return ADE7953_OK;
 }
 
+// Run one register command on the SPI device
+static ade7953_error_t ade7953_execute_command(ade7953_handle_t *handle, const ade7953_command_t *command, uint32_t *data) {
+    switch (command->type) {
+        case ADE7953_COMMAND_READ:
+            return ade7953_spi_read_register(handle, command->address, command->n_bits, data);
+        case ADE7953_COMMAND_WRITE:
+            return ade7953_spi_write_register(handle, command->address, command->n_bits, command->data);
+        case ADE7953_COMMAND_READ_VERIFIED:
+            return ade7953_spi_read_register_verified(handle, command->address, command->n_bits, data);
+        case ADE7953_COMMAND_WRITE_VERIFIED:
+            return ade7953_spi_write_register_verified(handle, command->address, command->n_bits, command->data);
+        default:
+            return ADE7953_ERROR_COMMUNICATION;
+    }
+}
+
+// Hand the result back to the requester, or free the slot if it already gave up
+static void ade7953_complete_command(ade7953_handle_t *handle, const ade7953_command_t *command, ade7953_error_t result, uint32_t data) {
+    ade7953_completion_t *completion = &handle->completions[command->completion];
+    completion->result = result;
+    completion->data = data;
+    
+    int expected = ADE7953_COMPLETION_PENDING;
+    if (atomic_compare_exchange_strong(&completion->state, &expected, ADE7953_COMPLETION_DONE)) {
+        xTaskNotifyIndexed(command->requester, ADE7953_COMMAND_NOTIFY_INDEX, 0, eNoAction);
+    } else {
+        atomic_store(&completion->state, ADE7953_COMPLETION_FREE);
+    }
+}
+
+// Run up to max queued commands (acquisition task, between samples)
+static void ade7953_service_commands(ade7953_handle_t *handle, size_t max) {
+    ade7953_command_t command;
+    
+    for (size_t i = 0; i < max && mpsc_ring_pop(&handle->command_ring, &command); i++) {
+        uint32_t data = 0;
+        ade7953_error_t result = ade7953_execute_command(handle, &command, &data);
+        ade7953_complete_command(handle, &command, result, data);
+        handle->command_count++;
+    }
+}
+
+// Queue a command for the acquisition task and block until it completes or times out
+static ade7953_error_t ade7953_submit_command(ade7953_handle_t *handle, ade7953_command_type_t type, uint16_t reg_addr, uint8_t n_bits, uint32_t *data) {
+    // Claim a completion slot, one per ring entry so a claimed slot always has room in the ring
+    size_t slot;
+    for (slot = 0; slot < ADE7953_COMMAND_QUEUE_SIZE; slot++) {
+        int expected = ADE7953_COMPLETION_FREE;
+        if (atomic_compare_exchange_strong(&handle->completions[slot].state, &expected, ADE7953_COMPLETION_PENDING)) {
+            break;
+        }
+    }
+    if (slot == ADE7953_COMMAND_QUEUE_SIZE) {
+        return ADE7953_ERROR_TIMEOUT;
+    }
+    ade7953_completion_t *completion = &handle->completions[slot];
+    
+    const ade7953_command_t command = {
+        .type = type,
+        .n_bits = n_bits,
+        .address = reg_addr,
+        .data = data ? *data : 0,
+        .requester = xTaskGetCurrentTaskHandle(),
+        .completion = slot,
+    };
+    
+    // Drop any stale completion notification before the command can finish
+    xTaskNotifyStateClearIndexed(NULL, ADE7953_COMMAND_NOTIFY_INDEX);
+    if (!mpsc_ring_push(&handle->command_ring, &command)) {
+        atomic_store(&completion->state, ADE7953_COMPLETION_FREE);
+        return ADE7953_ERROR_TIMEOUT;
+    }
+    
+    TickType_t start = xTaskGetTickCount();
+    TickType_t timeout = pdMS_TO_TICKS(ADE7953_COMMAND_TIMEOUT_MS);
+    while (atomic_load(&completion->state) == ADE7953_COMPLETION_PENDING) {
+        TickType_t elapsed = xTaskGetTickCount() - start;
+        if (elapsed >= timeout) {
+            break;
+        }
+        xTaskNotifyWaitIndexed(ADE7953_COMMAND_NOTIFY_INDEX, 0, 0, NULL, timeout - elapsed);
+    }
+    
+    // Give up, unless the command finished in the meantime
+    int expected = ADE7953_COMPLETION_PENDING;
+    if (atomic_compare_exchange_strong(&completion->state, &expected, ADE7953_COMPLETION_ABANDONED)) {
+        ESP_LOGW(TAG, "Register command 0x%04X timed out", reg_addr);
+        return ADE7953_ERROR_TIMEOUT;
+    }
+    
+    ade7953_error_t result = completion->result;
+    if (data && (type == ADE7953_COMMAND_READ || type == ADE7953_COMMAND_READ_VERIFIED)) {
+        *data = completion->data;
+    }
+    atomic_store(&completion->state, ADE7953_COMPLETION_FREE);
+    
+    return result;
+}
+
+// Write to ADE7953 register
+ade7953_error_t ade7953_write_register(ade7953_handle_t *handle, uint16_t reg_addr, uint8_t n_bits, uint32_t data) {
+    if (!handle || !handle->initialized) {
+        return ADE7953_ERROR_INIT;
+    }
+    
+    if (ade7953_is_spi_owner(handle)) {
+        return ade7953_spi_write_register(handle, reg_addr, n_bits, data);
+    }
+    return ade7953_submit_command(handle, ADE7953_COMMAND_WRITE, reg_addr, n_bits, &data);
+}
+
+// Read from ADE7953 register
+ade7953_error_t ade7953_read_register(ade7953_handle_t *handle, uint16_t reg_addr, uint8_t n_bits, uint32_t *data) {
+    if (!handle || !handle->initialized || !data) {
+        return ADE7953_ERROR_INIT;
+    }
+    
+    if (ade7953_is_spi_owner(handle)) {
+        return ade7953_spi_read_register(handle, reg_addr, n_bits, data);
+    }
+    return ade7953_submit_command(handle, ADE7953_COMMAND_READ, reg_addr, n_bits, data);
+}
+
+// Write to ADE7953 register with communication verification, the check runs as part of the same command
+ade7953_error_t ade7953_write_register_verified(ade7953_handle_t *handle, uint16_t reg_addr, uint8_t n_bits, uint32_t data) {
+    if (!handle || !handle->initialized) {
+        return ADE7953_ERROR_INIT;
+    }
+    
+    if (ade7953_is_spi_owner(handle)) {
+        return ade7953_spi_write_register_verified(handle, reg_addr, n_bits, data);
+    }
+    return ade7953_submit_command(handle, ADE7953_COMMAND_WRITE_VERIFIED, reg_addr, n_bits, &data);
+}
+
+// Read from ADE7953 register with communication verification, the check runs as part of the same command
+ade7953_error_t ade7953_read_register_verified(ade7953_handle_t *handle, uint16_t reg_addr, uint8_t n_bits, uint32_t *data) {
+    if (!handle || !handle->initialized || !data) {
+        return ADE7953_ERROR_INIT;
+    }
+    
+    if (ade7953_is_spi_owner(handle)) {
+        return ade7953_spi_read_register_verified(handle, reg_addr, n_bits, data);
+    }
+    return ade7953_submit_command(handle, ADE7953_COMMAND_READ_VERIFIED, reg_addr, n_bits, data);
+}
+
+// Any register in the width's address page, except the status registers cleared on read: reading one
+// from outside would clear the RESET, ZXV and WSMP flags before the acquisition task sees them
+bool ade7953_register_readable(uint16_t reg_addr, uint8_t n_bits) {
+    static const uint16_t read_to_clear_regs[] = {
+        RSTIRQSTATA_32,
+        RSTIRQSTATA_32 - ADE7953_REG_24_TO_32,
+        RSTIRQSTATB_32,
+        RSTIRQSTATB_32 - ADE7953_REG_24_TO_32,
+    };
+    
+    if ((n_bits != 8 && n_bits != 16 && n_bits != 24 && n_bits != 32) || reg_addr >> 8 != n_bits / 8 - 1) {
+        return false;
+    }
+    for (size_t i = 0; i < sizeof(read_to_clear_regs) / sizeof(read_to_clear_regs[0]); i++) {
+        if (read_to_clear_regs[i] == reg_addr) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Only these may be written from outside the driver. Configuration, interrupt and optimum-setting
+// registers stay with the driver, the acquisition depends on them.
+bool ade7953_register_writable(uint16_t reg_addr, uint8_t n_bits) {
+    static const ade7953_reg_desc_t writable_regs[] = {
+        { .address = SAGCYC_8, .n_bits = 8 },
+        { .address = PGA_V_8, .n_bits = 8 },
+        { .address = ZXTOUT_16, .n_bits = 16 },
+        { .address = SAGLVL_32, .n_bits = 32 },
+        { .address = AP_NOLOAD_32_REGISTER, .n_bits = 32 },
+        { .address = OVLVL_32, .n_bits = 32 },
+        { .address = AVGAIN_32, .n_bits = 32 },
+        { .address = VRMSOS_32, .n_bits = 32 },
+    };
+    
+    for (size_t i = 0; i < sizeof(writable_regs) / sizeof(writable_regs[0]); i++) {
+        if (writable_regs[i].address == reg_addr && writable_regs[i].n_bits == n_bits) {
+            return true;
+        }
+    }
+    return false;
+}
+
 // Configure ADE7953 with default settings
 static ade7953_error_t ade7953_configure_device(ade7953_handle_t *handle) {
     ade7953_error_t ret;
@@ -259,6 +547,70 @@ static ade7953_error_t ade7953_configure_device(ade7953_handle_t *handle) {
     return ADE7953_OK;
 }
 
+// Calibration sets. Measurements only carry the ID, so correcting an entry here (or at ingest) re-scales
+// everything taken under it; add a new entry with a new ID for a changed voltage divider.
+static const ade7953_calibration_t ade7953_calibrations[] = {
+    { .id = ADE7953_DEFAULT_CALIBRATION_ID, .period_clock_hz = GRID_FREQUENCY_CONVERSION_FACTOR, .volts_per_lsb = VOLTAGE_CONVERSION_FACTOR },
+};
+
+// Look up a calibration set, NULL if unknown
+const ade7953_calibration_t *ade7953_get_calibration(uint8_t calibration_id) {
+    for (size_t i = 0; i < sizeof(ade7953_calibrations) / sizeof(ade7953_calibrations[0]); i++) {
+        if (ade7953_calibrations[i].id == calibration_id) {
+            return &ade7953_calibrations[i];
+        }
+    }
+    return NULL;
+}
+
+// Select the calibration set used for new samples
+ade7953_error_t ade7953_set_calibration(ade7953_handle_t *handle, uint8_t calibration_id) {
+    const ade7953_calibration_t *calibration = ade7953_get_calibration(calibration_id);
+    if (!handle || !calibration) {
+        return ADE7953_ERROR_INIT;
+    }
+    
+    handle->calibration = calibration;
+    ESP_LOGI(TAG, "Calibration set %u selected", calibration_id);
+    return ADE7953_OK;
+}
+
+// Convert a PERIOD register value to frequency
+static ade7953_error_t ade7953_period_to_frequency(const ade7953_calibration_t *calibration, uint32_t period_reg, float *frequency) {
+    if (period_reg == 0) {
+        *frequency = 0.0f;  // Invalid reading
+        return ADE7953_ERROR_COMMUNICATION;
+    }
+    
+    *frequency = calibration->period_clock_hz / (float)period_reg;
+    return ADE7953_OK;
+}
+
+// Convert a VRMS register value to volts
+static float ade7953_vrms_to_voltage(const ade7953_calibration_t *calibration, uint32_t vrms_reg) {
+    return (float)vrms_reg * calibration->volts_per_lsb;
+}
+
+// Frequency of a queued measurement in Hz, 0 if its code or calibration set is invalid
+float ade7953_measurement_frequency(const measurement_t *measurement) {
+    if (measurement->frequency_unit == MEASUREMENT_FREQUENCY_UNIT_MICROHERTZ) {
+        return (float)(measurement->frequency_code / 1e6);
+    }
+    
+    const ade7953_calibration_t *calibration = ade7953_get_calibration(measurement->calibration_id);
+    float frequency = 0.0f;
+    if (calibration) {
+        ade7953_period_to_frequency(calibration, measurement->frequency_code, &frequency);
+    }
+    return frequency;
+}
+
+// RMS voltage of a queued measurement in V, 0 if its calibration set is unknown
+float ade7953_measurement_voltage(const measurement_t *measurement) {
+    const ade7953_calibration_t *calibration = ade7953_get_calibration(measurement->calibration_id);
+    return calibration ? ade7953_vrms_to_voltage(calibration, measurement->voltage_code) : 0.0f;
+}
+
 // Read grid frequency
 ade7953_error_t ade7953_read_frequency(ade7953_handle_t *handle, float *frequency) {
     if (!handle || !frequency) {
@@ -271,13 +623,7 @@ ade7953_error_t ade7953_read_frequency(ade7953_handle_t *handle, float *frequenc
         return ret;
     }
     
-    if (period_reg == 0) {
-        *frequency = 0.0f;  // Invalid reading
-        return ADE7953_ERROR_COMMUNICATION;
-    }
-    
-    *frequency = GRID_FREQUENCY_CONVERSION_FACTOR / (float)period_reg;
-    return ADE7953_OK;
+    return ade7953_period_to_frequency(handle->calibration, period_reg, frequency);
 }
 
 // Read voltage RMS
@@ -292,63 +638,608 @@ ade7953_error_t ade7953_read_voltage(ade7953_handle_t *handle, float *voltage) {
         return ret;
     }
     
-    // This conversion factor may need calibration based on your hardware
-    // For now, using a basic conversion - you'll need to calibrate this
-    *voltage = (float)vrms_reg * VOLTAGE_CONVERSION_FACTOR;  // Placeholder conversion
+    *voltage = ade7953_vrms_to_voltage(handle->calibration, vrms_reg);
     return ADE7953_OK;
 }
 
-// Background task for continuous readings
-static void ade7953_task(void *pvParameters) {
-    ade7953_handle_t *handle = (ade7953_handle_t *)pvParameters;
+// Measure per-sample SPI time of separate reads versus a batched read
+void ade7953_benchmark_spi(ade7953_handle_t *handle, uint32_t iterations) {
+    if (!handle || !handle->initialized || iterations == 0) {
+        return;
+    }
     
-    ESP_LOGI(TAG, "ADE7953 task started");
+    const ade7953_reg_desc_t sample_regs[] = {
+        { .address = PERIOD_16, .n_bits = 16 },
+        { .address = VRMS_32, .n_bits = 32 },
+    };
+    uint32_t values[2];
+    float frequency, voltage;
+    
+    int64_t start_us = esp_timer_get_time();
+    for (uint32_t i = 0; i < iterations; i++) {
+        ade7953_read_frequency(handle, &frequency);
+        ade7953_read_voltage(handle, &voltage);
+    }
+    int64_t separate_us = esp_timer_get_time() - start_us;
+    
+    start_us = esp_timer_get_time();
+    for (uint32_t i = 0; i < iterations; i++) {
+        ade7953_read_registers(handle, sample_regs, 2, values, NULL);
+    }
+    int64_t batched_us = esp_timer_get_time() - start_us;
+    
+    ESP_LOGI(TAG, "SPI benchmark (%lu samples): separate reads %.1f us/sample, batched read %.1f us/sample",
+             iterations, (double)separate_us / iterations, (double)batched_us / iterations);
+}
+
+// Validate a sample and hand its raw codes to the publisher, the converted values only feed the on-device detectors
+// A period_reg of 0 means the frequency comes from the waveform estimator
+static void ade7953_process_sample(ade7953_handle_t *handle, const ade7953_calibration_t *calibration,
+                                   float frequency, bool frequency_valid, float voltage, bool voltage_valid,
+                                   uint32_t period_reg, uint32_t vrms_reg, int64_t timestamp_us) {
+    if (frequency_valid) {
+        handle->grid_frequency = frequency;
+    }
+    if (voltage_valid) {
+        handle->voltage_rms = voltage;
+    }
+    
+    handle->last_reading_ms = xTaskGetTickCount() * portTICK_PERIOD_MS;
+    
+    // Numbered before validation, so a rejected sample leaves a gap like any other loss
+    uint32_t sequence = handle->sample_sequence++;
+    
+    // Event detection sees every valid sample, including sags below the publishing sanity range
+    if (frequency_valid && voltage_valid && handle->events && frequency > 0.0f) {
+        handle->rocof = grid_events_push(handle->events, timestamp_us, frequency, voltage);
+    }
+    
+    // Queue measurement to MQTT if both readings are valid and measurement ring is set
+    if (!handle->measurement_ring) {
+        return;
+    }
+    if (frequency_valid && voltage_valid) {
+        // Check if readings are within reasonable ranges before queuing
+        if (frequency > 45.0f && frequency < 65.0f && voltage > 50.0f && voltage < 300.0f) {
+            measurement_t measurement = {
+                .timestamp_us = timestamp_us,
+                .sequence = sequence,
+                .frequency_code = period_reg != 0 ? period_reg : (uint32_t)llround((double)frequency * 1e6),
+                .voltage_code = vrms_reg,
+                .frequency_unit = period_reg != 0 ? MEASUREMENT_FREQUENCY_UNIT_PERIOD : MEASUREMENT_FREQUENCY_UNIT_MICROHERTZ,
+                .calibration_id = calibration->id,
+            };
+            
+            // Non-blocking, a full ring counts the drop itself
+            spsc_ring_push(handle->measurement_ring, &measurement);
+            return;
+        }
+    }
+    handle->plausibility_reject_count++;
+}
+
+// Get current wall-clock time in microseconds since Unix epoch
+static int64_t ade7953_get_wall_time_us(void) {
+    struct timeval tv_now;
+    gettimeofday(&tv_now, NULL);
+    return (int64_t)tv_now.tv_sec * 1000000L + (int64_t)tv_now.tv_usec;
+}
+
+// IRQ pin ISR - the ADE7953 pulls the pin low once per line cycle (positive zero crossing) or once per waveform sample
+static void IRAM_ATTR ade7953_irq_isr_handler(void *arg) {
+    ade7953_handle_t *handle = (ade7953_handle_t *)arg;
+    BaseType_t higher_priority_task_woken = pdFALSE;
+    
+    handle->trigger_timestamp_us = esp_timer_get_time();
+    if (handle->task_handle) {
+        vTaskNotifyGiveFromISR(handle->task_handle, &higher_priority_task_woken);
+    }
+    
+    if (higher_priority_task_woken) {
+        portYIELD_FROM_ISR();
+    }
+}
+
+// Enable the given chip interrupts (zero crossing or waveform sample) and attach the GPIO ISR
+static ade7953_error_t ade7953_arm_irq(ade7953_handle_t *handle, uint32_t irq_mask) {
+    uint32_t config_reg;
+    uint32_t irq_status;
+    ade7953_error_t ret;
+    
+    // Only trigger on the positive-going zero crossing so that there is exactly one IRQ per line cycle
+    ret = ade7953_read_register(handle, CONFIG_16, 16, &config_reg);
+    if (ret != ADE7953_OK) {
+        return ret;
+    }
+    config_reg = (config_reg & ~CONFIG_ZX_EDGE_MASK) | CONFIG_ZX_EDGE_POSITIVE;
+    ret = ade7953_write_register_verified(handle, CONFIG_16, 16, config_reg);
+    if (ret != ADE7953_OK) {
+        ESP_LOGE(TAG, "Failed to set zero-crossing edge");
+        return ret;
+    }
+    
+    ret = ade7953_write_register_verified(handle, IRQENA_32, 32, irq_mask);
+    if (ret != ADE7953_OK) {
+        ESP_LOGE(TAG, "Failed to enable interrupts 0x%08lX", irq_mask);
+        return ret;
+    }
+    
+    esp_err_t err = gpio_install_isr_service(0);
+    if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) {  // Already installed is fine
+        ESP_LOGE(TAG, "Failed to install GPIO ISR service: %s", esp_err_to_name(err));
+        return ADE7953_ERROR_INIT;
+    }
+    
+    gpio_set_intr_type(ADE7953_INTERRUPT_PIN, GPIO_INTR_NEGEDGE);
+    err = gpio_isr_handler_add(ADE7953_INTERRUPT_PIN, ade7953_irq_isr_handler, handle);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to add IRQ handler: %s", esp_err_to_name(err));
+        return ADE7953_ERROR_INIT;
+    }
+    
+    // Clear pending flags (the reset flag holds the IRQ pin low after startup)
+    return ade7953_read_register(handle, RSTIRQSTATA_32, 32, &irq_status);
+}
+
+// Detach the GPIO ISR and disable the chip interrupts
+static void ade7953_disarm_irq(ade7953_handle_t *handle) {
+    uint32_t irq_status;
+    
+    gpio_isr_handler_remove(ADE7953_INTERRUPT_PIN);
+    gpio_set_intr_type(ADE7953_INTERRUPT_PIN, GPIO_INTR_DISABLE);
+    ade7953_write_register(handle, IRQENA_32, 32, 0);
+    ade7953_read_register(handle, RSTIRQSTATA_32, 32, &irq_status);
+}
+
+// Read a sample batch, converting the trigger time to wall-clock time while the transfer is in flight
+static ade7953_error_t ade7953_read_sample_batch(ade7953_handle_t *handle, const ade7953_reg_desc_t *regs, size_t n, uint32_t *values, int64_t trigger_us, int64_t *timestamp_us) {
+    ade7953_error_t ret = ade7953_queue_registers(handle, regs, n, NULL);
+    
+    *timestamp_us = ade7953_get_wall_time_us() - (esp_timer_get_time() - trigger_us);
+    
+    if (ret != ADE7953_OK) {
+        return ret;
+    }
+    return ade7953_collect_registers(handle, values);
+}
+
+// Convert raw PERIOD and VRMS readings and queue the sample
+static void ade7953_acquire_sample(ade7953_handle_t *handle, uint32_t period_reg, uint32_t vrms_reg, bool read_ok, int64_t timestamp_us) {
+    const ade7953_calibration_t *calibration = handle->calibration;
+    float frequency = 0.0f, voltage = 0.0f;
+    bool frequency_valid = false, voltage_valid = false;
+    
+    if (read_ok) {
+        frequency_valid = ade7953_period_to_frequency(calibration, period_reg, &frequency) == ADE7953_OK;
+        voltage = ade7953_vrms_to_voltage(calibration, vrms_reg);
+        voltage_valid = true;
+    }
+    
+    ade7953_process_sample(handle, calibration, frequency, frequency_valid, voltage, voltage_valid, period_reg, vrms_reg, timestamp_us);
+}
+
+// Sample timer callback - fires on absolute deadlines (start + k * period), so it never drifts
+static void ade7953_sample_timer_callback(void *arg) {
+    ade7953_handle_t *handle = (ade7953_handle_t *)arg;
+    
+    handle->trigger_timestamp_us = esp_timer_get_time();
+    if (handle->task_handle) {
+        xTaskNotifyGive(handle->task_handle);
+    }
+}
+
+// Start the periodic sample timer
+static ade7953_error_t ade7953_start_sample_timer(ade7953_handle_t *handle) {
+    const esp_timer_create_args_t timer_args = {
+        .callback = ade7953_sample_timer_callback,
+        .arg = handle,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "ade7953_sample",
+        .skip_unhandled_events = true,  // Late callbacks do not burst; the skipped deadlines are counted instead
+    };
+    
+    esp_err_t err = esp_timer_create(&timer_args, &handle->sample_timer);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to create sample timer: %s", esp_err_to_name(err));
+        return ADE7953_ERROR_INIT;
+    }
+    
+    memset(&handle->timing_stats, 0, sizeof(ade7953_timing_stats_t));
+    handle->last_deadline_index = 0;
+    handle->schedule_start_us = esp_timer_get_time();
+    
+    err = esp_timer_start_periodic(handle->sample_timer, handle->sample_period_us);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to start sample timer: %s", esp_err_to_name(err));
+        esp_timer_delete(handle->sample_timer);
+        handle->sample_timer = NULL;
+        return ADE7953_ERROR_INIT;
+    }
+    
+    return ADE7953_OK;
+}
+
+// Stop and delete the periodic sample timer
+static void ade7953_stop_sample_timer(ade7953_handle_t *handle) {
+    if (handle->sample_timer) {
+        esp_timer_stop(handle->sample_timer);
+        esp_timer_delete(handle->sample_timer);
+        handle->sample_timer = NULL;
+    }
+}
+
+// Update jitter and skip statistics for a timer wake-up, returns the deadline it belongs to
+static int64_t ade7953_account_deadline(ade7953_handle_t *handle, int64_t wake_us) {
+    ade7953_timing_stats_t *stats = &handle->timing_stats;
+    int64_t period_us = handle->sample_period_us;
+    
+    // Deadline k is at schedule_start + k * period; pick the latest one not after the wake-up
+    int64_t deadline_index = (wake_us - handle->schedule_start_us) / period_us;
+    int64_t deadline_us = handle->schedule_start_us + deadline_index * period_us;
+    
+    if (deadline_index > handle->last_deadline_index + 1) {
+        stats->skipped_count += (uint32_t)(deadline_index - handle->last_deadline_index - 1);
+    }
+    handle->last_deadline_index = deadline_index;
+    
+    stats->sample_count++;
+    stats->last_jitter_us = (int32_t)(wake_us - deadline_us);
+    if (stats->last_jitter_us > stats->max_jitter_us) {
+        stats->max_jitter_us = stats->last_jitter_us;
+    }
+    
+    return deadline_us;
+}
+
+// Polling acquisition - one sample per hardware timer deadline
+static void ade7953_polling_loop(ade7953_handle_t *handle) {
+    static const ade7953_reg_desc_t sample_regs[] = {
+        { .address = PERIOD_16, .n_bits = 16 },
+        { .address = VRMS_32, .n_bits = 32 },
+    };
+    uint32_t values[2];
+    
+    if (ade7953_start_sample_timer(handle) != ADE7953_OK) {
+        ESP_LOGE(TAG, "Sample timer unavailable, acquisition stopped");
+        return;
+    }
     
     while (true) {
-        float frequency, voltage;
-        bool frequency_valid = false;
-        bool voltage_valid = false;
+        if (ulTaskNotifyTake(pdTRUE, portMAX_DELAY) == 0) {
+            continue;
+        }
+        if (handle->stop_requested) {
+            break;
+        }
+        
+        int64_t wake_us = handle->trigger_timestamp_us;
+        int64_t deadline_us = ade7953_account_deadline(handle, wake_us);
+        int64_t timestamp_us;
         
-        // Read frequency
-        if (ade7953_read_frequency(handle, &frequency) == ADE7953_OK) {
-            handle->grid_frequency = frequency;
-            frequency_valid = true;
+        bool read_ok = ade7953_read_sample_batch(handle, sample_regs, 2, values, wake_us, &timestamp_us) == ADE7953_OK;
+        ade7953_acquire_sample(handle, values[0], values[1], read_ok, timestamp_us);
+        ade7953_service_commands(handle, ADE7953_COMMAND_QUEUE_SIZE);
+        
+        // The sample must be done before the next deadline, otherwise that deadline is lost
+        int64_t overrun_us = esp_timer_get_time() - (deadline_us + handle->sample_period_us);
+        if (overrun_us > 0) {
+            handle->timing_stats.overrun_count++;
+            handle->timing_stats.last_overrun_us = (int32_t)overrun_us;
         }
+    }
+    
+    ade7953_stop_sample_timer(handle);
+}
+
+// Interrupt-driven acquisition - exactly one sample per line cycle
+// Returns if the IRQ line appears to be dead, so the caller can fall back to polling, or on a stop request
+static void ade7953_interrupt_loop(ade7953_handle_t *handle) {
+    // Reading the status also releases the IRQ pin for the next cycle; the sample registers ride in the same batch
+    static const ade7953_reg_desc_t cycle_regs[] = {
+        { .address = RSTIRQSTATA_32, .n_bits = 32 },
+        { .address = PERIOD_16, .n_bits = 16 },
+        { .address = VRMS_32, .n_bits = 32 },
+    };
+    uint32_t values[3];
+    uint32_t consecutive_timeouts = 0;
+    
+    while (consecutive_timeouts < ADE7953_IRQ_MAX_CONSECUTIVE_TIMEOUTS) {
+        if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(ADE7953_IRQ_TIMEOUT_MS)) == 0) {
+            consecutive_timeouts++;
+            handle->irq_timeout_count++;
+            
+            // Release the IRQ pin in case an unexpected flag is holding it low
+            uint32_t irq_status;
+            ade7953_read_register(handle, RSTIRQSTATA_32, 32, &irq_status);
+            ade7953_service_commands(handle, ADE7953_COMMAND_QUEUE_SIZE);
+            continue;
+        }
+        if (handle->stop_requested) {
+            break;
+        }
+        consecutive_timeouts = 0;
+        
+        int64_t irq_timestamp_us = handle->trigger_timestamp_us;
+        int64_t timestamp_us;
         
-        // Read voltage
-        if (ade7953_read_voltage(handle, &voltage) == ADE7953_OK) {
-            handle->voltage_rms = voltage;
-            voltage_valid = true;
+        if (ade7953_read_sample_batch(handle, cycle_regs, 3, values, irq_timestamp_us, &timestamp_us) != ADE7953_OK) {
+            continue;
+        }
+        uint32_t irq_status = values[0];
+        
+        if (irq_status & IRQ_RESET_BIT) {
+            ESP_LOGW(TAG, "ADE7953 reset detected, reconfiguring");
+            if (ade7953_configure_device(handle) != ADE7953_OK || ade7953_arm_irq(handle, IRQ_ZXV_BIT) != ADE7953_OK) {
+                ESP_LOGE(TAG, "Failed to reconfigure ADE7953 after reset");
+            }
+            continue;
         }
         
-        handle->last_reading_ms = xTaskGetTickCount() * portTICK_PERIOD_MS;
+        if (irq_status & IRQ_ZXV_BIT) {
+            ade7953_acquire_sample(handle, values[1], values[2], true, timestamp_us);
+        }
         
-        // Queue measurement to MQTT if both readings are valid and measurement queue is set
-        if (frequency_valid && voltage_valid && handle->measurement_queue) {
-            // Check if readings are within reasonable ranges before queuing
-            if (frequency > 45.0f && frequency < 65.0f && voltage > 50.0f && voltage < 300.0f) {
-                
-                struct timeval tv_now;
-                gettimeofday(&tv_now, NULL);
-                int64_t time_us = (int64_t)tv_now.tv_sec * 1000000L + (int64_t)tv_now.tv_usec;
-
-                measurement_t measurement = {
-                    .timestamp_us = time_us,
-                    .frequency = frequency,
-                    .voltage = voltage
-                };
-                
-                // Queue measurement (non-blocking)
-                if (xQueueSend(handle->measurement_queue, &measurement, 0) != pdTRUE) {
-                    // Queue is full, which is expected under high load
-                    // Don't log every failure to avoid spam
-                }
+        // Register commands run in the slack of the line cycle
+        ade7953_service_commands(handle, ADE7953_COMMAND_QUEUE_SIZE);
+    }
+    
+    if (!handle->stop_requested) {
+        ESP_LOGW(TAG, "No zero-crossing IRQ for %d ms, falling back to polling acquisition", 
+                 ADE7953_IRQ_TIMEOUT_MS * ADE7953_IRQ_MAX_CONSECUTIVE_TIMEOUTS);
+    }
+    ade7953_disarm_irq(handle);
+}
+
+// Read a few registers with polling transactions.
+// At the waveform rate the interrupt and context switch of a queued transaction cost more than the transfer itself.
+static ade7953_error_t ade7953_read_registers_polling(ade7953_handle_t *handle, const ade7953_reg_desc_t *regs, size_t n, uint32_t *out) {
+    esp_err_t ret = spi_device_acquire_bus(handle->spi_handle, portMAX_DELAY);
+    if (ret != ESP_OK) {
+        return ADE7953_ERROR_SPI;
+    }
+    
+    for (size_t i = 0; i < n; i++) {
+        ade7953_prepare_read(handle, i, regs[i].address, regs[i].n_bits);
+        ret = spi_device_polling_transmit(handle->spi_handle, &handle->spi_transactions[i]);
+        if (ret != ESP_OK) {
+            break;
+        }
+        out[i] = ade7953_extract_read(handle, i);
+    }
+    
+    spi_device_release_bus(handle->spi_handle);
+    
+    return ret == ESP_OK ? ADE7953_OK : ADE7953_ERROR_SPI;
+}
+
+// C37.118 STAT word from the clock state and the grid event detector
+static uint16_t ade7953_synchrophasor_stat(ade7953_handle_t *handle) {
+    uint16_t stat;
+    
+    if (handle->time_synchronized) {
+        stat = C37118_STAT_TIME_QUALITY_10MS << C37118_STAT_TIME_QUALITY_SHIFT;
+    } else {
+        stat = C37118_STAT_SYNC_ERROR | (C37118_STAT_TIME_QUALITY_UNKNOWN << C37118_STAT_TIME_QUALITY_SHIFT);
+    }
+    
+    // Flag reports inside a grid event capture, with the most specific trigger reason
+    if (handle->events && handle->events->triggered) {
+        uint32_t causes = handle->events->pending_causes;
+        stat |= C37118_STAT_TRIGGER;
+        if (causes & GRID_EVENT_CAUSE_ROCOF) {
+            stat |= C37118_TRIGGER_DFDT;
+        } else if (causes & GRID_EVENT_CAUSE_FREQUENCY) {
+            stat |= C37118_TRIGGER_FREQUENCY;
+        } else if (causes & GRID_EVENT_CAUSE_SAG) {
+            stat |= C37118_TRIGGER_MAGNITUDE_LOW;
+        } else if (causes & GRID_EVENT_CAUSE_SWELL) {
+            stat |= C37118_TRIGGER_MAGNITUDE_HIGH;
+        }
+    }
+    
+    return stat;
+}
+
+// Waveform acquisition - one voltage sample per WSMP IRQ, one frequency estimate per line cycle
+// Returns if the IRQ line appears to be dead, so the caller can fall back to polling, or on a stop request
+static void ade7953_waveform_loop(ade7953_handle_t *handle) {
+    // Reading the status releases the IRQ pin so the next sample can raise it again
+    static const ade7953_reg_desc_t sample_regs[] = {
+        { .address = RSTIRQSTATA_32, .n_bits = 32 },
+        { .address = V_32, .n_bits = 32 },
+    };
+    static const ade7953_reg_desc_t cycle_regs[] = {
+        { .address = VRMS_32, .n_bits = 32 },
+    };
+    uint32_t values[2];
+    uint32_t vrms_reg;
+    waveform_cycle_t cycle;
+    int64_t last_sample_us = 0;
+    uint32_t consecutive_timeouts = 0;
+    
+    while (consecutive_timeouts < ADE7953_IRQ_MAX_CONSECUTIVE_TIMEOUTS) {
+        if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(ADE7953_IRQ_TIMEOUT_MS)) == 0) {
+            consecutive_timeouts++;
+            handle->irq_timeout_count++;
+            
+            // Release the IRQ pin in case an unexpected flag is holding it low
+            uint32_t irq_status;
+            ade7953_read_register(handle, RSTIRQSTATA_32, 32, &irq_status);
+            ade7953_service_commands(handle, ADE7953_COMMAND_QUEUE_SIZE);
+            waveform_reset(handle->waveform);
+            last_sample_us = 0;
+            continue;
+        }
+        if (handle->stop_requested) {
+            break;
+        }
+        consecutive_timeouts = 0;
+        
+        int64_t sample_us = handle->trigger_timestamp_us;
+        if (ade7953_read_registers_polling(handle, sample_regs, 2, values) != ADE7953_OK) {
+            waveform_reset(handle->waveform);
+            last_sample_us = 0;
+            continue;
+        }
+        uint32_t irq_status = values[0];
+        
+        if (irq_status & IRQ_RESET_BIT) {
+            ESP_LOGW(TAG, "ADE7953 reset detected, reconfiguring");
+            if (ade7953_configure_device(handle) != ADE7953_OK || ade7953_arm_irq(handle, IRQ_WSMP_BIT) != ADE7953_OK) {
+                ESP_LOGE(TAG, "Failed to reconfigure ADE7953 after reset");
             }
+            waveform_reset(handle->waveform);
+            last_sample_us = 0;
+            continue;
+        }
+        
+        if (!(irq_status & IRQ_WSMP_BIT)) {
+            continue;
         }
         
-        // Wait for next sample (20ms for 50Hz measurements)
-        vTaskDelay(pdMS_TO_TICKS(ADE7953_SAMPLE_INTERVAL_MS));
+        // The pin only falls again after the flag is cleared, so a late read silently drops samples.
+        // Spot that from the edge spacing and restart the estimator rather than splice the waveform.
+        if (last_sample_us != 0 && sample_us - last_sample_us > ADE7953_WAVEFORM_GAP_US) {
+            handle->waveform_gap_count++;
+            waveform_reset(handle->waveform);
+        }
+        last_sample_us = sample_us;
+        
+        bool cycle_complete = waveform_push_sample(handle->waveform, (int32_t)values[1], &cycle);
+        
+        // At most one register command per sample, a plain access fits in the sample budget
+        ade7953_service_commands(handle, 1);
+        
+        // Synchrophasor reports fall on UTC instants, independent of the cycle boundaries
+        if (handle->synchrophasor && handle->wall_offset_us != 0) {
+            int64_t sample_wall_us = sample_us + handle->wall_offset_us;
+            if (synchrophasor_due(handle->synchrophasor, sample_wall_us)) {
+                synchrophasor_submit(handle->synchrophasor, handle->waveform, sample_wall_us,
+                                     handle->grid_frequency, handle->rocof, handle->voltage_rms,
+                                     ade7953_synchrophasor_stat(handle),
+                                     handle->time_synchronized ? C37118_TIME_QUALITY_10MS : C37118_TIME_QUALITY_FAULT);
+            }
+        }
+        
+        if (!cycle_complete) {
+            continue;
+        }
+        
+        // One cycle completed: timestamp it at the interpolated zero crossing
+        handle->wall_offset_us = ade7953_get_wall_time_us() - esp_timer_get_time();
+        int64_t crossing_us = sample_us - (int64_t)(cycle.samples_since_crossing * WAVEFORM_SAMPLE_PERIOD_US);
+        int64_t timestamp_us = crossing_us + handle->wall_offset_us;
+        
+        bool voltage_valid = ade7953_read_registers_polling(handle, cycle_regs, 1, &vrms_reg) == ADE7953_OK;
+        const ade7953_calibration_t *calibration = handle->calibration;
+        float voltage = voltage_valid ? ade7953_vrms_to_voltage(calibration, vrms_reg) : 0.0f;
+        
+        ade7953_process_sample(handle, calibration, cycle.frequency, true, voltage, voltage_valid, 0, vrms_reg, timestamp_us);
+        
+        // Hand a window to the harmonic analysis every N cycles, it runs in its own lower priority task
+        if (handle->harmonics && handle->harmonics_interval_cycles > 0 && voltage_valid &&
+            ++handle->harmonics_cycle_count >= handle->harmonics_interval_cycles) {
+            handle->harmonics_cycle_count = 0;
+            harmonics_submit(handle->harmonics, handle->waveform, cycle.frequency, voltage, timestamp_us);
+        }
+    }
+    
+    if (!handle->stop_requested) {
+        ESP_LOGW(TAG, "No waveform IRQ for %d ms, falling back to polling acquisition", 
+                 ADE7953_IRQ_TIMEOUT_MS * ADE7953_IRQ_MAX_CONSECUTIVE_TIMEOUTS);
+    }
+    ade7953_disarm_irq(handle);
+}
+
+// Allocate the waveform estimator and arm the WSMP interrupt
+static ade7953_error_t ade7953_start_waveform(ade7953_handle_t *handle) {
+    if (!handle->waveform) {
+        handle->waveform = heap_caps_malloc(sizeof(waveform_estimator_t), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        if (!handle->waveform) {
+            ESP_LOGE(TAG, "Failed to allocate waveform estimator");
+            return ADE7953_ERROR_INIT;
+        }
+    }
+    waveform_init(handle->waveform, handle->nominal_frequency);
+    handle->waveform_gap_count = 0;
+    
+    if (dsp_init() != DSP_OK) {
+        return ADE7953_ERROR_INIT;
+    }
+    
+    // Harmonic analysis is optional, acquisition carries on without it
+    if (!handle->harmonics) {
+        handle->harmonics = heap_caps_calloc(1, sizeof(harmonics_analyzer_t), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        if (handle->harmonics) {
+            handle->harmonics->output_queue = handle->harmonics_queue;
+            if (harmonics_init(handle->harmonics) != HARMONICS_OK) {
+                ESP_LOGW(TAG, "Harmonic analysis unavailable");
+                heap_caps_free(handle->harmonics);
+                handle->harmonics = NULL;
+            }
+        }
+    }
+    handle->harmonics_cycle_count = 0;
+    
+    // Synchrophasor estimation is optional as well
+    if (!handle->synchrophasor) {
+        handle->synchrophasor = heap_caps_calloc(1, sizeof(synchrophasor_t), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        if (handle->synchrophasor) {
+            handle->synchrophasor->output_queue = handle->synchrophasor_queue;
+            if (synchrophasor_init(handle->synchrophasor, handle->synchrophasor_rate,
+                                   (uint32_t)handle->nominal_frequency) != SYNCHROPHASOR_OK) {
+                ESP_LOGW(TAG, "Synchrophasor estimation unavailable");
+                heap_caps_free(handle->synchrophasor);
+                handle->synchrophasor = NULL;
+            }
+        }
+    }
+    handle->wall_offset_us = 0;
+    
+    return ade7953_arm_irq(handle, IRQ_WSMP_BIT);
+}
+
+// Background task for continuous readings
+static void ade7953_task(void *pvParameters) {
+    ade7953_handle_t *handle = (ade7953_handle_t *)pvParameters;
+    
+    ESP_LOGI(TAG, "ADE7953 task started");
+    
+    if (handle->acquisition_mode == ADE7953_ACQUISITION_WAVEFORM) {
+        if (ade7953_start_waveform(handle) == ADE7953_OK) {
+            ESP_LOGI(TAG, "Waveform acquisition armed on GPIO %d (%.1f Hz)", ADE7953_INTERRUPT_PIN, WAVEFORM_SAMPLE_RATE_HZ);
+            ade7953_waveform_loop(handle);
+        } else {
+            ESP_LOGE(TAG, "Failed to arm waveform IRQ, falling back to polling acquisition");
+            ade7953_disarm_irq(handle);
+        }
+        if (!handle->stop_requested) {
+            handle->acquisition_mode = ADE7953_ACQUISITION_POLLING;
+        }
+    }
+    
+    if (handle->acquisition_mode == ADE7953_ACQUISITION_INTERRUPT && !handle->stop_requested) {
+        if (ade7953_arm_irq(handle, IRQ_ZXV_BIT) == ADE7953_OK) {
+            ESP_LOGI(TAG, "Interrupt-driven acquisition armed on GPIO %d", ADE7953_INTERRUPT_PIN);
+            ade7953_interrupt_loop(handle);
+        } else {
+            ESP_LOGE(TAG, "Failed to arm line cycle IRQ, falling back to polling acquisition");
+            ade7953_disarm_irq(handle);
+        }
+        if (!handle->stop_requested) {
+            handle->acquisition_mode = ADE7953_ACQUISITION_POLLING;
+        }
+    }
+    
+    if (!handle->stop_requested) {
+        ESP_LOGI(TAG, "Polling acquisition every %lu us", handle->sample_period_us);
+        ade7953_polling_loop(handle);
     }
+    
+    // Interrupt and timer are released, nothing touches the handle after this
+    ESP_LOGI(TAG, "ADE7953 task stopped");
+    handle->task_handle = NULL;
+    vTaskDelete(NULL);
 }
 
 // Initialize ADE7953
@@ -358,6 +1249,12 @@ ade7953_error_t ade7953_init(ade7953_handle_t *handle) {
     }
     
     memset(handle, 0, sizeof(ade7953_handle_t));
+    handle->acquisition_mode = ADE7953_DEFAULT_ACQUISITION_MODE;
+    handle->nominal_frequency = ADE7953_DEFAULT_NOMINAL_FREQUENCY;
+    handle->sample_period_us = ADE7953_SAMPLE_INTERVAL_MS * 1000;
+    handle->harmonics_interval_cycles = HARMONICS_DEFAULT_INTERVAL_CYCLES;
+    handle->synchrophasor_rate = SYNCHROPHASOR_DEFAULT_RATE;
+    handle->calibration = ade7953_get_calibration(ADE7953_DEFAULT_CALIBRATION_ID);
     
     ESP_LOGI(TAG, "Initializing ADE7953...");
     
@@ -378,17 +1275,22 @@ ade7953_error_t ade7953_init(ade7953_handle_t *handle) {
         return ret;
     }
     
-    // Create mutex
-    handle->spi_mutex = xSemaphoreCreateMutex();
-    if (!handle->spi_mutex) {
-        ESP_LOGE(TAG, "Failed to create SPI mutex");
-        spi_bus_remove_device(handle->spi_handle);
-        spi_bus_free(ADE7953_SPI_HOST);
-        return ADE7953_ERROR_INIT;
-    }
+    // Register command queue, serviced by the acquisition task once it owns the SPI device
+    mpsc_ring_init(&handle->command_ring, handle->command_storage, ADE7953_COMMAND_QUEUE_SIZE, sizeof(ade7953_command_t));
     
     handle->initialized = true;
     
+    // Event detection is optional, acquisition carries on without it
+    handle->events = heap_caps_calloc(1, sizeof(grid_events_t), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    grid_events_config_t events_config;
+    grid_events_default_config(&events_config);
+    events_config.nominal_frequency = handle->nominal_frequency;
+    if (!handle->events || grid_events_init(handle->events, &events_config) != GRID_EVENTS_OK) {
+        ESP_LOGW(TAG, "Grid event detection unavailable");
+        heap_caps_free(handle->events);
+        handle->events = NULL;
+    }
+    
     // Test communication before configuration
     ESP_LOGI(TAG, "Testing ADE7953 communication...");
     ret = ade7953_test_communication(handle);
@@ -416,8 +1318,10 @@ ade7953_error_t ade7953_deinit(ade7953_handle_t *handle) {
         return ADE7953_ERROR_INIT;
     }
     
-    // Stop task if running
-    ade7953_stop_task(handle);
+    // Stop task if running, the SPI device cannot go away under it
+    if (ade7953_stop_task(handle) != ADE7953_OK) {
+        return ADE7953_ERROR_TIMEOUT;
+    }
     
     // Clean up SPI
     if (handle->spi_handle) {
@@ -425,10 +1329,22 @@ ade7953_error_t ade7953_deinit(ade7953_handle_t *handle) {
         spi_bus_free(ADE7953_SPI_HOST);
     }
     
-    // Clean up mutex
-    if (handle->spi_mutex) {
-        vSemaphoreDelete(handle->spi_mutex);
-    }
+    // Clean up DMA buffers
+    ade7953_free_dma_buffers(handle);
+    
+    // Clean up waveform estimator and harmonic analysis
+    heap_caps_free(handle->waveform);
+    handle->waveform = NULL;
+    harmonics_deinit(handle->harmonics);
+    heap_caps_free(handle->harmonics);
+    handle->harmonics = NULL;
+    synchrophasor_deinit(handle->synchrophasor);
+    heap_caps_free(handle->synchrophasor);
+    handle->synchrophasor = NULL;
+    
+    // Clean up event detection
+    heap_caps_free(handle->events);
+    handle->events = NULL;
     
     handle->initialized = false;
     ESP_LOGI(TAG, "ADE7953 deinitialized");
@@ -446,13 +1362,15 @@ ade7953_error_t ade7953_start_task(ade7953_handle_t *handle) {
         return ADE7953_OK;
     }
     
-    BaseType_t ret = xTaskCreate(
+    handle->stop_requested = false;
+    BaseType_t ret = xTaskCreatePinnedToCore(
         ade7953_task,
         ADE7953_TASK_NAME,
         ADE7953_TASK_STACK_SIZE,
         handle,
         ADE7953_TASK_PRIORITY,
-        &handle->task_handle
+        &handle->task_handle,
+        ADE7953_TASK_CORE
     );
     
     if (ret != pdPASS) {
@@ -470,8 +1388,25 @@ ade7953_error_t ade7953_stop_task(ade7953_handle_t *handle) {
     }
     
     if (handle->task_handle) {
-        vTaskDelete(handle->task_handle);
-        handle->task_handle = NULL;
+        // The task releases the interrupt and the sample timer itself; deleting it from here could catch it
+        // holding the SPI bus or halfway through a command
+        handle->stop_requested = true;
+        xTaskNotifyGive(handle->task_handle);
+        
+        TickType_t start = xTaskGetTickCount();
+        while (handle->task_handle) {
+            if (xTaskGetTickCount() - start > pdMS_TO_TICKS(ADE7953_TASK_STOP_TIMEOUT_MS)) {
+                ESP_LOGE(TAG, "ADE7953 task did not stop within %d ms", ADE7953_TASK_STOP_TIMEOUT_MS);
+                return ADE7953_ERROR_TIMEOUT;
+            }
+            vTaskDelay(pdMS_TO_TICKS(10));
+        }
+        
+        // Nobody is left to run queued commands, fail them instead of letting the requesters time out
+        ade7953_command_t command;
+        while (mpsc_ring_pop(&handle->command_ring, &command)) {
+            ade7953_complete_command(handle, &command, ADE7953_ERROR_INIT, 0);
+        }
     }
     
     return ADE7953_OK;
@@ -495,6 +1430,14 @@ float ade7953_get_latest_voltage(ade7953_handle_t *handle) {
     return handle->voltage_rms;
 }
 
+// Get latest rate of change of frequency
+float ade7953_get_latest_rocof(ade7953_handle_t *handle) {
+    if (!handle) {
+        return 0.0f;
+    }
+    return handle->rocof;
+}
+
 // Get timestamp of last reading
 uint32_t ade7953_get_last_reading_time(ade7953_handle_t *handle) {
     if (!handle) {
@@ -510,7 +1453,7 @@ static ade7953_error_t ade7953_verify_last_communication(ade7953_handle_t *handl
     ade7953_error_t ret;
     
     // Check last address
-    ret = ade7953_read_register(handle, LAST_ADD_16, 16, &last_address);
+    ret = ade7953_spi_read_register(handle, LAST_ADD_16, 16, &last_address);
     if (ret != ADE7953_OK) {
         ESP_LOGE(TAG, "Failed to read LAST_ADD register");
         return ret;
@@ -522,7 +1465,7 @@ static ade7953_error_t ade7953_verify_last_communication(ade7953_handle_t *handl
     }
     
     // Check last operation type
-    ret = ade7953_read_register(handle, LAST_OP_8, 8, &last_op);
+    ret = ade7953_spi_read_register(handle, LAST_OP_8, 8, &last_op);
     if (ret != ADE7953_OK) {
         ESP_LOGE(TAG, "Failed to read LAST_OP register");
         return ret;
@@ -554,7 +1497,7 @@ static ade7953_error_t ade7953_verify_last_communication(ade7953_handle_t *handl
             return ADE7953_ERROR_COMMUNICATION;
     }
     
-    ret = ade7953_read_register(handle, data_register, expected_bits, &last_data);
+    ret = ade7953_spi_read_register(handle, data_register, expected_bits, &last_data);
     if (ret != ADE7953_OK) {
         ESP_LOGE(TAG, "Failed to read LAST_RWDATA register (0x%04X)", data_register);
         return ret;
@@ -609,10 +1552,125 @@ static ade7953_error_t ade7953_test_communication(ade7953_handle_t *handle) {
     return ADE7953_ERROR_COMMUNICATION;
 }
 
-// Set network handle for MQTT publishing
-void ade7953_set_measurement_queue(ade7953_handle_t *handle, QueueHandle_t measurement_queue) {
+// Select acquisition mode (polling, line-cycle interrupt or waveform) and the grid's nominal frequency,
+// which sizes the waveform DFT window and references the synchrophasor angles and the event thresholds
+ade7953_error_t ade7953_set_acquisition_mode(ade7953_handle_t *handle, ade7953_acquisition_mode_t mode,
+                                             float nominal_frequency) {
+    if (!handle || (nominal_frequency != 50.0f && nominal_frequency != 60.0f)) {
+        return ADE7953_ERROR_INIT;
+    }
+    
+    if (handle->task_handle) {
+        ESP_LOGW(TAG, "Cannot change acquisition mode while the task is running");
+        return ADE7953_ERROR_INIT;
+    }
+    
+    handle->acquisition_mode = mode;
+    handle->nominal_frequency = nominal_frequency;
+    if (handle->events) {
+        grid_events_config_t events_config = handle->events->config;
+        events_config.nominal_frequency = nominal_frequency;
+        grid_events_set_config(handle->events, &events_config);
+    }
+    return ADE7953_OK;
+}
+
+// Set the polling sample period (must be set before starting the task)
+ade7953_error_t ade7953_set_sample_period(ade7953_handle_t *handle, uint32_t period_us) {
+    if (!handle) {
+        return ADE7953_ERROR_INIT;
+    }
+    
+    if (handle->task_handle) {
+        ESP_LOGW(TAG, "Cannot change sample period while the task is running");
+        return ADE7953_ERROR_INIT;
+    }
+    
+    if (period_us < ADE7953_MIN_SAMPLE_PERIOD_US) {
+        ESP_LOGW(TAG, "Sample period %lu us too short, using %d us", period_us, ADE7953_MIN_SAMPLE_PERIOD_US);
+        period_us = ADE7953_MIN_SAMPLE_PERIOD_US;
+    }
+    
+    handle->sample_period_us = period_us;
+    return ADE7953_OK;
+}
+
+// Get sampling scheduler statistics
+void ade7953_get_timing_stats(ade7953_handle_t *handle, ade7953_timing_stats_t *stats) {
+    if (!handle || !stats) {
+        return;
+    }
+    memcpy(stats, &handle->timing_stats, sizeof(ade7953_timing_stats_t));
+}
+
+// Set measurement ring for MQTT publishing
+void ade7953_set_measurement_ring(ade7953_handle_t *handle, spsc_ring_t *measurement_ring) {
+    if (handle) {
+        handle->measurement_ring = measurement_ring;
+        ESP_LOGI(TAG, "Measurement ring set for publishing");
+    }
+}
+
+// Set harmonics queue for MQTT publishing
+void ade7953_set_harmonics_queue(ade7953_handle_t *handle, QueueHandle_t harmonics_queue) {
+    if (handle) {
+        handle->harmonics_queue = harmonics_queue;
+        harmonics_set_queue(handle->harmonics, harmonics_queue);
+    }
+}
+
+// Set how often the harmonic analysis runs, in line cycles (0 disables it)
+ade7953_error_t ade7953_set_harmonics_interval(ade7953_handle_t *handle, uint32_t interval_cycles) {
+    if (!handle) {
+        return ADE7953_ERROR_INIT;
+    }
+    
+    handle->harmonics_interval_cycles = interval_cycles;
+    handle->harmonics_cycle_count = 0;
+    return ADE7953_OK;
+}
+
+// Set events queue for MQTT publishing
+void ade7953_set_events_queue(ade7953_handle_t *handle, QueueHandle_t events_queue) {
+    if (handle) {
+        handle->events_queue = events_queue;
+        grid_events_set_queue(handle->events, events_queue);
+    }
+}
+
+// Replace the grid event thresholds and capture lengths
+ade7953_error_t ade7953_set_events_config(ade7953_handle_t *handle, const grid_events_config_t *config) {
+    if (!handle || !handle->events) {
+        return ADE7953_ERROR_INIT;
+    }
+    
+    return grid_events_set_config(handle->events, config) == GRID_EVENTS_OK ? ADE7953_OK : ADE7953_ERROR_INIT;
+}
+
+// Set synchrophasor queue for MQTT publishing
+void ade7953_set_synchrophasor_queue(ade7953_handle_t *handle, QueueHandle_t synchrophasor_queue) {
+    if (handle) {
+        handle->synchrophasor_queue = synchrophasor_queue;
+        synchrophasor_set_queue(handle->synchrophasor, synchrophasor_queue);
+    }
+}
+
+// Set the synchrophasor reporting rate in frames per second (10, 25 or 50 for a 50 Hz grid)
+ade7953_error_t ade7953_set_synchrophasor_rate(ade7953_handle_t *handle, uint32_t rate) {
+    if (!handle || rate == 0 || rate > SYNCHROPHASOR_MAX_RATE || 1000000 % rate != 0) {
+        return ADE7953_ERROR_INIT;
+    }
+    
+    handle->synchrophasor_rate = rate;
+    if (handle->synchrophasor) {
+        synchrophasor_set_rate(handle->synchrophasor, rate);
+    }
+    return ADE7953_OK;
+}
+
+// Record whether the wall clock is synchronized to UTC (reported in the synchrophasor STAT word)
+void ade7953_set_time_synchronized(ade7953_handle_t *handle, bool synchronized) {
     if (handle) {
-        handle->measurement_queue = measurement_queue;
-        ESP_LOGI(TAG, "Measurement queue set for publishing");
+        handle->time_synchronized = synchronized;
     }
 }
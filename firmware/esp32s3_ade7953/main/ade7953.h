@@ -3,15 +3,22 @@
 #include <string.h>
 #include <stdint.h>
 #include <stdbool.h>
+#include <stdatomic.h>
 #include "driver/spi_master.h"
 #include "driver/gpio.h"
 #include "esp_timer.h"
+#include "esp_heap_caps.h"
 #include "esp_log.h"
 #include "esp_sntp.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/semphr.h"
 #include "freertos/queue.h"
+#include "waveform.h"
+#include "harmonics.h"
+#include "grid_events.h"
+#include "synchrophasor.h"
+#include "ring_buffer.h"
 
 // Pin definitions
 #define ADE7953_SS_PIN          48
@@ -24,12 +31,38 @@
 // SPI configuration
 #define ADE7953_SPI_FREQUENCY   2000000  // 2MHz max frequency
 #define ADE7953_SPI_HOST        SPI2_HOST
+#define ADE7953_SPI_QUEUE_SIZE  8        // Transactions that can be in flight at once
+#define ADE7953_SPI_DMA_SLOT_SIZE 8      // Bytes per transaction buffer (2 address + 1 command + up to 4 data, padded)
+#define ADE7953_SPI_DMA_ALIGNMENT 4      // GDMA word alignment for internal RAM buffers
+
+// Register command queue (other tasks ask the acquisition task, the only SPI owner, to access registers)
+#define ADE7953_COMMAND_QUEUE_SIZE      8       // Power of two, also the number of requests in flight
+#define ADE7953_COMMAND_TIMEOUT_MS      200     // Covers the longest acquisition wait between services
+#define ADE7953_COMMAND_NOTIFY_INDEX    1       // Task notification slot for completions (index 0 belongs to the requester)
 
 // Register addresses (key ones for frequency and voltage)
 #define PERIOD_16               0x10E    // Period register for frequency calculation
 #define VRMS_32                 0x31C    // Voltage RMS register
+#define V_32                    0x318    // Instantaneous voltage waveform (signed, updated at 6.99 kHz)
 #define UNLOCK_OPTIMUM_REGISTER 0x00FE   // Register to unlock optimum settings
 #define Reserved_16             0x120    // Reserved register for optimum settings
+#define CONFIG_16               0x102    // Configuration register
+
+// Voltage channel calibration and thresholds, the registers writable from outside the driver
+#define SAGCYC_8                0x000    // Half line cycles below SAGLVL before a sag is flagged
+#define PGA_V_8                 0x007    // Voltage channel PGA gain
+#define ZXTOUT_16               0x100    // Zero-crossing timeout
+#define SAGLVL_32               0x300    // Sag voltage level
+#define OVLVL_32                0x325    // Overvoltage level
+#define AVGAIN_32               0x381    // Voltage gain calibration
+#define VRMSOS_32               0x388    // Voltage RMS offset
+
+// Interrupt registers (current channel A and voltage channel)
+#define IRQENA_32               0x32C    // Interrupt enable register
+#define IRQSTATA_32             0x32D    // Interrupt status register
+#define RSTIRQSTATA_32          0x32E    // Interrupt status register, cleared on read (releases the IRQ pin)
+#define RSTIRQSTATB_32          0x331    // Current channel B interrupt status register, cleared on read
+#define ADE7953_REG_24_TO_32    0x100    // The 24-bit registers are mirrored 0x100 higher as 32-bit registers
 
 // Communication verification registers
 #define LAST_OP_8               0x0FD    // Contains the type of last successful communication
@@ -46,6 +79,15 @@
 #define UNLOCK_OPTIMUM_REGISTER_VALUE   0xAD                // Value to unlock optimum register
 #define DEFAULT_OPTIMUM_REGISTER        0x0030              // Optimum register value
 
+// Interrupt bits (IRQENA / IRQSTATA / RSTIRQSTATA)
+#define IRQ_ZXV_BIT                     (1UL << 15)         // Voltage channel zero crossing
+#define IRQ_WSMP_BIT                    (1UL << 17)         // New waveform data acquired (6.99 kHz)
+#define IRQ_RESET_BIT                   (1UL << 20)         // End of a software or hardware reset (always enabled)
+
+// CONFIG register fields
+#define CONFIG_ZX_EDGE_MASK             (0x3 << 12)         // Zero-crossing interrupt edge selection
+#define CONFIG_ZX_EDGE_POSITIVE         (0x2 << 12)         // Interrupt only on positive-going zero crossing (once per line cycle)
+
 // SPI transfer commands
 #define READ_TRANSFER           0x80
 #define WRITE_TRANSFER          0x00
@@ -56,25 +98,111 @@
 #define ADE7953_MAX_VERIFY_ATTEMPTS 5   // Maximum attempts for communication verification
 #define ADE7953_VERIFY_DELAY_MS     10  // Delay between verification attempts
 
-// Conversion factors
+// Conversion factors (default calibration set)
 #define GRID_FREQUENCY_CONVERSION_FACTOR 223750.0f // Clock of the period measurement of 223.75 kHz
 #define VOLTAGE_CONVERSION_FACTOR 0.00003879f // Conversion accounting for 990kohm to 1 kohm voltage divider
+#define ADE7953_DEFAULT_CALIBRATION_ID 1    // Entry of the calibration table in ade7953.c stamped on new measurements
 
 // Task configuration
 #define ADE7953_TASK_STACK_SIZE (8 * 1024)
 #define ADE7953_TASK_PRIORITY   10
 #define ADE7953_TASK_NAME       "ade7953_task"
+#define ADE7953_TASK_CORE       1       // Keep acquisition off core 0, where WiFi and LwIP run
+#define ADE7953_TASK_STOP_TIMEOUT_MS 500 // Longer than any acquisition wait, the stop notification cuts it short
 
 // Timing
 #define ADE7953_RESET_DURATION_MS       200
 #define ADE7953_SAMPLE_INTERVAL_MS      20  // 50Hz grid = 20ms per cycle
+#define ADE7953_MIN_SAMPLE_PERIOD_US    1000
+
+// Interrupt-driven acquisition
+#define ADE7953_IRQ_TIMEOUT_MS                  100 // No zero crossing for 5 cycles at 50Hz
+#define ADE7953_IRQ_MAX_CONSECUTIVE_TIMEOUTS    10  // Fall back to polling if the IRQ line seems not to be wired
+#define ADE7953_DEFAULT_ACQUISITION_MODE        ADE7953_ACQUISITION_INTERRUPT
+#define ADE7953_DEFAULT_NOMINAL_FREQUENCY       50.0f   // Hz, 50 or 60: waveform DFT window, synchrophasor reference, event thresholds
+
+// Waveform acquisition
+#define ADE7953_WAVEFORM_GAP_US                 ((int64_t)(1.5 * WAVEFORM_SAMPLE_PERIOD_US))  // Longer between WSMP edges means lost samples
+
+// Acquisition modes
+typedef enum {
+    ADE7953_ACQUISITION_POLLING = 0,    // Read on a drift-free hardware timer (default every ADE7953_SAMPLE_INTERVAL_MS)
+    ADE7953_ACQUISITION_INTERRUPT,      // Read once per line cycle on the voltage zero-crossing IRQ
+    ADE7953_ACQUISITION_WAVEFORM        // Stream the voltage waveform on every WSMP IRQ and estimate frequency in software
+} ade7953_acquisition_mode_t;
+
+// Sampling scheduler statistics (polling acquisition)
+typedef struct {
+    uint32_t sample_count;      // Samples taken
+    uint32_t skipped_count;     // Deadlines that passed without a sample
+    uint32_t overrun_count;     // Samples that were still running at the next deadline
+    int32_t last_jitter_us;     // Wake-up lateness of the last sample relative to its deadline
+    int32_t max_jitter_us;      // Worst wake-up lateness seen
+    int32_t last_overrun_us;    // How far the last overrunning sample ran past the next deadline
+} ade7953_timing_stats_t;
 
+// Source of a measurement's frequency code
+typedef enum {
+    MEASUREMENT_FREQUENCY_UNIT_PERIOD = 0,      // PERIOD register counts, frequency = period clock / code
+    MEASUREMENT_FREQUENCY_UNIT_MICROHERTZ = 1   // Waveform estimator, rounded to 1 uHz (finer than a float ulp at 50 Hz)
+} measurement_frequency_unit_t;
+
+// Calibration set, referenced by ID from every measurement so the raw codes can be converted (again) later
+typedef struct {
+    uint8_t id;
+    float period_clock_hz;              // frequency = period_clock_hz / PERIOD code
+    float volts_per_lsb;                // voltage = VRMS code * volts_per_lsb
+} ade7953_calibration_t;
+
+// Measurement on its way to the publisher: raw codes only, converted to units at the outputs
 typedef struct {
     int64_t timestamp_us;
-    float frequency;
-    float voltage;
+    uint32_t sequence;                  // Per-sample acquisition counter, wraps around; a gap is a lost sample
+    uint32_t frequency_code;            // In frequency_unit
+    uint32_t voltage_code;              // VRMS register
+    uint8_t frequency_unit;             // measurement_frequency_unit_t
+    uint8_t calibration_id;             // ade7953_calibration_t the codes were taken under
 } measurement_t;
 
+// Register descriptor for batched reads
+typedef struct {
+    uint16_t address;
+    uint8_t n_bits;
+} ade7953_reg_desc_t;
+
+#define ADE7953_MAX_BATCH_REGISTERS     ADE7953_SPI_QUEUE_SIZE  // Maximum registers in a single batched read
+
+// Register command submitted by a task that does not own the SPI device
+typedef enum {
+    ADE7953_COMMAND_READ,
+    ADE7953_COMMAND_WRITE,
+    ADE7953_COMMAND_READ_VERIFIED,
+    ADE7953_COMMAND_WRITE_VERIFIED
+} ade7953_command_type_t;
+
+typedef struct {
+    uint8_t type;                       // ade7953_command_type_t
+    uint8_t n_bits;
+    uint16_t address;
+    uint32_t data;
+    TaskHandle_t requester;
+    uint8_t completion;                 // Index into the completion table
+} ade7953_command_t;
+
+// Completion slot, owned by the requester while PENDING and by whoever finishes it last otherwise
+typedef enum {
+    ADE7953_COMPLETION_FREE = 0,
+    ADE7953_COMPLETION_PENDING,
+    ADE7953_COMPLETION_DONE,
+    ADE7953_COMPLETION_ABANDONED        // The requester timed out, the acquisition task frees the slot
+} ade7953_completion_state_t;
+
+typedef struct {
+    atomic_int state;                   // ade7953_completion_state_t
+    int32_t result;                     // ade7953_error_t
+    uint32_t data;
+} ade7953_completion_t;
+
 // Error codes
 typedef enum {
     ADE7953_OK = 0,
@@ -87,43 +215,137 @@ typedef enum {
 // ADE7953 handle structure
 typedef struct {
     spi_device_handle_t spi_handle;
-    SemaphoreHandle_t spi_mutex;
-    TaskHandle_t task_handle;
+    
+    // Preallocated DMA-capable transaction buffers (one slot per queued transaction)
+    uint8_t *spi_tx_buffer;
+    uint8_t *spi_rx_buffer;
+    spi_transaction_t spi_transactions[ADE7953_SPI_QUEUE_SIZE];
+    uint8_t spi_pending_bits[ADE7953_SPI_QUEUE_SIZE];
+    size_t spi_pending_count;               // Transactions queued and not yet collected
+    TaskHandle_t task_handle;               // Sole owner of the SPI device while running, cleared by the task on exit
+    volatile bool stop_requested;           // Set by ade7953_stop_task, the task winds down and exits on its own
+    
+    // Register requests from other tasks, served by the acquisition task between samples
+    mpsc_ring_t command_ring;
+    uint8_t command_storage[MPSC_RING_STORAGE_SIZE(ADE7953_COMMAND_QUEUE_SIZE, sizeof(ade7953_command_t))] __attribute__((aligned(4)));
+    ade7953_completion_t completions[ADE7953_COMMAND_QUEUE_SIZE];
+    uint32_t command_count;
     bool initialized;
     
+    // Acquisition
+    ade7953_acquisition_mode_t acquisition_mode;
+    float nominal_frequency;            // Hz, of the grid
+    volatile int64_t trigger_timestamp_us;  // esp_timer time captured in the IRQ ISR or sample timer callback
+    
+    // Drift-free sampling scheduler (polling acquisition)
+    esp_timer_handle_t sample_timer;
+    uint32_t sample_period_us;
+    int64_t schedule_start_us;          // esp_timer time of deadline zero
+    int64_t last_deadline_index;
+    ade7953_timing_stats_t timing_stats;
+    uint32_t irq_timeout_count;         // Line cycles with no IRQ within ADE7953_IRQ_TIMEOUT_MS
+    
+    // Waveform capture and software frequency estimation
+    waveform_estimator_t *waveform;
+    uint32_t waveform_gap_count;        // Times the estimator was reset because waveform samples were lost
+    
+    // Harmonic analysis on the captured waveform
+    harmonics_analyzer_t *harmonics;
+    uint32_t harmonics_interval_cycles; // Analyze every N line cycles, 0 disables
+    uint32_t harmonics_cycle_count;
+    QueueHandle_t harmonics_queue;
+    
+    // Grid event detection on the per-cycle series
+    grid_events_t *events;
+    QueueHandle_t events_queue;
+    float rocof;                        // Latest rate of change of frequency, Hz/s
+    
+    // Synchrophasor reports on UTC-aligned instants (waveform acquisition only)
+    synchrophasor_t *synchrophasor;
+    QueueHandle_t synchrophasor_queue;
+    uint32_t synchrophasor_rate;
+    volatile bool time_synchronized;    // Wall clock disciplined by SNTP
+    int64_t wall_offset_us;             // Wall-clock minus esp_timer time, refreshed every cycle
+    
     // Latest readings
+    const ade7953_calibration_t *calibration;   // Active calibration set
     float grid_frequency;
     float voltage_rms;
     uint32_t last_reading_ms;
     
-    // Measurement queue for MQTT publishing
-    QueueHandle_t measurement_queue;
+    // Measurement ring for MQTT publishing, this task is its only producer
+    spsc_ring_t *measurement_ring;
+    uint32_t sample_sequence;           // Taken by every acquired sample, published or not
+    uint32_t plausibility_reject_count; // Samples not published because a reading was invalid or out of range
 } ade7953_handle_t;
 
 // Function prototypes
 ade7953_error_t ade7953_init(ade7953_handle_t *handle);
 ade7953_error_t ade7953_deinit(ade7953_handle_t *handle);
 
-// Low-level register access
+// Low-level register access - safe from any task. Once the acquisition task runs it is the only SPI owner,
+// other tasks go through the command queue and block (up to ADE7953_COMMAND_TIMEOUT_MS) for the completion.
 ade7953_error_t ade7953_write_register(ade7953_handle_t *handle, uint16_t reg_addr, uint8_t n_bits, uint32_t data);
 ade7953_error_t ade7953_read_register(ade7953_handle_t *handle, uint16_t reg_addr, uint8_t n_bits, uint32_t *data);
 
+// Batched register access - one bus acquisition for all registers, one shared esp_timer timestamp (SPI owner only)
+ade7953_error_t ade7953_read_registers(ade7953_handle_t *handle, const ade7953_reg_desc_t *regs, size_t n, uint32_t *out, int64_t *timestamp_us);
+
+// Pipelined register access - queue a batch, do other work while it is clocked out, then collect it.
+// The bus stays held between the two calls (SPI owner only).
+ade7953_error_t ade7953_queue_registers(ade7953_handle_t *handle, const ade7953_reg_desc_t *regs, size_t n, int64_t *timestamp_us);
+ade7953_error_t ade7953_collect_registers(ade7953_handle_t *handle, uint32_t *out);
+
 // Low-level register access with verification
 ade7953_error_t ade7953_write_register_verified(ade7953_handle_t *handle, uint16_t reg_addr, uint8_t n_bits, uint32_t data);
 ade7953_error_t ade7953_read_register_verified(ade7953_handle_t *handle, uint16_t reg_addr, uint8_t n_bits, uint32_t *data);
 
+// Whether a register may be read or written from outside the driver. Reads that clear interrupt flags
+// the acquisition waits on are refused, writes are limited to calibration and thresholds.
+bool ade7953_register_readable(uint16_t reg_addr, uint8_t n_bits);
+bool ade7953_register_writable(uint16_t reg_addr, uint8_t n_bits);
+
 // High-level measurement functions
 ade7953_error_t ade7953_read_frequency(ade7953_handle_t *handle, float *frequency);
 ade7953_error_t ade7953_read_voltage(ade7953_handle_t *handle, float *voltage);
 
+// Measure per-sample SPI time of separate reads versus a batched read (results are logged)
+void ade7953_benchmark_spi(ade7953_handle_t *handle, uint32_t iterations);
+
 // Task management
 ade7953_error_t ade7953_start_task(ade7953_handle_t *handle);
 ade7953_error_t ade7953_stop_task(ade7953_handle_t *handle);
 
+// Calibration sets and conversion of queued measurements to engineering units
+const ade7953_calibration_t *ade7953_get_calibration(uint8_t calibration_id);
+ade7953_error_t ade7953_set_calibration(ade7953_handle_t *handle, uint8_t calibration_id);
+float ade7953_measurement_frequency(const measurement_t *measurement);
+float ade7953_measurement_voltage(const measurement_t *measurement);
+
 // Get latest readings (non-blocking)
 float ade7953_get_latest_frequency(ade7953_handle_t *handle);
 float ade7953_get_latest_voltage(ade7953_handle_t *handle);
+float ade7953_get_latest_rocof(ade7953_handle_t *handle);
 uint32_t ade7953_get_last_reading_time(ade7953_handle_t *handle);
 
+// Acquisition mode and the grid's nominal frequency, 50 or 60 Hz (must be set before starting the task)
+ade7953_error_t ade7953_set_acquisition_mode(ade7953_handle_t *handle, ade7953_acquisition_mode_t mode,
+                                             float nominal_frequency);
+ade7953_error_t ade7953_set_sample_period(ade7953_handle_t *handle, uint32_t period_us);
+void ade7953_get_timing_stats(ade7953_handle_t *handle, ade7953_timing_stats_t *stats);
+
 // Set measurement queue for MQTT publishing
-void ade7953_set_measurement_queue(ade7953_handle_t *handle, QueueHandle_t measurement_queue);
+void ade7953_set_measurement_ring(ade7953_handle_t *handle, spsc_ring_t *measurement_ring);
+
+// Harmonic analysis (waveform acquisition only) - records go to the harmonics queue as harmonics_record_t
+void ade7953_set_harmonics_queue(ade7953_handle_t *handle, QueueHandle_t harmonics_queue);
+ade7953_error_t ade7953_set_harmonics_interval(ade7953_handle_t *handle, uint32_t interval_cycles);
+
+// Grid event detection - frozen captures go to the events queue as grid_event_record_t pointers
+void ade7953_set_events_queue(ade7953_handle_t *handle, QueueHandle_t events_queue);
+ade7953_error_t ade7953_set_events_config(ade7953_handle_t *handle, const grid_events_config_t *config);
+
+// Synchrophasors (waveform acquisition only) - reports go to the synchrophasor queue as synchrophasor_measurement_t
+void ade7953_set_synchrophasor_queue(ade7953_handle_t *handle, QueueHandle_t synchrophasor_queue);
+ade7953_error_t ade7953_set_synchrophasor_rate(ade7953_handle_t *handle, uint32_t rate);
+void ade7953_set_time_synchronized(ade7953_handle_t *handle, bool synchronized);
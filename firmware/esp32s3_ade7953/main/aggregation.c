@@ -0,0 +1,141 @@
+#include "aggregation.h"
+#include <string.h>
+#include <math.h>
+
+// Start a quantity's statistics with its first sample
+static void aggregation_stats_start(aggregation_stats_t *stats, float value) {
+    stats->min = value;
+    stats->max = value;
+    stats->mean = value;
+    stats->m2 = 0.0;
+}
+
+// Welford update, count includes the new sample
+static void aggregation_stats_add(aggregation_stats_t *stats, uint32_t count, float value) {
+    if (value < stats->min) {
+        stats->min = value;
+    }
+    if (value > stats->max) {
+        stats->max = value;
+    }
+    
+    double delta = value - stats->mean;
+    stats->mean += delta / count;
+    stats->m2 += delta * (value - stats->mean);
+}
+
+// Min, max, mean and standard deviation of a closed window
+static void aggregation_stats_summarize(const aggregation_stats_t *stats, uint32_t count, aggregation_summary_t *summary) {
+    summary->min = stats->min;
+    summary->max = stats->max;
+    summary->mean = (float)stats->mean;
+    summary->stddev = count > 1 ? (float)sqrt(stats->m2 / (count - 1)) : 0.0f;
+}
+
+// UTC start of the window of a tier that holds timestamp_us
+static int64_t aggregation_window_start(const aggregation_tier_t *tier, int64_t timestamp_us) {
+    int64_t window_us = (int64_t)tier->config.window_s * 1000000;
+    int64_t start_us = timestamp_us / window_us * window_us;
+    return start_us > timestamp_us ? start_us - window_us : start_us;
+}
+
+// Hand out a tier's window and empty it
+static void aggregation_close(aggregation_t *aggregation, size_t index, aggregation_record_t *record) {
+    aggregation_tier_t *tier = &aggregation->tiers[index];
+    
+    record->tier = index;
+    record->window_s = tier->config.window_s;
+    record->start_us = tier->window_start_us;
+    record->count = tier->count;
+    aggregation_stats_summarize(&tier->frequency, tier->count, &record->frequency);
+    aggregation_stats_summarize(&tier->voltage, tier->count, &record->voltage);
+    
+    record->has_quantiles = tier->config.quantiles;
+    for (size_t j = 0; tier->config.quantiles && j < AGGREGATION_QUANTILE_COUNT; j++) {
+        record->deviation_quantiles[j] = quantile_p2_get(&tier->deviation[j]);
+        quantile_p2_reset(&tier->deviation[j]);
+    }
+    
+    tier->count = 0;
+}
+
+// Check a tier list, an empty one is valid
+bool aggregation_tiers_valid(const aggregation_tier_config_t *tiers, size_t tier_count) {
+    if ((tier_count > 0 && !tiers) || tier_count > AGGREGATION_MAX_TIERS) {
+        return false;
+    }
+    for (size_t i = 0; i < tier_count; i++) {
+        if (tiers[i].window_s == 0 || tiers[i].window_s > AGGREGATION_MAX_WINDOW_S || tiers[i].qos > 2) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Initialize with the given tiers, tier_count 0 leaves the aggregator idle
+aggregation_error_t aggregation_init(aggregation_t *aggregation, const aggregation_tier_config_t *tiers, size_t tier_count,
+                                     float nominal_frequency) {
+    if (!aggregation || !aggregation_tiers_valid(tiers, tier_count) || nominal_frequency <= 0.0f) {
+        return AGGREGATION_ERROR_INVALID_PARAM;
+    }
+    
+    static const float quantiles[AGGREGATION_QUANTILE_COUNT] = AGGREGATION_QUANTILES;
+    memset(aggregation, 0, sizeof(aggregation_t));
+    for (size_t i = 0; i < tier_count; i++) {
+        aggregation->tiers[i].config = tiers[i];
+        for (size_t j = 0; j < AGGREGATION_QUANTILE_COUNT; j++) {
+            quantile_p2_init(&aggregation->tiers[i].deviation[j], quantiles[j]);
+        }
+    }
+    aggregation->tier_count = tier_count;
+    aggregation->nominal_frequency = nominal_frequency;
+    return AGGREGATION_OK;
+}
+
+// Add a sample, closing each window it falls outside of (including a step back of the clock)
+size_t aggregation_push(aggregation_t *aggregation, int64_t timestamp_us, float frequency, float voltage,
+                        aggregation_record_t *records) {
+    size_t closed = 0;
+    
+    for (size_t i = 0; i < aggregation->tier_count; i++) {
+        aggregation_tier_t *tier = &aggregation->tiers[i];
+        int64_t window_start_us = aggregation_window_start(tier, timestamp_us);
+        
+        if (tier->count > 0 && window_start_us != tier->window_start_us) {
+            aggregation_close(aggregation, i, &records[closed++]);
+        }
+        
+        if (tier->count == 0) {
+            tier->window_start_us = window_start_us;
+            tier->count = 1;
+            aggregation_stats_start(&tier->frequency, frequency);
+            aggregation_stats_start(&tier->voltage, voltage);
+        } else {
+            tier->count++;
+            aggregation_stats_add(&tier->frequency, tier->count, frequency);
+            aggregation_stats_add(&tier->voltage, tier->count, voltage);
+        }
+        
+        for (size_t j = 0; tier->config.quantiles && j < AGGREGATION_QUANTILE_COUNT; j++) {
+            quantile_p2_add(&tier->deviation[j], frequency - aggregation->nominal_frequency);
+        }
+    }
+    
+    return closed;
+}
+
+// Close the windows no sample will close any more
+size_t aggregation_flush(aggregation_t *aggregation, int64_t now_us, aggregation_record_t *records) {
+    size_t closed = 0;
+    
+    for (size_t i = 0; i < aggregation->tier_count; i++) {
+        aggregation_tier_t *tier = &aggregation->tiers[i];
+        int64_t window_end_us = tier->window_start_us + (int64_t)tier->config.window_s * 1000000;
+        
+        if (tier->count > 0 && now_us >= window_end_us + AGGREGATION_WINDOW_GRACE_US) {
+            aggregation_close(aggregation, i, &records[closed++]);
+        }
+    }
+    
+    return closed;
+}
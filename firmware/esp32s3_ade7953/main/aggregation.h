@@ -0,0 +1,95 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "quantile.h"
+
+// Tiers
+#define AGGREGATION_MAX_TIERS           4
+#define AGGREGATION_MAX_WINDOW_S        3600
+#define AGGREGATION_WINDOW_GRACE_US     500000  // A window is closed this long after its end if no later sample closes it
+
+// Quantiles of the frequency deviation from nominal, for grid-quality reporting
+#define AGGREGATION_DEFAULT_NOMINAL_FREQUENCY   50.0f  // Hz, the deviations are taken from the nominal given to aggregation_init
+#define AGGREGATION_QUANTILE_COUNT      5
+#define AGGREGATION_QUANTILES           { 0.01f, 0.05f, 0.5f, 0.95f, 0.99f }
+#define AGGREGATION_QUANTILE_NAMES      { "p1", "p5", "p50", "p95", "p99" }
+
+// Default tiers: 1 s and 10 s for live dashboards, 1 min and 1 h with quantiles at QoS 1 for reporting
+#define AGGREGATION_DEFAULT_TIERS       { { .window_s = 1, .qos = 0 }, { .window_s = 10, .qos = 0 }, \
+                                          { .window_s = 60, .qos = 1, .quantiles = true }, \
+                                          { .window_s = 3600, .qos = 1, .quantiles = true } }
+#define AGGREGATION_DEFAULT_TIER_COUNT  4
+
+// One tier: a window length and the QoS its records are published with
+typedef struct {
+    uint32_t window_s;                  // Windows are aligned to multiples of this many UTC seconds
+    uint8_t qos;
+    bool quantiles;                     // Also estimate AGGREGATION_QUANTILES of the frequency deviation
+} aggregation_tier_config_t;
+
+// Welford's running statistics of one quantity. Mean and M2 are double: at 3000 samples a minute
+// the increments of a float mean at 50 Hz fall below its resolution.
+typedef struct {
+    float min;
+    float max;
+    double mean;
+    double m2;                          // Sum of squared differences from the mean
+} aggregation_stats_t;
+
+// Summary of one quantity over a closed window
+typedef struct {
+    float min;
+    float max;
+    float mean;
+    float stddev;                       // Sample standard deviation, 0 for a single sample
+} aggregation_summary_t;
+
+// Closed window, ready to publish
+typedef struct {
+    uint8_t tier;                       // Index into the configured tiers
+    uint32_t window_s;
+    int64_t start_us;                   // UTC start of the window
+    uint32_t count;                     // Samples in the window, short of the nominal rate if any were lost
+    aggregation_summary_t frequency;
+    aggregation_summary_t voltage;
+    bool has_quantiles;
+    float deviation_quantiles[AGGREGATION_QUANTILE_COUNT];  // Hz from nominal, in AGGREGATION_QUANTILES order
+} aggregation_record_t;
+
+// Window being filled
+typedef struct {
+    aggregation_tier_config_t config;
+    int64_t window_start_us;
+    uint32_t count;
+    aggregation_stats_t frequency;
+    aggregation_stats_t voltage;
+    quantile_p2_t deviation[AGGREGATION_QUANTILE_COUNT];   // Used if config.quantiles, fixed size however long the window
+} aggregation_tier_t;
+
+// Aggregator state, owned by the publishing task
+typedef struct {
+    aggregation_tier_t tiers[AGGREGATION_MAX_TIERS];
+    size_t tier_count;
+    float nominal_frequency;            // Hz, 50 or 60 for the grid being measured
+} aggregation_t;
+
+// Error codes
+typedef enum {
+    AGGREGATION_OK = 0,
+    AGGREGATION_ERROR_INVALID_PARAM = -1
+} aggregation_error_t;
+
+// Function prototypes
+bool aggregation_tiers_valid(const aggregation_tier_config_t *tiers, size_t tier_count);
+aggregation_error_t aggregation_init(aggregation_t *aggregation, const aggregation_tier_config_t *tiers, size_t tier_count,
+                                     float nominal_frequency);
+
+// Add a sample to every tier. Windows the sample closes are written to records (room for
+// AGGREGATION_MAX_TIERS) and counted in the return value.
+size_t aggregation_push(aggregation_t *aggregation, int64_t timestamp_us, float frequency, float voltage,
+                        aggregation_record_t *records);
+
+// Close windows that ended more than AGGREGATION_WINDOW_GRACE_US before now_us (UTC), for when samples stop
+size_t aggregation_flush(aggregation_t *aggregation, int64_t now_us, aggregation_record_t *records);
@@ -0,0 +1,220 @@
+#include "binlog.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+#include "esp_app_desc.h"
+
+_Static_assert(BINLOG_RECORD_MAX_SIZE - BINLOG_RECORD_HEADER_SIZE < BINLOG_ARGS_TRUNCATED, "Argument length must leave the truncation flag free");
+
+static binlog_sink_t g_binlog_sink = NULL;
+static uint8_t g_binlog_header[BINLOG_HEADER_SIZE];
+static __thread bool g_binlog_echoing = false;
+
+// Colour and level letter of an ESP_LOGx line, by esp_log_level_t
+static const char *const g_binlog_prefixes[] = {
+    [ESP_LOG_ERROR] = LOG_COLOR_E "E",
+    [ESP_LOG_WARN] = LOG_COLOR_W "W",
+    [ESP_LOG_INFO] = LOG_COLOR_I "I",
+    [ESP_LOG_DEBUG] = LOG_COLOR_D "D",
+    [ESP_LOG_VERBOSE] = LOG_COLOR_V "V",
+};
+
+// Record writer, stops at the end of the record
+typedef struct {
+    uint8_t *p;
+    uint8_t *end;
+} binlog_cursor_t;
+
+static bool binlog_put(binlog_cursor_t *cursor, const void *data, size_t length) {
+    if (length > (size_t)(cursor->end - cursor->p)) {
+        return false;
+    }
+    memcpy(cursor->p, data, length);
+    cursor->p += length;
+    return true;
+}
+
+static bool binlog_put_u32(binlog_cursor_t *cursor, uint32_t value) {
+    uint8_t bytes[4] = { value & 0xFF, (value >> 8) & 0xFF, (value >> 16) & 0xFF, value >> 24 };
+    return binlog_put(cursor, bytes, sizeof(bytes));
+}
+
+static bool binlog_put_u64(binlog_cursor_t *cursor, uint64_t value) {
+    return binlog_put_u32(cursor, (uint32_t)value) && binlog_put_u32(cursor, (uint32_t)(value >> 32));
+}
+
+// Length byte and the bytes of a string, cut to what is left of the record
+static bool binlog_put_string(binlog_cursor_t *cursor, const char *value) {
+    if (!value) {
+        value = "(null)";
+    }
+    size_t space = cursor->end - cursor->p;
+    if (space == 0) {
+        return false;
+    }
+    
+    size_t length = strnlen(value, UINT8_MAX);
+    bool complete = length < space;
+    if (!complete) {
+        length = space - 1;
+    }
+    *cursor->p++ = (uint8_t)length;
+    binlog_put(cursor, value, length);
+    return complete;
+}
+
+// Copy the arguments in the order and at the size the format implies (ESP32-S3: int, long and
+// pointers 4 bytes, long long and double 8); returns false if they did not all fit
+static bool binlog_put_arguments(binlog_cursor_t *cursor, const char *format, va_list args) {
+    for (const char *p = format; *p; p++) {
+        if (*p != '%') {
+            continue;
+        }
+        p++;
+        if (*p == '%') {
+            continue;
+        }
+        
+        // Flags, width and precision, a '*' takes an int argument
+        while (*p && strchr("-+ #0", *p)) {
+            p++;
+        }
+        if (*p == '*') {
+            if (!binlog_put_u32(cursor, (uint32_t)va_arg(args, int))) {
+                return false;
+            }
+            p++;
+        }
+        while (*p >= '0' && *p <= '9') {
+            p++;
+        }
+        if (*p == '.') {
+            p++;
+            if (*p == '*') {
+                if (!binlog_put_u32(cursor, (uint32_t)va_arg(args, int))) {
+                    return false;
+                }
+                p++;
+            }
+            while (*p >= '0' && *p <= '9') {
+                p++;
+            }
+        }
+        
+        // Length modifiers, only 64-bit integers change the size
+        bool wide = false;
+        int longs = 0;
+        while (*p && strchr("hlLqjzt", *p)) {
+            longs += *p == 'l';
+            wide |= *p == 'q' || *p == 'j' || *p == 'L';
+            p++;
+        }
+        wide |= longs >= 2;
+        
+        bool ok;
+        switch (*p) {
+            case 'd': case 'i': case 'u': case 'o': case 'x': case 'X': case 'c':
+                ok = wide ? binlog_put_u64(cursor, va_arg(args, unsigned long long))
+                          : binlog_put_u32(cursor, va_arg(args, unsigned int));
+                break;
+            case 'p':
+                ok = binlog_put_u32(cursor, (uint32_t)(uintptr_t)va_arg(args, void *));
+                break;
+            case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A': {
+                double value = va_arg(args, double);
+                uint64_t bits;
+                memcpy(&bits, &value, sizeof(bits));
+                ok = binlog_put_u64(cursor, bits);
+                break;
+            }
+            case 's':
+                ok = binlog_put_string(cursor, va_arg(args, const char *));
+                break;
+            default:
+                return false;   // End of format or a conversion the decoder would not know either
+        }
+        if (!ok) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Route BINLOG_x calls to sink, NULL returns them to ESP_LOGx
+void binlog_set_sink(binlog_sink_t sink) {
+    if (sink) {
+        // The decoder checks the ELF it is given against these bytes
+        binlog_make_header(g_binlog_header, esp_app_get_description()->app_elf_sha256);
+    }
+    g_binlog_sink = sink;
+}
+
+bool binlog_enabled(void) {
+    return g_binlog_sink != NULL;
+}
+
+bool binlog_echoing(void) {
+    return g_binlog_echoing;
+}
+
+// Print the line as ESP_LOGx would: the prefix is expanded into the format (a '%' in the tag doubled),
+// the site's format and arguments are left to the log function. A format too long for the buffer is printed bare.
+static void binlog_echo(const binlog_site_t *site, uint32_t timestamp, va_list args) {
+    char format[BINLOG_ECHO_FORMAT_SIZE];
+    const char *tag = *site->tag;
+    int length = snprintf(format, sizeof(format), "%s (%lu) ", g_binlog_prefixes[site->level], timestamp);
+    
+    for (const char *p = tag; *p && length < (int)sizeof(format) - 2; p++) {
+        format[length++] = *p;
+        if (*p == '%') {
+            format[length++] = '%';
+        }
+    }
+    int written = snprintf(format + length, sizeof(format) - length, ": %s" LOG_RESET_COLOR "\n", site->format);
+    
+    g_binlog_echoing = true;
+    esp_log_writev(site->level, tag, written < (int)sizeof(format) - length ? format : site->format, args);
+    g_binlog_echoing = false;
+}
+
+// Record: site address (u32), esp_log_timestamp() ms (u32), argument length (u8, with
+// BINLOG_ARGS_TRUNCATED), arguments; all little-endian. A line at BINLOG_ECHO_LEVEL or above is printed
+// even if the sink drops the record.
+void binlog_write(const binlog_site_t *site, ...) {
+    binlog_sink_t sink = g_binlog_sink;
+    if (!sink || esp_log_level_get(*site->tag) < site->level) {
+        return;
+    }
+    
+    uint8_t record[BINLOG_RECORD_MAX_SIZE];
+    binlog_cursor_t cursor = { .p = record, .end = record + sizeof(record) };
+    uint32_t timestamp = esp_log_timestamp();
+    binlog_put_u32(&cursor, (uint32_t)(uintptr_t)site);
+    binlog_put_u32(&cursor, timestamp);
+    uint8_t *argument_length = cursor.p++;
+    
+    va_list args;
+    va_start(args, site);
+    va_list args_copy;
+    va_copy(args_copy, args);
+    bool complete = binlog_put_arguments(&cursor, site->format, args_copy);
+    va_end(args_copy);
+    
+    *argument_length = (uint8_t)(cursor.p - argument_length - 1) | (complete ? 0 : BINLOG_ARGS_TRUNCATED);
+    sink(site, record, cursor.p - record);
+    
+    if (site->level <= BINLOG_ECHO_LEVEL) {
+        binlog_echo(site, timestamp, args);
+    }
+    va_end(args);
+}
+
+void binlog_get_header(uint8_t *header) {
+    memcpy(header, g_binlog_header, BINLOG_HEADER_SIZE);
+}
+
+void binlog_make_header(uint8_t *header, const uint8_t *elf_sha256) {
+    memcpy(header, BINLOG_MAGIC, 2);
+    header[2] = BINLOG_VERSION;
+    memcpy(header + 3, elf_sha256, 4);
+}
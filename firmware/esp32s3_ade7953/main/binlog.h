@@ -0,0 +1,72 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_log.h"
+
+// Deferred (binary) logging: a BINLOG_x call forwards the address of its static site descriptor,
+// a timestamp and the raw arguments; the format string is not expanded for forwarding.
+// The firmware ELF is the table from site address to format, tag, file and line, and
+// tools/log_decoder.py turns the records on .../logs/binary/{level} back into log lines.
+// The sink also keeps the record in the crash log, unformatted. Only sites at BINLOG_ECHO_LEVEL or more
+// severe are formatted for the console, straight to it with binlog_echoing() set so the log hook skips them.
+// Without a sink (before MQTT forwarding starts, or with binary logs off) a site logs as ESP_LOGx.
+#define BINLOG_SITE_MAGIC               0x53474C42  // "BLGS", marks a site descriptor in the ELF
+#define BINLOG_RECORD_MAX_SIZE          128         // Site, timestamp, argument length and arguments
+#define BINLOG_RECORD_HEADER_SIZE       9           // Site address, timestamp, argument length
+#define BINLOG_ARGS_TRUNCATED           0x80        // Flag in the argument length byte: later arguments are missing
+#define BINLOG_ECHO_LEVEL               ESP_LOG_WARN    // Raise to ESP_LOG_VERBOSE to see every site on the console
+#define BINLOG_ECHO_FORMAT_SIZE         256         // Console format with the line prefix, on the caller's stack
+
+// Payload header in front of the records of one MQTT message
+#define BINLOG_MAGIC                    "BL"
+#define BINLOG_VERSION                  1
+#define BINLOG_HEADER_SIZE              7           // Magic, version, first 4 bytes of the ELF SHA-256
+
+// One per call site, in flash. Layout is read by the decoder: keep it in step with SITE in tools/log_decoder.py.
+typedef struct {
+    uint32_t magic;
+    uint8_t level;                      // esp_log_level_t
+    uint16_t line;
+    const char *const *tag;             // The caller's TAG variable, a string literal is not a constant here
+    const char *format;
+    const char *file;
+} binlog_site_t;
+
+// Takes a finished record of site; returns false if it was dropped
+typedef bool (*binlog_sink_t)(const binlog_site_t *site, const uint8_t *record, size_t length);
+
+// Arguments are evaluated once on either path. Integers, pointers, doubles and %s are supported
+// (strings are copied, cut to fit the record); %n and wide characters are not.
+#define BINLOG_LEVEL(level, tag, format, ...) do {                                  \
+        static const binlog_site_t binlog_site = {                                  \
+            BINLOG_SITE_MAGIC, (level), __LINE__, &(tag), (format), __FILE__        \
+        };                                                                          \
+        if (LOG_LOCAL_LEVEL >= (level)) {                                           \
+            if (binlog_enabled()) {                                                 \
+                binlog_write(&binlog_site, ##__VA_ARGS__);                          \
+            } else {                                                                \
+                ESP_LOG_LEVEL(level, tag, format, ##__VA_ARGS__);                   \
+            }                                                                       \
+        }                                                                           \
+    } while (0)
+
+#define BINLOG_E(tag, format, ...) BINLOG_LEVEL(ESP_LOG_ERROR, tag, format, ##__VA_ARGS__)
+#define BINLOG_W(tag, format, ...) BINLOG_LEVEL(ESP_LOG_WARN, tag, format, ##__VA_ARGS__)
+#define BINLOG_I(tag, format, ...) BINLOG_LEVEL(ESP_LOG_INFO, tag, format, ##__VA_ARGS__)
+#define BINLOG_D(tag, format, ...) BINLOG_LEVEL(ESP_LOG_DEBUG, tag, format, ##__VA_ARGS__)
+#define BINLOG_V(tag, format, ...) BINLOG_LEVEL(ESP_LOG_VERBOSE, tag, format, ##__VA_ARGS__)
+
+// Function prototypes
+void binlog_set_sink(binlog_sink_t sink);
+bool binlog_enabled(void);
+void binlog_write(const binlog_site_t *site, ...);
+
+// True on the task whose BINLOG_x line is being printed, the record is already with the sink
+bool binlog_echoing(void);
+
+// Payload header for the running firmware, or for the build with the given leading ELF SHA-256 bytes
+// (records kept over a reset), BINLOG_HEADER_SIZE bytes
+void binlog_get_header(uint8_t *header);
+void binlog_make_header(uint8_t *header, const uint8_t *elf_sha256);
@@ -0,0 +1,188 @@
+#include "crash_log.h"
+#include <string.h>
+#include <sys/param.h>
+#include "esp_app_desc.h"
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_rom_crc.h"
+#include "esp_system.h"
+#include "freertos/FreeRTOS.h"
+
+static const char *TAG = "crash_log";
+
+static __NOINIT_ATTR crash_log_bank_t g_crash_log_banks[2];
+static crash_log_bank_t *g_crash_log_active = NULL;         // NULL until crash_log_init
+static crash_log_bank_t *g_crash_log_previous = NULL;       // NULL if there is nothing to send
+static portMUX_TYPE g_crash_log_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static uint32_t crash_log_crc(const crash_log_bank_t *bank) {
+    return esp_rom_crc32_le(0, (const uint8_t *)bank, offsetof(crash_log_bank_t, crc));
+}
+
+// Header intact and offsets in range; the oldest record may still be cut if the reset came mid-write
+static bool crash_log_valid(const crash_log_bank_t *bank) {
+    return bank->magic == CRASH_LOG_MAGIC && bank->head < CRASH_LOG_SIZE && bank->tail < CRASH_LOG_SIZE &&
+           bank->used <= CRASH_LOG_SIZE && bank->crc == crash_log_crc(bank);
+}
+
+// Append at head, wrapping
+static void crash_log_put(crash_log_bank_t *bank, const void *data, size_t length) {
+    const uint8_t *bytes = data;
+    size_t first = MIN(length, CRASH_LOG_SIZE - bank->head);
+    
+    memcpy(bank->data + bank->head, bytes, first);
+    memcpy(bank->data, bytes + first, length - first);
+    bank->head = (bank->head + length) % CRASH_LOG_SIZE;
+}
+
+// Read at offset, wrapping
+static void crash_log_get(const crash_log_bank_t *bank, uint32_t offset, void *data, size_t length) {
+    uint8_t *bytes = data;
+    size_t first = MIN(length, CRASH_LOG_SIZE - offset);
+    
+    memcpy(bytes, bank->data + offset, first);
+    memcpy(bytes + first, bank->data, length - first);
+}
+
+static void crash_log_reset(crash_log_bank_t *bank, uint32_t sequence) {
+    bank->magic = CRASH_LOG_MAGIC;
+    bank->sequence = sequence;
+    bank->head = 0;
+    bank->tail = 0;
+    bank->used = 0;
+    memcpy(bank->elf_sha256, esp_app_get_description()->app_elf_sha256, CRASH_LOG_ELF_SHA256_SIZE);
+    bank->crc = crash_log_crc(bank);
+}
+
+// Keep the newest bank with records from before the reset and start writing into the other one
+void crash_log_init(void) {
+    crash_log_bank_t *previous = NULL;
+    uint32_t sequence = 0;
+    
+    // After power-on the RAM holds whatever it came up with, a valid CRC there would be chance
+    if (esp_reset_reason() != ESP_RST_POWERON) {
+        for (int i = 0; i < 2; i++) {
+            crash_log_bank_t *bank = &g_crash_log_banks[i];
+            if (!crash_log_valid(bank)) {
+                continue;
+            }
+            sequence = MAX(sequence, bank->sequence);
+            if (bank->used > 0 && (!previous || bank->sequence > previous->sequence)) {
+                previous = bank;
+            }
+        }
+    }
+    
+    crash_log_bank_t *active = previous == &g_crash_log_banks[0] ? &g_crash_log_banks[1] : &g_crash_log_banks[0];
+    crash_log_reset(active, sequence + 1);
+    if (!previous) {
+        crash_log_bank_t *other = active == &g_crash_log_banks[0] ? &g_crash_log_banks[1] : &g_crash_log_banks[0];
+        other->magic = 0;
+    }
+    
+    g_crash_log_previous = previous;
+    g_crash_log_active = active;
+    
+    if (previous) {
+        ESP_LOGI(TAG, "Crash log: %lu bytes of records from before the reset", previous->used);
+    }
+}
+
+// Append a record on any task, dropping the oldest records to make room
+static void crash_log_append(crash_log_record_type_t type, int64_t timestamp_us, const void *data, size_t length) {
+    crash_log_bank_t *bank = g_crash_log_active;
+    if (!bank) {
+        return;
+    }
+    
+    if (length > CRASH_LOG_LINE_MAX_SIZE) {
+        length = CRASH_LOG_LINE_MAX_SIZE;
+    }
+    uint8_t header[CRASH_LOG_RECORD_HEADER_SIZE];
+    header[0] = (uint8_t)type;
+    header[1] = (uint8_t)length;
+    for (int i = 0; i < 8; i++) {
+        header[2 + i] = (uint8_t)((uint64_t)timestamp_us >> (8 * i));
+    }
+    uint32_t record_size = CRASH_LOG_RECORD_HEADER_SIZE + length;
+    
+    taskENTER_CRITICAL(&g_crash_log_lock);
+    while (CRASH_LOG_SIZE - bank->used < record_size) {
+        uint32_t oldest_size = CRASH_LOG_RECORD_HEADER_SIZE + bank->data[(bank->tail + 1) % CRASH_LOG_SIZE];
+        bank->tail = (bank->tail + oldest_size) % CRASH_LOG_SIZE;
+        bank->used -= oldest_size;
+    }
+    crash_log_put(bank, header, sizeof(header));
+    crash_log_put(bank, data, length);
+    bank->used += record_size;
+    bank->crc = crash_log_crc(bank);
+    taskEXIT_CRITICAL(&g_crash_log_lock);
+}
+
+// Called for every text log line on any task
+void crash_log_write(int64_t timestamp_us, const char *line, size_t length) {
+    crash_log_append(CRASH_LOG_RECORD_TEXT, timestamp_us, line, length);
+}
+
+// Called for every BINLOG_x record, nothing is formatted
+void crash_log_write_binlog(int64_t timestamp_us, const uint8_t *record, size_t length) {
+    crash_log_append(CRASH_LOG_RECORD_BINLOG, timestamp_us, record, length);
+}
+
+bool crash_log_has_previous(void) {
+    return g_crash_log_previous != NULL;
+}
+
+// The build that wrote the previous boot's binlog records, for the payload header they are sent with
+void crash_log_previous_elf_sha256(uint8_t *elf_sha256) {
+    memcpy(elf_sha256, g_crash_log_previous ? g_crash_log_previous->elf_sha256 : esp_app_get_description()->app_elf_sha256,
+           CRASH_LOG_ELF_SHA256_SIZE);
+}
+
+void crash_log_cursor_init(crash_log_cursor_t *cursor) {
+    cursor->offset = g_crash_log_previous ? g_crash_log_previous->tail : 0;
+    cursor->remaining = g_crash_log_previous ? g_crash_log_previous->used : 0;
+}
+
+// Next record, cut to size (a text line keeps room for its NUL); false at the end or at a record the
+// reset cut short
+bool crash_log_next(crash_log_cursor_t *cursor, int64_t *timestamp_us, crash_log_record_type_t *type,
+                    uint8_t *data, size_t size, size_t *length) {
+    const crash_log_bank_t *bank = g_crash_log_previous;
+    if (!bank || cursor->remaining < CRASH_LOG_RECORD_HEADER_SIZE || size == 0) {
+        return false;
+    }
+    
+    uint8_t header[CRASH_LOG_RECORD_HEADER_SIZE];
+    crash_log_get(bank, cursor->offset, header, sizeof(header));
+    uint32_t record_size = CRASH_LOG_RECORD_HEADER_SIZE + header[1];
+    if (record_size > cursor->remaining ||
+        (header[0] != CRASH_LOG_RECORD_TEXT && header[0] != CRASH_LOG_RECORD_BINLOG)) {
+        return false;
+    }
+    
+    uint64_t timestamp = 0;
+    for (int i = 0; i < 8; i++) {
+        timestamp |= (uint64_t)header[2 + i] << (8 * i);
+    }
+    *timestamp_us = (int64_t)timestamp;
+    *type = (crash_log_record_type_t)header[0];
+    
+    *length = MIN((size_t)header[1], *type == CRASH_LOG_RECORD_TEXT ? size - 1 : size);
+    crash_log_get(bank, (cursor->offset + CRASH_LOG_RECORD_HEADER_SIZE) % CRASH_LOG_SIZE, data, *length);
+    if (*type == CRASH_LOG_RECORD_TEXT) {
+        data[*length] = '\0';
+    }
+    
+    cursor->offset = (cursor->offset + record_size) % CRASH_LOG_SIZE;
+    cursor->remaining -= record_size;
+    return true;
+}
+
+// The previous boot's records are sent, a later reset must not send them again
+void crash_log_release_previous(void) {
+    if (g_crash_log_previous) {
+        g_crash_log_previous->magic = 0;
+        g_crash_log_previous = NULL;
+    }
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Log ring in no-init RAM: kept through software resets, panics and watchdog resets (not power loss).
+// Two banks, one written by this boot and one holding the previous boot's lines until they are sent.
+// A bank counts only with its magic and a matching header CRC, so RAM left random by power-on is ignored.
+#define CRASH_LOG_MAGIC             0x324C5243  // "CRL2"
+#define CRASH_LOG_SIZE              4096        // Bytes of records per bank, the last few seconds before a reset at the default levels
+#define CRASH_LOG_LINE_MAX_SIZE     255         // Longer lines are cut
+#define CRASH_LOG_ELF_SHA256_SIZE   4           // Leading bytes of the ELF SHA-256 of the build that wrote the bank
+
+// Record: uint8 type, uint8 data length, int64 unix time in microseconds, data (little-endian).
+// Text is a log line without NUL, a binlog record is kept as written (see binlog.h).
+#define CRASH_LOG_RECORD_HEADER_SIZE 10
+
+typedef enum {
+    CRASH_LOG_RECORD_TEXT = 0,
+    CRASH_LOG_RECORD_BINLOG = 1
+} crash_log_record_type_t;
+
+// Bank in no-init RAM, offsets are into data and wrap
+typedef struct {
+    uint32_t magic;
+    uint32_t sequence;                  // Boots since the banks were last empty, the higher valid bank is the newer
+    uint32_t head;                      // Where the next record goes
+    uint32_t tail;                      // Oldest record
+    uint32_t used;                      // Bytes from tail to head
+    uint8_t elf_sha256[CRASH_LOG_ELF_SHA256_SIZE];  // Build the binlog records belong to
+    uint32_t crc;                       // CRC-32 of the fields above
+    uint8_t data[CRASH_LOG_SIZE];
+} crash_log_bank_t;
+
+// Position in the previous boot's records
+typedef struct {
+    uint32_t offset;
+    uint32_t remaining;
+} crash_log_cursor_t;
+
+// Function prototypes
+void crash_log_init(void);
+void crash_log_write(int64_t timestamp_us, const char *line, size_t length);
+void crash_log_write_binlog(int64_t timestamp_us, const uint8_t *record, size_t length);
+
+// Previous boot's records, oldest first. Read them with a cursor, then release the bank.
+// A text record comes back NUL-terminated, a binlog record as the bytes written.
+bool crash_log_has_previous(void);
+void crash_log_previous_elf_sha256(uint8_t *elf_sha256);
+void crash_log_cursor_init(crash_log_cursor_t *cursor);
+bool crash_log_next(crash_log_cursor_t *cursor, int64_t *timestamp_us, crash_log_record_type_t *type,
+                    uint8_t *data, size_t size, size_t *length);
+void crash_log_release_previous(void);
@@ -0,0 +1,454 @@
+#include "dsp.h"
+#include <string.h>
+#include <math.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+
+static const char *TAG = "dsp";
+
+#if !DSP_USE_ESP_DSP
+// Twiddle factors for the largest FFT, smaller sizes use a stride
+static float s_twiddle_cos[DSP_MAX_FFT_SIZE / 2];
+static float s_twiddle_sin[DSP_MAX_FFT_SIZE / 2];
+#endif
+static bool s_initialized = false;
+
+// Initialize FFT tables
+dsp_error_t dsp_init(void) {
+    if (s_initialized) {
+        return DSP_OK;
+    }
+
+#if DSP_USE_ESP_DSP
+    esp_err_t ret = dsps_fft2r_init_fc32(NULL, DSP_MAX_FFT_SIZE);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to initialize esp-dsp FFT: %s", esp_err_to_name(ret));
+        return DSP_ERROR_INIT;
+    }
+#else
+    for (int k = 0; k < DSP_MAX_FFT_SIZE / 2; k++) {
+        double angle = 2.0 * M_PI * k / DSP_MAX_FFT_SIZE;
+        s_twiddle_cos[k] = (float)cos(angle);
+        s_twiddle_sin[k] = (float)sin(angle);
+    }
+#endif
+
+    s_initialized = true;
+    ESP_LOGI(TAG, "DSP initialized (%s backend)", dsp_backend_name());
+    return DSP_OK;
+}
+
+// Name of the active backend
+const char *dsp_backend_name(void) {
+    return DSP_USE_ESP_DSP ? "esp-dsp" : "scalar";
+}
+
+// Convert raw register samples to float
+void dsp_int32_to_float(const int32_t *in, float *out, size_t n, float scale) {
+    for (size_t i = 0; i < n; i++) {
+        out[i] = (float)in[i] * scale;
+    }
+}
+
+// Dot product of two vectors
+float dsp_dotprod(const float *a, const float *b, size_t n) {
+#if DSP_USE_ESP_DSP
+    float result = 0.0f;
+    dsps_dotprod_f32(a, b, &result, (int)n);
+    return result;
+#else
+    // Four independent accumulators, the same summation shape as the vector unit
+    float acc0 = 0.0f, acc1 = 0.0f, acc2 = 0.0f, acc3 = 0.0f;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        acc0 += a[i] * b[i];
+        acc1 += a[i + 1] * b[i + 1];
+        acc2 += a[i + 2] * b[i + 2];
+        acc3 += a[i + 3] * b[i + 3];
+    }
+    for (; i < n; i++) {
+        acc0 += a[i] * b[i];
+    }
+    return (acc0 + acc1) + (acc2 + acc3);
+#endif
+}
+
+// Element-wise product
+void dsp_multiply(const float *a, const float *b, float *out, size_t n) {
+#if DSP_USE_ESP_DSP
+    dsps_mul_f32(a, b, out, (int)n, 1, 1, 1);
+#else
+    for (size_t i = 0; i < n; i++) {
+        out[i] = a[i] * b[i];
+    }
+#endif
+}
+
+// Initialize a decimating FIR filter
+dsp_error_t dsp_fir_decimator_init(dsp_fir_decimator_t *fir, const float *coeffs, float *delay, int num_taps, int decimation) {
+    if (!fir || !coeffs || !delay || num_taps <= 0 || decimation <= 0) {
+        return DSP_ERROR_INVALID_PARAM;
+    }
+    
+    memset(fir, 0, sizeof(dsp_fir_decimator_t));
+    memset(delay, 0, num_taps * sizeof(float));
+    fir->num_taps = num_taps;
+    fir->decimation = decimation;
+
+#if DSP_USE_ESP_DSP
+    if (dsps_fird_init_f32(&fir->fir, (float *)coeffs, delay, num_taps, decimation) != ESP_OK) {
+        return DSP_ERROR_INIT;
+    }
+#else
+    fir->coeffs = coeffs;
+    fir->delay = delay;
+    fir->pos = 0;
+#endif
+
+    return DSP_OK;
+}
+
+// Filter and decimate a block of input samples
+int dsp_fir_decimate(dsp_fir_decimator_t *fir, const float *in, float *out, int len) {
+    int outputs = len / fir->decimation;
+
+#if DSP_USE_ESP_DSP
+    return dsps_fird_f32(&fir->fir, in, out, outputs);
+#else
+    for (int i = 0; i < outputs; i++) {
+        // Push the next decimation inputs into the circular delay line
+        for (int k = 0; k < fir->decimation; k++) {
+            fir->delay[fir->pos] = *in++;
+            if (++fir->pos >= fir->num_taps) {
+                fir->pos = 0;
+            }
+        }
+    
+        // Newest sample pairs with the first coefficient
+        float acc = 0.0f;
+        int index = fir->pos;
+        for (int n = fir->num_taps - 1; n >= 0; n--) {
+            acc += fir->coeffs[n] * fir->delay[index];
+            if (++index >= fir->num_taps) {
+                index = 0;
+            }
+        }
+        out[i] = acc;
+    }
+    return outputs;
+#endif
+}
+
+// Hann window
+void dsp_window_hann(float *window, int n) {
+#if DSP_USE_ESP_DSP
+    dsps_wind_hann_f32(window, n);
+#else
+    for (int i = 0; i < n; i++) {
+        window[i] = 0.5f - 0.5f * cosf(2.0f * (float)M_PI * i / (n - 1));
+    }
+#endif
+}
+
+#if !DSP_USE_ESP_DSP
+// In-place radix-2 complex FFT on interleaved re/im data
+static void dsp_fft_scalar(float *data, int n) {
+    // Bit reversal
+    for (int i = 1, j = 0; i < n; i++) {
+        int bit = n >> 1;
+        for (; j & bit; bit >>= 1) {
+            j ^= bit;
+        }
+        j ^= bit;
+        if (i < j) {
+            float re = data[2 * i], im = data[2 * i + 1];
+            data[2 * i] = data[2 * j];
+            data[2 * i + 1] = data[2 * j + 1];
+            data[2 * j] = re;
+            data[2 * j + 1] = im;
+        }
+    }
+    
+    // Butterflies
+    for (int len = 2; len <= n; len <<= 1) {
+        int half = len >> 1;
+        int stride = DSP_MAX_FFT_SIZE / len;
+        for (int start = 0; start < n; start += len) {
+            for (int k = 0; k < half; k++) {
+                float wr = s_twiddle_cos[k * stride];
+                float wi = -s_twiddle_sin[k * stride];
+                float *a = &data[2 * (start + k)];
+                float *b = &data[2 * (start + k + half)];
+                float tr = b[0] * wr - b[1] * wi;
+                float ti = b[0] * wi + b[1] * wr;
+                b[0] = a[0] - tr;
+                b[1] = a[1] - ti;
+                a[0] += tr;
+                a[1] += ti;
+            }
+        }
+    }
+}
+#endif
+
+// Windowed FFT magnitude spectrum of a real block
+dsp_error_t dsp_fft_magnitude(const float *in, const float *window, int n, float *work, float *magnitude) {
+    if (!s_initialized || n < 2 || n > DSP_MAX_FFT_SIZE || (n & (n - 1)) != 0) {
+        return DSP_ERROR_INVALID_PARAM;
+    }
+    
+    float window_sum = 0.0f;
+    for (int i = 0; i < n; i++) {
+        float w = window ? window[i] : 1.0f;
+        work[2 * i] = in[i] * w;
+        work[2 * i + 1] = 0.0f;
+        window_sum += w;
+    }
+
+#if DSP_USE_ESP_DSP
+    dsps_fft2r_fc32(work, n);
+    dsps_bit_rev_fc32(work, n);
+#else
+    dsp_fft_scalar(work, n);
+#endif
+
+    // Single-sided amplitude, so a full-scale sine at a bin centre reads its peak value
+    float scale = 2.0f / window_sum;
+    for (int k = 0; k <= n / 2; k++) {
+        float re = work[2 * k], im = work[2 * k + 1];
+        magnitude[k] = sqrtf(re * re + im * im) * scale;
+    }
+    magnitude[0] *= 0.5f;
+    magnitude[n / 2] *= 0.5f;
+    
+    return DSP_OK;
+}
+
+// Goertzel filter for a single frequency bin
+void dsp_goertzel(const float *in, int n, float normalized_frequency, float *amplitude, float *phase) {
+    float omega = 2.0f * (float)M_PI * normalized_frequency;
+    float cosine = cosf(omega), sine = sinf(omega);
+    float coeff = 2.0f * cosine;
+    float s1 = 0.0f, s2 = 0.0f;
+    
+    for (int i = 0; i < n; i++) {
+        float s0 = in[i] + coeff * s1 - s2;
+        s2 = s1;
+        s1 = s0;
+    }
+    
+    float re = s1 - s2 * cosine;
+    float im = s2 * sine;
+    
+    if (amplitude) {
+        *amplitude = 2.0f * sqrtf(re * re + im * im) / n;
+    }
+    if (phase) {
+        *phase = atan2f(im, re);
+    }
+}
+
+// Test signal: fundamental at 50 Hz, third harmonic and uniform noise from a fixed seed
+static void dsp_self_test_signal(float *out, int n, uint32_t seed) {
+    const double sample_rate = 6991.3;
+    
+    for (int i = 0; i < n; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        double noise = ((double)(seed >> 8) / (1 << 24) - 0.5) * 0.02;
+        double t = i / sample_rate;
+        out[i] = (float)(0.9 * sin(2.0 * M_PI * 50.0 * t + 0.3) + 0.1 * sin(2.0 * M_PI * 150.0 * t + 1.1) + noise);
+    }
+}
+
+// Log one failed check and count it
+static int dsp_self_test_check(const char *kernel, double error, double tolerance) {
+    if (error <= tolerance) {
+        ESP_LOGD(TAG, "Self-test %s: error %.3g (tolerance %.3g)", kernel, error, tolerance);
+        return 0;
+    }
+    ESP_LOGE(TAG, "Self-test %s: error %.3g above tolerance %.3g", kernel, error, tolerance);
+    return 1;
+}
+
+// Check each kernel of the active backend against a double-precision reference
+int dsp_self_test(void) {
+    const int n = DSP_SELF_TEST_BLOCK_SIZE;
+    const int fft_n = DSP_SELF_TEST_FFT_SIZE;
+    float *a = heap_caps_malloc(n * sizeof(float), MALLOC_CAP_INTERNAL);
+    float *b = heap_caps_malloc(n * sizeof(float), MALLOC_CAP_INTERNAL);
+    float *out = heap_caps_malloc(n * sizeof(float), MALLOC_CAP_INTERNAL);
+    float *work = heap_caps_malloc(2 * fft_n * sizeof(float), MALLOC_CAP_INTERNAL);
+    float coeffs[DSP_BENCHMARK_FIR_TAPS];
+    float delay[DSP_BENCHMARK_FIR_TAPS];
+    dsp_fir_decimator_t fir;
+    int failures = 0;
+    double error;
+    
+    if (!a || !b || !out || !work || dsp_init() != DSP_OK) {
+        ESP_LOGE(TAG, "DSP self-test setup failed");
+        failures = 1;
+        goto cleanup;
+    }
+    
+    dsp_self_test_signal(a, n, 1);
+    dsp_self_test_signal(b, n, 2);
+    
+    // Dot product
+    double sum = 0.0, magnitude_sum = 0.0;
+    for (int i = 0; i < n; i++) {
+        sum += (double)a[i] * b[i];
+        magnitude_sum += fabs((double)a[i] * b[i]);
+    }
+    failures += dsp_self_test_check("dotprod", fabs(dsp_dotprod(a, b, n) - sum) / magnitude_sum,
+                                    DSP_SELF_TEST_DOTPROD_TOLERANCE);
+    
+    // Element-wise product
+    dsp_multiply(a, b, out, n);
+    error = 0.0;
+    for (int i = 0; i < n; i++) {
+        error = fmax(error, fabs(out[i] - (double)a[i] * b[i]));
+    }
+    failures += dsp_self_test_check("multiply", error, DSP_SELF_TEST_MULTIPLY_TOLERANCE);
+    
+    // FIR decimation against direct convolution from a zero history. Decaying taps, so reversed taps fail.
+    double coeff_sum = 0.0;
+    for (int k = 0; k < DSP_BENCHMARK_FIR_TAPS; k++) {
+        coeffs[k] = expf(-0.1f * k);
+        coeff_sum += coeffs[k];
+    }
+    for (int k = 0; k < DSP_BENCHMARK_FIR_TAPS; k++) {
+        coeffs[k] = (float)(coeffs[k] / coeff_sum);
+    }
+    dsp_fir_decimator_init(&fir, coeffs, delay, DSP_BENCHMARK_FIR_TAPS, DSP_BENCHMARK_DECIMATION);
+    int outputs = dsp_fir_decimate(&fir, a, out, n);
+    error = outputs == n / DSP_BENCHMARK_DECIMATION ? 0.0 : INFINITY;
+    for (int m = 0; m < outputs; m++) {
+        int newest = m * DSP_BENCHMARK_DECIMATION + DSP_BENCHMARK_DECIMATION - 1;
+        double expected = 0.0;
+        for (int k = 0; k < DSP_BENCHMARK_FIR_TAPS && k <= newest; k++) {
+            expected += (double)coeffs[k] * a[newest - k];
+        }
+        error = fmax(error, fabs(out[m] - expected));
+    }
+    failures += dsp_self_test_check("FIR", error, DSP_SELF_TEST_FIR_TOLERANCE);
+    
+    // Hann-windowed FFT magnitude against a direct DFT with the same scaling
+    dsp_window_hann(b, fft_n);
+    if (dsp_fft_magnitude(a, b, fft_n, work, out) != DSP_OK) {
+        failures += dsp_self_test_check("FFT", INFINITY, DSP_SELF_TEST_FFT_TOLERANCE);
+    } else {
+        double window_sum = 0.0;
+        for (int i = 0; i < fft_n; i++) {
+            window_sum += b[i];
+        }
+        error = 0.0;
+        for (int k = 0; k <= fft_n / 2; k++) {
+            double re = 0.0, im = 0.0;
+            for (int i = 0; i < fft_n; i++) {
+                double angle = 2.0 * M_PI * (double)((k * i) % fft_n) / fft_n;
+                re += (double)a[i] * b[i] * cos(angle);
+                im -= (double)a[i] * b[i] * sin(angle);
+            }
+            double expected = sqrt(re * re + im * im) * (k == 0 || k == fft_n / 2 ? 1.0 : 2.0) / window_sum;
+            error = fmax(error, fabs(out[k] - expected));
+        }
+        failures += dsp_self_test_check("FFT", error, DSP_SELF_TEST_FFT_TOLERANCE);
+    }
+    
+    // Goertzel against the DFT projection at the fundamental and third harmonic, off the bin centres.
+    // The recurrence refers the phase to the last sample.
+    const double frequencies[] = { 50.0 / 6991.3, 150.0 / 6991.3 };
+    double amplitude_error = 0.0, phase_error = 0.0;
+    for (size_t f = 0; f < sizeof(frequencies) / sizeof(frequencies[0]); f++) {
+        double re = 0.0, im = 0.0;
+        for (int i = 0; i < n; i++) {
+            double angle = 2.0 * M_PI * frequencies[f] * (n - 1 - i);
+            re += a[i] * cos(angle);
+            im += a[i] * sin(angle);
+        }
+        float amplitude, phase;
+        dsp_goertzel(a, n, (float)frequencies[f], &amplitude, &phase);
+        amplitude_error = fmax(amplitude_error, fabs(amplitude - 2.0 * sqrt(re * re + im * im) / n));
+        phase_error = fmax(phase_error, fabs(remainder(phase - atan2(im, re), 2.0 * M_PI)));
+    }
+    failures += dsp_self_test_check("Goertzel amplitude", amplitude_error, DSP_SELF_TEST_GOERTZEL_TOLERANCE);
+    failures += dsp_self_test_check("Goertzel phase", phase_error, DSP_SELF_TEST_PHASE_TOLERANCE);
+    
+    if (failures == 0) {
+        ESP_LOGI(TAG, "DSP self-test passed (%s backend)", dsp_backend_name());
+    } else {
+        ESP_LOGE(TAG, "DSP self-test: %d checks failed (%s backend)", failures, dsp_backend_name());
+    }
+
+cleanup:
+    heap_caps_free(a);
+    heap_caps_free(b);
+    heap_caps_free(out);
+    heap_caps_free(work);
+    return failures;
+}
+
+// Measure per-block time of each kernel
+void dsp_benchmark(uint32_t iterations) {
+    const int n = DSP_BENCHMARK_BLOCK_SIZE;
+    float *input = heap_caps_malloc(n * sizeof(float), MALLOC_CAP_INTERNAL);
+    float *window = heap_caps_malloc(n * sizeof(float), MALLOC_CAP_INTERNAL);
+    float *work = heap_caps_malloc(2 * n * sizeof(float), MALLOC_CAP_INTERNAL);
+    float *output = heap_caps_malloc((n / 2 + 1) * sizeof(float), MALLOC_CAP_INTERNAL);
+    float coeffs[DSP_BENCHMARK_FIR_TAPS];
+    float delay[DSP_BENCHMARK_FIR_TAPS];
+    dsp_fir_decimator_t fir;
+    
+    if (!input || !window || !work || !output || dsp_init() != DSP_OK) {
+        ESP_LOGE(TAG, "DSP benchmark setup failed");
+        goto cleanup;
+    }
+    
+    for (int i = 0; i < n; i++) {
+        input[i] = sinf(2.0f * (float)M_PI * 50.0f * i / 6991.3f);
+    }
+    for (int i = 0; i < DSP_BENCHMARK_FIR_TAPS; i++) {
+        coeffs[i] = 1.0f / DSP_BENCHMARK_FIR_TAPS;
+    }
+    dsp_window_hann(window, n);
+    dsp_fir_decimator_init(&fir, coeffs, delay, DSP_BENCHMARK_FIR_TAPS, DSP_BENCHMARK_DECIMATION);
+    
+    volatile float sink = 0.0f;
+    int64_t start_us = esp_timer_get_time();
+    for (uint32_t i = 0; i < iterations; i++) {
+        sink += dsp_dotprod(input, window, n);
+    }
+    int64_t dotprod_us = esp_timer_get_time() - start_us;
+    
+    start_us = esp_timer_get_time();
+    for (uint32_t i = 0; i < iterations; i++) {
+        dsp_fir_decimate(&fir, input, output, n);
+    }
+    int64_t fir_us = esp_timer_get_time() - start_us;
+    
+    start_us = esp_timer_get_time();
+    for (uint32_t i = 0; i < iterations; i++) {
+        dsp_fft_magnitude(input, window, n, work, output);
+    }
+    int64_t fft_us = esp_timer_get_time() - start_us;
+    
+    start_us = esp_timer_get_time();
+    for (uint32_t i = 0; i < iterations; i++) {
+        float amplitude;
+        dsp_goertzel(input, n, 50.0f / 6991.3f, &amplitude, NULL);
+        sink += amplitude;
+    }
+    int64_t goertzel_us = esp_timer_get_time() - start_us;
+    (void)sink;
+    
+    ESP_LOGI(TAG, "DSP benchmark (%s, %d samples, %lu runs): dotprod %.1f us, FIR/%d %.1f us, FFT %.1f us, Goertzel %.1f us",
+             dsp_backend_name(), n, iterations, (double)dotprod_us / iterations, DSP_BENCHMARK_DECIMATION,
+             (double)fir_us / iterations, (double)fft_us / iterations, (double)goertzel_us / iterations);
+
+cleanup:
+    heap_caps_free(input);
+    heap_caps_free(window);
+    heap_caps_free(work);
+    heap_caps_free(output);
+}
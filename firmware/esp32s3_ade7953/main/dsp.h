@@ -0,0 +1,82 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "sdkconfig.h"
+
+// Backend selection: esp-dsp (ESP32-S3 PIE vector instructions) on target, portable scalar C elsewhere
+#if defined(CONFIG_IDF_TARGET_ESP32S3) && !defined(DSP_FORCE_SCALAR)
+#define DSP_USE_ESP_DSP 1
+#include "esp_dsp.h"
+#else
+#define DSP_USE_ESP_DSP 0
+#endif
+
+// FFT configuration
+#define DSP_MAX_FFT_SIZE        2048    // Largest supported FFT (power of two), sizes the twiddle table
+
+// Benchmark configuration
+#define DSP_BENCHMARK_BLOCK_SIZE    1024
+#define DSP_BENCHMARK_FIR_TAPS      32
+#define DSP_BENCHMARK_DECIMATION    4
+
+// Self-test configuration: every kernel of the active backend against a double-precision reference on
+// the same signals (50 Hz with a third harmonic and noise, about 1.0 peak). Errors are absolute, in signal units,
+// except the dot product, which is relative to the sum of the absolute products.
+#define DSP_SELF_TEST_BLOCK_SIZE            1024
+#define DSP_SELF_TEST_FFT_SIZE              256     // The reference DFT is O(n^2) in double
+#define DSP_SELF_TEST_DOTPROD_TOLERANCE     1e-5
+#define DSP_SELF_TEST_MULTIPLY_TOLERANCE    1e-6
+#define DSP_SELF_TEST_FIR_TOLERANCE         1e-5
+#define DSP_SELF_TEST_FFT_TOLERANCE         1e-5
+#define DSP_SELF_TEST_GOERTZEL_TOLERANCE    1e-4    // Amplitude; the float recurrence loses precision at low frequencies
+#define DSP_SELF_TEST_PHASE_TOLERANCE       1e-3    // Radians, about 0.06 degrees
+
+// Error codes
+typedef enum {
+    DSP_OK = 0,
+    DSP_ERROR_INIT = -1,
+    DSP_ERROR_INVALID_PARAM = -2
+} dsp_error_t;
+
+// Decimating FIR filter state (caller owns coefficient and delay line storage, both num_taps long)
+typedef struct {
+#if DSP_USE_ESP_DSP
+    fir_f32_t fir;
+#else
+    const float *coeffs;
+    float *delay;
+    int pos;
+#endif
+    int num_taps;
+    int decimation;
+} dsp_fir_decimator_t;
+
+// Function prototypes
+
+// Initialization (FFT twiddle tables)
+dsp_error_t dsp_init(void);
+const char *dsp_backend_name(void);
+
+// Vector primitives
+void dsp_int32_to_float(const int32_t *in, float *out, size_t n, float scale);
+float dsp_dotprod(const float *a, const float *b, size_t n);
+void dsp_multiply(const float *a, const float *b, float *out, size_t n);
+
+// FIR decimation - len input samples (multiple of the decimation factor), returns the number of outputs
+dsp_error_t dsp_fir_decimator_init(dsp_fir_decimator_t *fir, const float *coeffs, float *delay, int num_taps, int decimation);
+int dsp_fir_decimate(dsp_fir_decimator_t *fir, const float *in, float *out, int len);
+
+// Windowed FFT - work must hold 2 * n floats, magnitude receives n / 2 + 1 bins (peak amplitude units)
+void dsp_window_hann(float *window, int n);
+dsp_error_t dsp_fft_magnitude(const float *in, const float *window, int n, float *work, float *magnitude);
+
+// Goertzel - amplitude and phase of one arbitrary frequency (cycles per sample) over a block
+void dsp_goertzel(const float *in, int n, float normalized_frequency, float *amplitude, float *phase);
+
+// Check each kernel against the reference (failures are logged), returns the number of failed checks
+int dsp_self_test(void);
+
+// Measure per-block time of each kernel (results are logged)
+void dsp_benchmark(uint32_t iterations);
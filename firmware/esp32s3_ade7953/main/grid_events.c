@@ -0,0 +1,243 @@
+#include "grid_events.h"
+#include <string.h>
+#include <math.h>
+#include "esp_log.h"
+
+static const char *TAG = "grid_events";
+
+// Fill a configuration with the default thresholds
+void grid_events_default_config(grid_events_config_t *config) {
+    if (!config) {
+        return;
+    }
+    
+    config->nominal_frequency = GRID_EVENTS_DEFAULT_NOMINAL_FREQUENCY;
+    config->frequency_deviation = GRID_EVENTS_DEFAULT_FREQUENCY_DEVIATION;
+    config->rocof = GRID_EVENTS_DEFAULT_ROCOF;
+    config->nominal_voltage = GRID_EVENTS_DEFAULT_NOMINAL_VOLTAGE;
+    config->sag_ratio = GRID_EVENTS_DEFAULT_SAG_RATIO;
+    config->swell_ratio = GRID_EVENTS_DEFAULT_SWELL_RATIO;
+    config->pre_trigger_ms = GRID_EVENTS_DEFAULT_PRE_TRIGGER_MS;
+    config->post_trigger_ms = GRID_EVENTS_DEFAULT_POST_TRIGGER_MS;
+}
+
+// Initialize the detector (config may be NULL for the defaults)
+grid_events_error_t grid_events_init(grid_events_t *events, const grid_events_config_t *config) {
+    if (!events) {
+        return GRID_EVENTS_ERROR_INVALID_PARAM;
+    }
+    
+    QueueHandle_t output_queue = events->output_queue;
+    memset(events, 0, sizeof(grid_events_t));
+    events->output_queue = output_queue;
+    
+    if (config) {
+        return grid_events_set_config(events, config);
+    }
+    grid_events_default_config(&events->config);
+    return GRID_EVENTS_OK;
+}
+
+// Replace the thresholds, an event being recorded keeps going with the new post-trigger length
+grid_events_error_t grid_events_set_config(grid_events_t *events, const grid_events_config_t *config) {
+    if (!events || !config || config->nominal_frequency <= 0.0f || config->nominal_voltage <= 0.0f) {
+        return GRID_EVENTS_ERROR_INVALID_PARAM;
+    }
+    
+    events->config = *config;
+    return GRID_EVENTS_OK;
+}
+
+// Set the queue that receives grid_event_record_t pointers
+void grid_events_set_queue(grid_events_t *events, QueueHandle_t output_queue) {
+    if (events) {
+        events->output_queue = output_queue;
+    }
+}
+
+// Least-squares slope of the last GRID_EVENTS_ROCOF_WINDOW samples, in Hz/s
+static float grid_events_rocof(const grid_events_t *events) {
+    const grid_events_sample_t *last = &events->ring[(events->head + GRID_EVENTS_RING_SIZE - 1) % GRID_EVENTS_RING_SIZE];
+    double sum_x = 0.0, sum_y = 0.0, sum_xx = 0.0, sum_xy = 0.0;
+    const int n = GRID_EVENTS_ROCOF_WINDOW;
+    
+    // Relative to the newest sample, so that float frequencies and wall-clock timestamps keep their precision
+    for (int i = 0; i < n; i++) {
+        const grid_events_sample_t *s = &events->ring[(events->head + GRID_EVENTS_RING_SIZE - 1 - i) % GRID_EVENTS_RING_SIZE];
+        double x = (s->timestamp_us - last->timestamp_us) * 1e-6;
+        double y = s->frequency - last->frequency;
+        sum_x += x;
+        sum_y += y;
+        sum_xx += x * x;
+        sum_xy += x * y;
+    }
+    
+    double denominator = n * sum_xx - sum_x * sum_x;
+    if (denominator <= 0.0) {
+        return 0.0f;
+    }
+    return (float)((n * sum_xy - sum_x * sum_y) / denominator);
+}
+
+// Thresholds exceeded by one sample
+static uint32_t grid_events_check(const grid_events_config_t *config, const grid_events_sample_t *sample, bool rocof_valid) {
+    uint32_t causes = 0;
+    
+    if (config->frequency_deviation > 0.0f &&
+        fabsf(sample->frequency - config->nominal_frequency) > config->frequency_deviation) {
+        causes |= GRID_EVENT_CAUSE_FREQUENCY;
+    }
+    if (config->rocof > 0.0f && rocof_valid && fabsf(sample->rocof) > config->rocof) {
+        causes |= GRID_EVENT_CAUSE_ROCOF;
+    }
+    if (config->sag_ratio > 0.0f && sample->voltage < config->nominal_voltage * config->sag_ratio) {
+        causes |= GRID_EVENT_CAUSE_SAG;
+    }
+    if (config->swell_ratio > 0.0f && sample->voltage > config->nominal_voltage * config->swell_ratio) {
+        causes |= GRID_EVENT_CAUSE_SWELL;
+    }
+    
+    return causes;
+}
+
+// Copy the pre- and post-trigger samples out of the ring and hand the record to the publisher
+static void grid_events_freeze(grid_events_t *events) {
+    grid_event_record_t *record = &events->record;
+    size_t since_trigger = (events->head + GRID_EVENTS_RING_SIZE - events->trigger_position) % GRID_EVENTS_RING_SIZE;
+    size_t older = events->count - since_trigger;
+    int64_t pre_start_us = events->trigger_sample.timestamp_us - (int64_t)events->config.pre_trigger_ms * 1000;
+    
+    events->event_count++;
+    if (record->busy || !events->output_queue) {
+        events->dropped_count++;
+        ESP_LOGW(TAG, "Event %lu dropped, publisher busy", events->event_count);
+        return;
+    }
+    
+    // Walk back from the trigger for the pre-trigger history
+    size_t pre = 0;
+    while (pre < older) {
+        size_t position = (events->trigger_position + GRID_EVENTS_RING_SIZE - pre - 1) % GRID_EVENTS_RING_SIZE;
+        if (events->ring[position].timestamp_us < pre_start_us) {
+            break;
+        }
+        pre++;
+    }
+    
+    // At most two contiguous pieces of the ring
+    size_t start = (events->trigger_position + GRID_EVENTS_RING_SIZE - pre) % GRID_EVENTS_RING_SIZE;
+    size_t total = pre + since_trigger;
+    size_t first = total < GRID_EVENTS_RING_SIZE - start ? total : GRID_EVENTS_RING_SIZE - start;
+    memcpy(record->samples, &events->ring[start], first * sizeof(grid_events_sample_t));
+    memcpy(&record->samples[first], events->ring, (total - first) * sizeof(grid_events_sample_t));
+    
+    record->sequence = events->event_count;
+    record->causes = events->pending_causes;
+    record->trigger_timestamp_us = events->trigger_sample.timestamp_us;
+    record->trigger_frequency = events->trigger_sample.frequency;
+    record->trigger_rocof = events->trigger_sample.rocof;
+    record->trigger_voltage = events->trigger_sample.voltage;
+    record->trigger_index = pre;
+    record->sample_count = total;
+    record->busy = true;
+    
+    grid_event_record_t *pointer = record;
+    if (xQueueSend(events->output_queue, &pointer, 0) != pdTRUE) {
+        record->busy = false;
+        events->dropped_count++;
+    }
+}
+
+// Feed one validated per-cycle sample
+float grid_events_push(grid_events_t *events, int64_t timestamp_us, float frequency, float voltage) {
+    if (!events) {
+        return 0.0f;
+    }
+    
+    // Lost samples or a clock step break the slope window
+    if (events->count > 0) {
+        int64_t step_us = timestamp_us - events->ring[(events->head + GRID_EVENTS_RING_SIZE - 1) % GRID_EVENTS_RING_SIZE].timestamp_us;
+        if (step_us <= 0 || step_us > GRID_EVENTS_MAX_GAP_US) {
+            events->rocof_count = 0;
+        }
+    }
+    
+    size_t position = events->head;
+    grid_events_sample_t *sample = &events->ring[position];
+    sample->timestamp_us = timestamp_us;
+    sample->frequency = frequency;
+    sample->voltage = voltage;
+    sample->rocof = 0.0f;
+    
+    events->head = (events->head + 1) % GRID_EVENTS_RING_SIZE;
+    if (events->count < GRID_EVENTS_RING_SIZE) {
+        events->count++;
+    }
+    if (events->rocof_count < GRID_EVENTS_ROCOF_WINDOW) {
+        events->rocof_count++;
+    }
+    
+    bool rocof_valid = events->rocof_count >= GRID_EVENTS_ROCOF_WINDOW;
+    if (rocof_valid) {
+        sample->rocof = grid_events_rocof(events);
+    }
+    
+    uint32_t causes = grid_events_check(&events->config, sample, rocof_valid);
+    
+    if (events->triggered) {
+        events->pending_causes |= causes;
+    
+        // Stop at the post-trigger length, or before the ring overwrites the trigger sample
+        size_t since_trigger = (events->head + GRID_EVENTS_RING_SIZE - events->trigger_position) % GRID_EVENTS_RING_SIZE;
+        if (timestamp_us - events->trigger_sample.timestamp_us >= (int64_t)events->config.post_trigger_ms * 1000 ||
+            since_trigger >= GRID_EVENTS_RING_SIZE - 1) {
+            grid_events_freeze(events);
+            events->triggered = false;
+            events->armed = false;
+            events->clear_count = 0;
+        }
+        return sample->rocof;
+    }
+    
+    // Re-arm only after the grid has been back within all thresholds for a while, so a sustained
+    // excursion produces one event rather than one per capture length
+    if (causes == 0) {
+        if (events->clear_count < GRID_EVENTS_REARM_SAMPLES) {
+            events->clear_count++;
+        }
+        if (events->clear_count >= GRID_EVENTS_REARM_SAMPLES) {
+            events->armed = true;
+        }
+    } else {
+        events->clear_count = 0;
+        if (events->armed) {
+            events->triggered = true;
+            events->armed = false;
+            events->pending_causes = causes;
+            events->trigger_position = position;
+            events->trigger_sample = *sample;
+            ESP_LOGW(TAG, "Grid event triggered (causes 0x%lX): %.4f Hz, %.3f Hz/s, %.1f V",
+                     causes, frequency, sample->rocof, voltage);
+        }
+    }
+    
+    return sample->rocof;
+}
+
+// Give a published record back to the detector
+void grid_events_release(grid_event_record_t *record) {
+    if (record) {
+        record->busy = false;
+    }
+}
+
+// Name of a single trigger cause
+const char *grid_events_cause_name(uint32_t cause) {
+    switch (cause) {
+        case GRID_EVENT_CAUSE_FREQUENCY: return "frequency";
+        case GRID_EVENT_CAUSE_ROCOF:     return "rocof";
+        case GRID_EVENT_CAUSE_SAG:       return "sag";
+        case GRID_EVENT_CAUSE_SWELL:     return "swell";
+        default:                         return "unknown";
+    }
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+
+// Capture configuration
+#define GRID_EVENTS_RING_SIZE               640     // Per-cycle samples kept in RAM (12.8 s at 50 Hz)
+#define GRID_EVENTS_DEFAULT_PRE_TRIGGER_MS  5000    // History frozen before the trigger
+#define GRID_EVENTS_DEFAULT_POST_TRIGGER_MS 5000    // Recording continued after the trigger
+#define GRID_EVENTS_ROCOF_WINDOW            10      // Least-squares slope over 10 cycles (200 ms at 50 Hz)
+#define GRID_EVENTS_MAX_GAP_US              1000000 // A larger step between samples restarts the ROCOF history
+#define GRID_EVENTS_REARM_SAMPLES           50      // Samples below all thresholds before a new event can trigger
+
+// Default thresholds
+#define GRID_EVENTS_DEFAULT_NOMINAL_FREQUENCY   50.0f   // ade7953_set_acquisition_mode() sets the grid's own
+#define GRID_EVENTS_DEFAULT_FREQUENCY_DEVIATION 0.2f    // Hz
+#define GRID_EVENTS_DEFAULT_ROCOF               0.5f    // Hz/s
+#define GRID_EVENTS_DEFAULT_NOMINAL_VOLTAGE     230.0f
+#define GRID_EVENTS_DEFAULT_SAG_RATIO           0.90f   // EN 50160 dip threshold
+#define GRID_EVENTS_DEFAULT_SWELL_RATIO         1.10f   // EN 50160 swell threshold
+
+// Trigger causes (bit mask)
+#define GRID_EVENT_CAUSE_FREQUENCY  (1 << 0)
+#define GRID_EVENT_CAUSE_ROCOF      (1 << 1)
+#define GRID_EVENT_CAUSE_SAG        (1 << 2)
+#define GRID_EVENT_CAUSE_SWELL      (1 << 3)
+
+// Thresholds and capture lengths, a threshold of 0 disables that trigger
+typedef struct {
+    float nominal_frequency;
+    float frequency_deviation;          // |f - nominal| above this trips, Hz
+    float rocof;                        // |df/dt| above this trips, Hz/s
+    float nominal_voltage;
+    float sag_ratio;                    // V below nominal * ratio trips
+    float swell_ratio;                  // V above nominal * ratio trips
+    uint32_t pre_trigger_ms;
+    uint32_t post_trigger_ms;
+} grid_events_config_t;
+
+// One per-cycle point of the capture
+typedef struct {
+    int64_t timestamp_us;
+    float frequency;
+    float voltage;
+    float rocof;                        // Hz/s, 0 until the slope window has filled
+} grid_events_sample_t;
+
+// Frozen event, handed to the publisher by pointer and returned with grid_events_release()
+typedef struct {
+    volatile bool busy;                 // Owned by the publisher until released
+    uint32_t sequence;
+    uint32_t causes;                    // GRID_EVENT_CAUSE_* seen from the trigger to the end of the capture
+    int64_t trigger_timestamp_us;
+    float trigger_frequency;
+    float trigger_rocof;
+    float trigger_voltage;
+    size_t trigger_index;               // Index of the trigger sample in samples[]
+    size_t sample_count;
+    grid_events_sample_t samples[GRID_EVENTS_RING_SIZE];
+} grid_event_record_t;
+
+// Detector state
+typedef struct {
+    grid_events_config_t config;
+    QueueHandle_t output_queue;         // Receives grid_event_record_t pointers
+    
+    // Live ring of per-cycle samples
+    grid_events_sample_t ring[GRID_EVENTS_RING_SIZE];
+    size_t head;                        // Next write position
+    size_t count;
+    size_t rocof_count;                 // Consecutive samples usable for the ROCOF slope
+    
+    // Trigger state
+    bool triggered;
+    bool armed;
+    uint32_t clear_count;
+    uint32_t pending_causes;
+    size_t trigger_position;            // Ring position of the trigger sample
+    grid_events_sample_t trigger_sample;
+    
+    // Statistics
+    uint32_t event_count;
+    uint32_t dropped_count;             // Events lost because the previous record was still being published
+    
+    grid_event_record_t record;
+} grid_events_t;
+
+// Error codes
+typedef enum {
+    GRID_EVENTS_OK = 0,
+    GRID_EVENTS_ERROR_INIT = -1,
+    GRID_EVENTS_ERROR_INVALID_PARAM = -2
+} grid_events_error_t;
+
+// Function prototypes
+void grid_events_default_config(grid_events_config_t *config);
+grid_events_error_t grid_events_init(grid_events_t *events, const grid_events_config_t *config);
+grid_events_error_t grid_events_set_config(grid_events_t *events, const grid_events_config_t *config);
+void grid_events_set_queue(grid_events_t *events, QueueHandle_t output_queue);
+
+// Feed one validated per-cycle sample (acquisition task), returns the ROCOF in Hz/s
+float grid_events_push(grid_events_t *events, int64_t timestamp_us, float frequency, float voltage);
+
+// Give a published record back to the detector
+void grid_events_release(grid_event_record_t *record);
+
+// Names of the trigger causes, for logging and publishing
+const char *grid_events_cause_name(uint32_t cause);
@@ -0,0 +1,157 @@
+#include "harmonics.h"
+#include "dsp.h"
+#include <string.h>
+#include <math.h>
+#include "esp_log.h"
+
+static const char *TAG = "harmonics";
+
+// Analyze the pending window and queue a record
+static void harmonics_analyze(harmonics_analyzer_t *analyzer) {
+    size_t n = analyzer->window_size;
+    float *x = analyzer->buffer;
+    harmonics_record_t record = {
+        .timestamp_us = analyzer->timestamp_us,
+        .frequency = analyzer->frequency,
+    };
+    
+    dsp_int32_to_float(analyzer->samples, x, n, 1.0f);
+    
+    // Total RMS of the window in LSB ties the waveform scale to the calibrated VRMS reading
+    float total_rms = sqrtf(dsp_dotprod(x, x, n) / n);
+    if (total_rms <= 0.0f) {
+        return;
+    }
+    float volts_per_lsb = analyzer->voltage_rms / total_rms;
+    
+    // The window only spans a whole number of cycles to within a sample, so taper it: with a Hann window
+    // the fundamental no longer leaks into the harmonics, and harmonics are 10 bins apart, well clear of
+    // its 2-bin main lobe. Both the fundamental and the harmonics see the same gain, so ratios are unaffected.
+    if (analyzer->window_function_size != n) {
+        dsp_window_hann(analyzer->window, n);
+        analyzer->window_function_size = n;
+    }
+    dsp_multiply(x, analyzer->window, x, n);
+    
+    // Goertzel at exact multiples of the measured fundamental rather than at FFT bins
+    float normalized = analyzer->frequency / (float)WAVEFORM_SAMPLE_RATE_HZ;
+    float fundamental;
+    dsp_goertzel(x, n, normalized, &fundamental, NULL);
+    if (fundamental <= 0.0f) {
+        return;
+    }
+    
+    float distortion = 0.0f;
+    for (int order = 2; order <= HARMONICS_MAX_ORDER; order++) {
+        float amplitude = 0.0f;
+        if (normalized * order < 0.5f) {
+            dsp_goertzel(x, n, normalized * order, &amplitude, NULL);
+        }
+    
+        float ratio = amplitude / fundamental;
+        distortion += ratio * ratio;
+    
+        float scaled = ratio * 100.0f * HARMONICS_MAGNITUDE_SCALE;
+        record.magnitudes[order - 2] = scaled > UINT16_MAX ? UINT16_MAX : (uint16_t)(scaled + 0.5f);
+    }
+    
+    // Undo the 0.5 coherent gain of the Hann window for the absolute value
+    record.fundamental_voltage = 2.0f * fundamental / sqrtf(2.0f) * volts_per_lsb;
+    record.thd = sqrtf(distortion) * 100.0f;
+    
+    if (analyzer->output_queue) {
+        // Queue record (non-blocking), a full queue drops it like the measurement queue does
+        xQueueSend(analyzer->output_queue, &record, 0);
+    }
+    
+    ESP_LOGD(TAG, "Fundamental %.3f Hz %.2f V, THD %.2f %%", record.frequency, record.fundamental_voltage, record.thd);
+}
+
+// Analysis task - one window per notification
+static void harmonics_task(void *pvParameters) {
+    harmonics_analyzer_t *analyzer = (harmonics_analyzer_t *)pvParameters;
+    
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        harmonics_analyze(analyzer);
+        analyzer->busy = false;
+    }
+}
+
+// Initialize the analyzer and start its task
+harmonics_error_t harmonics_init(harmonics_analyzer_t *analyzer) {
+    if (!analyzer) {
+        return HARMONICS_ERROR_INVALID_PARAM;
+    }
+    
+    QueueHandle_t output_queue = analyzer->output_queue;
+    memset(analyzer, 0, sizeof(harmonics_analyzer_t));
+    analyzer->output_queue = output_queue;
+    
+    if (dsp_init() != DSP_OK) {
+        return HARMONICS_ERROR_INIT;
+    }
+    
+    BaseType_t ret = xTaskCreatePinnedToCore(
+        harmonics_task,
+        HARMONICS_TASK_NAME,
+        HARMONICS_TASK_STACK_SIZE,
+        analyzer,
+        HARMONICS_TASK_PRIORITY,
+        &analyzer->task_handle,
+        HARMONICS_TASK_CORE
+    );
+    
+    if (ret != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create harmonics task");
+        return HARMONICS_ERROR_INIT;
+    }
+    
+    return HARMONICS_OK;
+}
+
+// Stop the analysis task
+void harmonics_deinit(harmonics_analyzer_t *analyzer) {
+    if (analyzer && analyzer->task_handle) {
+        vTaskDelete(analyzer->task_handle);
+        analyzer->task_handle = NULL;
+    }
+}
+
+// Hand the latest HARMONICS_WINDOW_CYCLES cycles to the analysis task
+harmonics_error_t harmonics_submit(harmonics_analyzer_t *analyzer, const waveform_estimator_t *wf, float frequency, float voltage_rms, int64_t timestamp_us) {
+    if (!analyzer || !analyzer->task_handle || frequency <= 0.0f) {
+        return HARMONICS_ERROR_INVALID_PARAM;
+    }
+    
+    if (analyzer->busy) {
+        analyzer->skipped_count++;
+        return HARMONICS_ERROR_BUSY;
+    }
+    
+    size_t window_size = (size_t)(HARMONICS_WINDOW_CYCLES * WAVEFORM_SAMPLE_RATE_HZ / frequency + 0.5);
+    if (window_size > HARMONICS_MAX_WINDOW_SIZE) {
+        return HARMONICS_ERROR_INVALID_PARAM;
+    }
+    
+    // Only a plain copy here, the analysis itself runs at lower priority so no waveform sample is missed
+    if (waveform_copy_latest(wf, analyzer->samples, window_size) != window_size) {
+        return HARMONICS_ERROR_BUSY;  // Not enough history since the last estimator reset
+    }
+    
+    analyzer->window_size = window_size;
+    analyzer->frequency = frequency;
+    analyzer->voltage_rms = voltage_rms;
+    analyzer->timestamp_us = timestamp_us;
+    analyzer->busy = true;
+    xTaskNotifyGive(analyzer->task_handle);
+    
+    return HARMONICS_OK;
+}
+
+// Set the queue that receives harmonics_record_t
+void harmonics_set_queue(harmonics_analyzer_t *analyzer, QueueHandle_t output_queue) {
+    if (analyzer) {
+        analyzer->output_queue = output_queue;
+    }
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "waveform.h"
+
+// Analysis configuration
+#define HARMONICS_MAX_ORDER             50      // Highest harmonic reported (2500 Hz at 50 Hz, below the 3.5 kHz Nyquist limit)
+#define HARMONICS_COUNT                 (HARMONICS_MAX_ORDER - 1)   // Orders 2..HARMONICS_MAX_ORDER
+#define HARMONICS_WINDOW_CYCLES         10      // IEC 61000-4-7 style window of 10 line cycles
+#define HARMONICS_MAX_WINDOW_SIZE       1800    // Samples for 10 cycles down to ~39 Hz
+#define HARMONICS_DEFAULT_INTERVAL_CYCLES 50    // Run the analysis every 50 cycles (~1 s)
+#define HARMONICS_MAGNITUDE_SCALE       100.0f  // Stored magnitudes are in 0.01 % of the fundamental
+
+// Task configuration (lower priority than acquisition, same core)
+#define HARMONICS_TASK_STACK_SIZE       (4 * 1024)
+#define HARMONICS_TASK_PRIORITY         4
+#define HARMONICS_TASK_NAME             "harmonics_task"
+#define HARMONICS_TASK_CORE             1
+
+// Compact harmonic record, published separately from the per-cycle measurements
+typedef struct {
+    int64_t timestamp_us;               // Wall-clock time of the crossing that ended the window
+    float frequency;                    // Fundamental frequency used for the analysis
+    float fundamental_voltage;          // RMS voltage of the fundamental
+    float thd;                          // Total harmonic distortion up to HARMONICS_MAX_ORDER, in %
+    uint16_t magnitudes[HARMONICS_COUNT];   // Harmonic 2..50 RMS voltage relative to the fundamental, 0.01 % units
+} harmonics_record_t;
+
+// Analyzer state
+typedef struct {
+    TaskHandle_t task_handle;
+    QueueHandle_t output_queue;
+    volatile bool busy;                 // A window is waiting for or being analyzed
+    uint32_t skipped_count;             // Windows dropped because the previous one was still being analyzed
+    
+    // Window handed over by the acquisition task
+    int32_t samples[HARMONICS_MAX_WINDOW_SIZE];
+    float buffer[HARMONICS_MAX_WINDOW_SIZE] __attribute__((aligned(16)));
+    float window[HARMONICS_MAX_WINDOW_SIZE] __attribute__((aligned(16)));
+    size_t window_size;
+    size_t window_function_size;        // Length the Hann window was last computed for
+    float frequency;
+    float voltage_rms;
+    int64_t timestamp_us;
+} harmonics_analyzer_t;
+
+// Error codes
+typedef enum {
+    HARMONICS_OK = 0,
+    HARMONICS_ERROR_INIT = -1,
+    HARMONICS_ERROR_BUSY = -2,
+    HARMONICS_ERROR_INVALID_PARAM = -3
+} harmonics_error_t;
+
+// Function prototypes
+harmonics_error_t harmonics_init(harmonics_analyzer_t *analyzer);
+void harmonics_deinit(harmonics_analyzer_t *analyzer);
+
+// Hand the latest HARMONICS_WINDOW_CYCLES cycles to the analysis task (called from the acquisition task on a crossing)
+harmonics_error_t harmonics_submit(harmonics_analyzer_t *analyzer, const waveform_estimator_t *wf, float frequency, float voltage_rms, int64_t timestamp_us);
+
+// Set the queue that receives harmonics_record_t
+void harmonics_set_queue(harmonics_analyzer_t *analyzer, QueueHandle_t output_queue);
@@ -0,0 +1,282 @@
+#include "json_writer.h"
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+#include "cJSON.h"
+#include "esp_cpu.h"
+#include "esp_log.h"
+
+static const char *TAG = "json_writer";
+
+static const uint64_t powers_of_ten[JSON_WRITER_MAX_DECIMALS + 1] = {
+    1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000
+};
+
+// Append raw bytes, always leaving room for the NUL
+static void json_writer_put(json_writer_t *writer, const char *data, size_t length) {
+    if (writer->overflow || length >= writer->size - writer->length) {
+        writer->overflow = true;
+        return;
+    }
+    memcpy(writer->buffer + writer->length, data, length);
+    writer->length += length;
+}
+
+static void json_writer_put_char(json_writer_t *writer, char c) {
+    json_writer_put(writer, &c, 1);
+}
+
+// Quoted string with JSON escapes, unescaped runs are copied in one go
+static void json_writer_put_string(json_writer_t *writer, const char *value) {
+    static const char hex[] = "0123456789abcdef";
+    
+    json_writer_put_char(writer, '"');
+    const char *run = value;
+    for (const char *p = value; *p; p++) {
+        unsigned char c = (unsigned char)*p;
+        if (c >= 0x20 && c != '"' && c != '\\') {
+            continue;
+        }
+        
+        json_writer_put(writer, run, p - run);
+        run = p + 1;
+        switch (c) {
+            case '"':  json_writer_put(writer, "\\\"", 2); break;
+            case '\\': json_writer_put(writer, "\\\\", 2); break;
+            case '\n': json_writer_put(writer, "\\n", 2); break;
+            case '\r': json_writer_put(writer, "\\r", 2); break;
+            case '\t': json_writer_put(writer, "\\t", 2); break;
+            case '\b': json_writer_put(writer, "\\b", 2); break;
+            case '\f': json_writer_put(writer, "\\f", 2); break;
+            default: {
+                char escape[6] = { '\\', 'u', '0', '0', hex[c >> 4], hex[c & 0x0F] };
+                json_writer_put(writer, escape, sizeof(escape));
+                break;
+            }
+        }
+    }
+    json_writer_put(writer, run, strlen(run));
+    json_writer_put_char(writer, '"');
+}
+
+// Decimal digits of an unsigned value, zero-padded to min_digits
+static void json_writer_put_digits(json_writer_t *writer, uint64_t value, int min_digits) {
+    char digits[20];
+    int n = 0;
+    
+    do {
+        digits[sizeof(digits) - 1 - n++] = '0' + value % 10;
+        value /= 10;
+    } while (value > 0 || n < min_digits);
+    json_writer_put(writer, digits + sizeof(digits) - n, n);
+}
+
+// Comma and key before a value
+static void json_writer_member(json_writer_t *writer, const char *key) {
+    uint32_t bit = 1u << writer->depth;
+    
+    if (writer->has_members & bit) {
+        json_writer_put_char(writer, ',');
+    }
+    writer->has_members |= bit;
+    
+    if (key) {
+        json_writer_put_string(writer, key);
+        json_writer_put_char(writer, ':');
+    }
+}
+
+// Open a container, its first member needs no comma
+static void json_writer_open(json_writer_t *writer, const char *key, char bracket) {
+    json_writer_member(writer, key);
+    json_writer_put_char(writer, bracket);
+    
+    if (writer->depth + 1 >= JSON_WRITER_MAX_DEPTH) {
+        writer->overflow = true;
+        return;
+    }
+    writer->depth++;
+    writer->has_members &= ~(1u << writer->depth);
+}
+
+static void json_writer_close(json_writer_t *writer, char bracket) {
+    json_writer_put_char(writer, bracket);
+    if (writer->depth > 0) {
+        writer->depth--;
+    } else {
+        writer->overflow = true;        // Unbalanced
+    }
+}
+
+// Start an empty document in buffer
+void json_writer_init(json_writer_t *writer, char *buffer, size_t size) {
+    writer->buffer = buffer;
+    writer->size = size;
+    writer->length = 0;
+    writer->depth = 0;
+    writer->has_members = 0;
+    writer->overflow = !buffer || size == 0;
+}
+
+void json_writer_object_begin(json_writer_t *writer, const char *key) {
+    json_writer_open(writer, key, '{');
+}
+
+void json_writer_object_end(json_writer_t *writer) {
+    json_writer_close(writer, '}');
+}
+
+void json_writer_array_begin(json_writer_t *writer, const char *key) {
+    json_writer_open(writer, key, '[');
+}
+
+void json_writer_array_end(json_writer_t *writer) {
+    json_writer_close(writer, ']');
+}
+
+void json_writer_string(json_writer_t *writer, const char *key, const char *value) {
+    json_writer_member(writer, key);
+    if (value) {
+        json_writer_put_string(writer, value);
+    } else {
+        json_writer_put(writer, "null", 4);
+    }
+}
+
+void json_writer_int(json_writer_t *writer, const char *key, int64_t value) {
+    json_writer_member(writer, key);
+    if (value < 0) {
+        json_writer_put_char(writer, '-');
+    }
+    json_writer_put_digits(writer, value < 0 ? -(uint64_t)value : (uint64_t)value, 1);
+}
+
+void json_writer_uint(json_writer_t *writer, const char *key, uint64_t value) {
+    json_writer_member(writer, key);
+    json_writer_put_digits(writer, value, 1);
+}
+
+void json_writer_bool(json_writer_t *writer, const char *key, bool value) {
+    json_writer_member(writer, key);
+    json_writer_put(writer, value ? "true" : "false", value ? 4 : 5);
+}
+
+void json_writer_null(json_writer_t *writer, const char *key) {
+    json_writer_member(writer, key);
+    json_writer_put(writer, "null", 4);
+}
+
+// Scale to an integer and print the integer and fraction digits, no printf (newlib's may allocate for floats)
+void json_writer_float(json_writer_t *writer, const char *key, double value, uint8_t decimals) {
+    if (decimals > JSON_WRITER_MAX_DECIMALS) {
+        decimals = JSON_WRITER_MAX_DECIMALS;
+    }
+    
+    double scaled = value * (double)powers_of_ten[decimals];
+    if (!isfinite(scaled) || fabs(scaled) >= 9.0e18) {
+        json_writer_null(writer, key);
+        return;
+    }
+    
+    int64_t fixed = llround(scaled);
+    uint64_t magnitude = fixed < 0 ? -(uint64_t)fixed : (uint64_t)fixed;
+    
+    json_writer_member(writer, key);
+    if (fixed < 0) {
+        json_writer_put_char(writer, '-');
+    }
+    json_writer_put_digits(writer, magnitude / powers_of_ten[decimals], 1);
+    if (decimals > 0) {
+        json_writer_put_char(writer, '.');
+        json_writer_put_digits(writer, magnitude % powers_of_ten[decimals], decimals);
+    }
+}
+
+void json_writer_mark(const json_writer_t *writer, json_writer_mark_t *mark) {
+    mark->length = writer->length;
+    mark->depth = writer->depth;
+    mark->has_members = writer->has_members;
+}
+
+void json_writer_rewind(json_writer_t *writer, const json_writer_mark_t *mark) {
+    writer->length = mark->length;
+    writer->depth = mark->depth;
+    writer->has_members = mark->has_members;
+    writer->overflow = false;
+}
+
+// Terminate the document
+const char *json_writer_finish(json_writer_t *writer, size_t *length) {
+    if (writer->overflow || writer->depth != 0 || writer->length == 0) {
+        return NULL;
+    }
+    
+    writer->buffer[writer->length] = '\0';
+    if (length) {
+        *length = writer->length;
+    }
+    return writer->buffer;
+}
+
+// Heap calls made through the cJSON hooks during the benchmark
+static uint32_t g_benchmark_allocations;
+
+static void *json_writer_benchmark_malloc(size_t size) {
+    g_benchmark_allocations++;
+    return malloc(size);
+}
+
+// Benchmark - the per-sample measurement message, built as a cJSON tree and printed, then written directly
+void json_writer_benchmark(uint32_t iterations) {
+    char buffer[JSON_WRITER_BENCHMARK_BUFFER_SIZE];
+    const int64_t timestamp_us = 1760000000123456LL;
+    const float frequency = 50.012345f, voltage = 230.4567f;
+    
+    if (iterations == 0) {
+        return;
+    }
+    
+    // The hooks are global, nothing else may be using cJSON until they are reset below
+    cJSON_Hooks hooks = { .malloc_fn = json_writer_benchmark_malloc, .free_fn = free };
+    cJSON_InitHooks(&hooks);
+    g_benchmark_allocations = 0;
+    
+    size_t cjson_bytes = 0;
+    uint32_t start = esp_cpu_get_cycle_count();
+    for (uint32_t n = 0; n < iterations; n++) {
+        cJSON *json = cJSON_CreateObject();
+        cJSON_AddNumberToObject(json, "timestamp", timestamp_us);
+        cJSON_AddNumberToObject(json, "sequence", n);
+        cJSON_AddNumberToObject(json, "frequency", frequency);
+        cJSON_AddNumberToObject(json, "voltage", voltage);
+        char *json_string = cJSON_PrintUnformatted(json);
+        if (json_string) {
+            cjson_bytes = strlen(json_string);
+            cJSON_free(json_string);
+        }
+        cJSON_Delete(json);
+    }
+    uint32_t cjson_cycles = esp_cpu_get_cycle_count() - start;
+    uint32_t cjson_allocations = g_benchmark_allocations;
+    cJSON_InitHooks(NULL);
+    
+    size_t writer_bytes = 0;
+    start = esp_cpu_get_cycle_count();
+    for (uint32_t n = 0; n < iterations; n++) {
+        json_writer_t writer;
+        json_writer_init(&writer, buffer, sizeof(buffer));
+        json_writer_object_begin(&writer, NULL);
+        json_writer_int(&writer, "timestamp", timestamp_us);
+        json_writer_uint(&writer, "sequence", n);
+        json_writer_float(&writer, "frequency", frequency, 6);
+        json_writer_float(&writer, "voltage", voltage, 3);
+        json_writer_object_end(&writer);
+        json_writer_finish(&writer, &writer_bytes);
+    }
+    uint32_t writer_cycles = esp_cpu_get_cycle_count() - start;
+    
+    ESP_LOGI(TAG, "JSON benchmark (%lu messages): cJSON %.1f allocations, %lu cycles, %u bytes per message; "
+             "writer 0 allocations, %lu cycles, %u bytes per message",
+             iterations, (double)cjson_allocations / iterations, cjson_cycles / iterations, (unsigned)cjson_bytes,
+             writer_cycles / iterations, (unsigned)writer_bytes);
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Streaming JSON writer into a caller-provided buffer: no tree, no heap, one pass.
+// Each call appends one member (with a key) or one array element / top-level value (key NULL).
+// Overflow is sticky and reported once by json_writer_finish(), so callers check only there.
+#define JSON_WRITER_MAX_DEPTH           16      // Nesting of objects and arrays
+#define JSON_WRITER_MAX_DECIMALS        9
+
+// Benchmark
+#define JSON_WRITER_BENCHMARK_BUFFER_SIZE 256
+
+// Writer state
+typedef struct {
+    char *buffer;
+    size_t size;
+    size_t length;                      // Excluding the terminating NUL
+    uint8_t depth;
+    uint32_t has_members;               // Bit per depth: the next member there needs a comma
+    bool overflow;
+} json_writer_t;
+
+// Saved position, to take back a value that did not fit
+typedef struct {
+    size_t length;
+    uint8_t depth;
+    uint32_t has_members;
+} json_writer_mark_t;
+
+// Function prototypes
+void json_writer_init(json_writer_t *writer, char *buffer, size_t size);
+
+void json_writer_object_begin(json_writer_t *writer, const char *key);
+void json_writer_object_end(json_writer_t *writer);
+void json_writer_array_begin(json_writer_t *writer, const char *key);
+void json_writer_array_end(json_writer_t *writer);
+
+void json_writer_string(json_writer_t *writer, const char *key, const char *value);
+void json_writer_int(json_writer_t *writer, const char *key, int64_t value);
+void json_writer_uint(json_writer_t *writer, const char *key, uint64_t value);
+void json_writer_bool(json_writer_t *writer, const char *key, bool value);
+void json_writer_null(json_writer_t *writer, const char *key);
+
+// Fixed-point with the given number of decimals (at most JSON_WRITER_MAX_DECIMALS), rounded half away
+// from zero. NaN, infinities and values too large for 64-bit fixed point are written as null.
+void json_writer_float(json_writer_t *writer, const char *key, double value, uint8_t decimals);
+
+// Roll back to a mark taken before the overflow, the writer can be used again
+void json_writer_mark(const json_writer_t *writer, json_writer_mark_t *mark);
+void json_writer_rewind(json_writer_t *writer, const json_writer_mark_t *mark);
+
+// NUL-terminated document and its length, NULL if it overflowed the buffer or is not closed
+const char *json_writer_finish(json_writer_t *writer, size_t *length);
+
+// Benchmark - heap allocations and CPU cycles per measurement message, cJSON against the writer.
+// Allocations are counted through the cJSON hooks, which are process-wide: call it at startup, before
+// any other task uses cJSON (main.c runs it before the network is started).
+void json_writer_benchmark(uint32_t iterations);
@@ -2,13 +2,31 @@
 #include "ade7953.h"
 #include "led.h"
 #include "network.h"
+#include "dsp.h"
 #include "esp_log.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "nvs_flash.h"
 
 #define ENABLE_MQTT_LOGGING
+#define ENABLE_LOG_BATCHING
 #define ENABLE_MEASUREMENT_PUBLISHING
+// #define ENABLE_MEASUREMENT_BATCHING
+#define ENABLE_RAW_MEASUREMENTS
+#define ENABLE_AGGREGATION
+// #define ENABLE_SPI_BENCHMARK
+// #define ENABLE_DSP_BENCHMARK
+// #define ENABLE_FRAME_BENCHMARK
+// #define ENABLE_JSON_BENCHMARK
+// #define ENABLE_BINARY_LOGS
+// #define ENABLE_WAVEFORM_CAPTURE
+
+#define GRID_NOMINAL_FREQUENCY 50.0f // Hz, 60.0f on 60 Hz grids
+
+#define SPI_BENCHMARK_ITERATIONS 1000
+#define DSP_BENCHMARK_ITERATIONS 100
+#define FRAME_BENCHMARK_ITERATIONS 100
+#define JSON_BENCHMARK_ITERATIONS 1000
 
 static const char *TAG = "main";
 
@@ -58,6 +76,30 @@ void app_main(void)
     
     ESP_LOGI(TAG, "ADE7953 initialized successfully");
     
+    #ifdef ENABLE_SPI_BENCHMARK
+    ade7953_benchmark_spi(&ade7953_handle, SPI_BENCHMARK_ITERATIONS);
+    #endif
+    
+    #ifdef ENABLE_DSP_BENCHMARK
+    dsp_self_test();
+    dsp_benchmark(DSP_BENCHMARK_ITERATIONS);
+    #endif
+    
+    #ifdef ENABLE_FRAME_BENCHMARK
+    measurement_frame_benchmark(FRAME_BENCHMARK_ITERATIONS);
+    #endif
+    
+    // Swaps the cJSON hooks while it runs, so it must stay ahead of the network tasks
+    #ifdef ENABLE_JSON_BENCHMARK
+    json_writer_benchmark(JSON_BENCHMARK_ITERATIONS);
+    #endif
+    
+    #ifdef ENABLE_WAVEFORM_CAPTURE
+    ade7953_set_acquisition_mode(&ade7953_handle, ADE7953_ACQUISITION_WAVEFORM, GRID_NOMINAL_FREQUENCY);
+    #else
+    ade7953_set_acquisition_mode(&ade7953_handle, ADE7953_DEFAULT_ACQUISITION_MODE, GRID_NOMINAL_FREQUENCY);
+    #endif
+    
     // Start the background task for continuous readings
     ret = ade7953_start_task(&ade7953_handle);
     if (ret != ADE7953_OK) {
@@ -112,6 +154,12 @@ void app_main(void)
             
             // Start MQTT logging
             #ifdef ENABLE_MQTT_LOGGING
+            #ifdef ENABLE_BINARY_LOGS
+            network_set_binary_logging(&network_handle, true);
+            #endif
+            #ifdef ENABLE_LOG_BATCHING
+            network_set_log_batching(&network_handle, true);
+            #endif
             net_ret = network_start_mqtt_logging(&network_handle);
             if (net_ret == ESP_OK) {
                 ESP_LOGI(TAG, "MQTT logging started successfully");
@@ -126,6 +174,17 @@ void app_main(void)
                 
                 // Start measurement publishing
                 #ifdef ENABLE_MEASUREMENT_PUBLISHING
+                #ifdef ENABLE_MEASUREMENT_BATCHING
+                network_set_measurement_batching(&network_handle, true);
+                #endif
+                #ifndef ENABLE_RAW_MEASUREMENTS
+                network_set_raw_measurement_publishing(&network_handle, false);
+                #endif
+                #ifdef ENABLE_AGGREGATION
+                static const aggregation_tier_config_t aggregation_tiers[] = AGGREGATION_DEFAULT_TIERS;
+                network_set_aggregation_tiers(&network_handle, aggregation_tiers, AGGREGATION_DEFAULT_TIER_COUNT,
+                                              GRID_NOMINAL_FREQUENCY);
+                #endif
                 net_ret = network_start_measurement_publishing(&network_handle);
                 if (net_ret == ESP_OK) {
                     ESP_LOGI(TAG, "MQTT measurement publishing started successfully");
@@ -150,7 +209,10 @@ void app_main(void)
     }
     
     // Set the measurement queue for automatic measurement publishing
-    ade7953_set_measurement_queue(&ade7953_handle, network_get_measurement_queue(&network_handle));
+    ade7953_set_measurement_ring(&ade7953_handle, network_get_measurement_ring(&network_handle));
+    ade7953_set_harmonics_queue(&ade7953_handle, network_get_harmonics_queue(&network_handle));
+    ade7953_set_events_queue(&ade7953_handle, network_get_events_queue(&network_handle));
+    ade7953_set_synchrophasor_queue(&ade7953_handle, network_get_synchrophasor_queue(&network_handle));
     
     // Start LED pattern task for dynamic patterns
     led_set_status(&led_handle, LED_STATUS_WORKING);
@@ -178,7 +240,23 @@ void app_main(void)
         if (loop_count % 10 == 0) {
             float frequency = ade7953_get_latest_frequency(&ade7953_handle);
             float voltage = ade7953_get_latest_voltage(&ade7953_handle);
-            ESP_LOGI(TAG, "Frequency: %.3f Hz | Voltage: %.1f V", frequency, voltage);
+            BINLOG_I(TAG, "Frequency: %.4f Hz | Voltage: %.1f V", frequency, voltage);
+            
+            if (ade7953_handle.acquisition_mode == ADE7953_ACQUISITION_POLLING) {
+                ade7953_timing_stats_t timing_stats;
+                ade7953_get_timing_stats(&ade7953_handle, &timing_stats);
+                BINLOG_D(TAG, "Sampling: %lu samples | %lu skipped | %lu overruns | jitter %ld us (max %ld us)",
+                         timing_stats.sample_count, timing_stats.skipped_count, timing_stats.overrun_count,
+                         timing_stats.last_jitter_us, timing_stats.max_jitter_us);
+            } else if (ade7953_handle.acquisition_mode == ADE7953_ACQUISITION_WAVEFORM) {
+                BINLOG_D(TAG, "Waveform: %lu sample gaps | %lu IRQ timeouts",
+                         ade7953_handle.waveform_gap_count, ade7953_handle.irq_timeout_count);
+            }
+            
+            spsc_ring_stats_t ring_stats = { 0 };
+            spsc_ring_get_stats(network_get_measurement_ring(&network_handle), &ring_stats);
+            BINLOG_D(TAG, "Measurement ring: high water %u/%u | %lu dropped",
+                     (unsigned)ring_stats.high_water, (unsigned)ring_stats.capacity, ring_stats.drop_count);
         }
 
         // Wait before next reading (1 second for status monitoring)
@@ -0,0 +1,254 @@
+#include "measurement_frame.h"
+#include <string.h>
+#include "json_writer.h"
+
+static const char *TAG = "measurement_frame";
+
+// Little-endian writers
+static uint8_t *put_le16(uint8_t *p, uint16_t value) {
+    p[0] = value & 0xFF;
+    p[1] = value >> 8;
+    return p + 2;
+}
+
+static uint8_t *put_le32(uint8_t *p, uint32_t value) {
+    p[0] = value & 0xFF;
+    p[1] = (value >> 8) & 0xFF;
+    p[2] = (value >> 16) & 0xFF;
+    p[3] = value >> 24;
+    return p + 4;
+}
+
+static uint8_t *put_le64(uint8_t *p, uint64_t value) {
+    p = put_le32(p, (uint32_t)value);
+    return put_le32(p, (uint32_t)(value >> 32));
+}
+
+static uint8_t *put_lef32(uint8_t *p, float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return put_le32(p, bits);
+}
+
+// LEB128 varint, 7 bits per byte, least significant group first
+static uint8_t *put_varint(uint8_t *p, uint64_t value) {
+    while (value >= 0x80) {
+        *p++ = (uint8_t)value | 0x80;
+        value >>= 7;
+    }
+    *p++ = (uint8_t)value;
+    return p;
+}
+
+// Zigzag maps small negative and positive differences to small unsigned values
+static inline uint64_t zigzag(int64_t value) {
+    return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+}
+
+// Initialize an empty frame for one device
+measurement_frame_error_t measurement_frame_init(measurement_frame_t *frame, const uint8_t *device_id,
+                                                 uint16_t max_samples, uint32_t span_s) {
+    if (!frame || !device_id || max_samples == 0 || max_samples > MEASUREMENT_FRAME_MAX_SAMPLES ||
+        span_s > MEASUREMENT_FRAME_MAX_SPAN_S) {
+        return MEASUREMENT_FRAME_ERROR_INVALID_PARAM;
+    }
+    
+    memset(frame, 0, sizeof(measurement_frame_t));
+    memcpy(frame->device_id, device_id, MEASUREMENT_FRAME_DEVICE_ID_LEN);
+    frame->max_samples = max_samples;
+    frame->span_s = span_s;
+    return MEASUREMENT_FRAME_OK;
+}
+
+// Set the UTC alignment of the next frame
+measurement_frame_error_t measurement_frame_set_span(measurement_frame_t *frame, uint32_t span_s) {
+    if (!frame || frame->sample_count > 0 || span_s > MEASUREMENT_FRAME_MAX_SPAN_S) {
+        return MEASUREMENT_FRAME_ERROR_INVALID_PARAM;
+    }
+    
+    frame->span_s = span_s;
+    return MEASUREMENT_FRAME_OK;
+}
+
+// True if the measurement can join the current frame
+bool measurement_frame_fits(const measurement_frame_t *frame, const measurement_t *measurement) {
+    if (frame->sample_count == 0) {
+        return true;
+    }
+    if (measurement_frame_full(frame) || measurement->frequency_unit != frame->frequency_unit ||
+        measurement->calibration_id != frame->calibration_id) {
+        return false;
+    }
+    
+    // Timestamps must not go backwards within a frame, a clock step starts a new one
+    int64_t base_us = frame->timestamps_us[0];
+    if (measurement->timestamp_us < frame->timestamps_us[frame->sample_count - 1]) {
+        return false;
+    }
+    
+    // Sequence numbers only go forward within a frame, so gaps stay countable
+    if ((int32_t)(measurement->sequence - frame->sequences[frame->sample_count - 1]) <= 0) {
+        return false;
+    }
+    
+    int64_t span_us = (int64_t)frame->span_s * 1000000;
+    return span_us == 0 || measurement->timestamp_us / span_us == base_us / span_us;
+}
+
+// Append a measurement
+bool measurement_frame_add(measurement_frame_t *frame, const measurement_t *measurement) {
+    if (!frame || !measurement || !measurement_frame_fits(frame, measurement)) {
+        return false;
+    }
+    
+    if (frame->sample_count == 0) {
+        frame->frequency_unit = measurement->frequency_unit;
+        frame->calibration_id = measurement->calibration_id;
+    }
+    
+    frame->timestamps_us[frame->sample_count] = measurement->timestamp_us;
+    frame->sequences[frame->sample_count] = measurement->sequence;
+    frame->frequency_codes[frame->sample_count] = measurement->frequency_code;
+    frame->voltage_codes[frame->sample_count] = measurement->voltage_code;
+    frame->sample_count++;
+    
+    return true;
+}
+
+// Encode the header and the three columns
+size_t measurement_frame_finish(measurement_frame_t *frame) {
+    if (!frame || frame->sample_count == 0) {
+        return 0;
+    }
+    
+    uint8_t *p = frame->buffer;
+    *p++ = MEASUREMENT_FRAME_MAGIC_0;
+    *p++ = MEASUREMENT_FRAME_MAGIC_1;
+    *p++ = MEASUREMENT_FRAME_VERSION;
+    *p++ = MEASUREMENT_FRAME_ENCODING_COLUMNAR;
+    memcpy(p, frame->device_id, MEASUREMENT_FRAME_DEVICE_ID_LEN);
+    p += MEASUREMENT_FRAME_DEVICE_ID_LEN;
+    p = put_le16(p, frame->sample_count);
+    p = put_le32(p, frame->sequence);
+    p = put_le64(p, (uint64_t)frame->timestamps_us[0]);
+    
+    const ade7953_calibration_t *calibration = ade7953_get_calibration(frame->calibration_id);
+    *p++ = frame->frequency_unit;
+    *p++ = frame->calibration_id;
+    p = put_lef32(p, calibration ? calibration->period_clock_hz : 0.0f);
+    p = put_lef32(p, calibration ? calibration->volts_per_lsb : 0.0f);
+    p = put_le32(p, frame->sequences[0]);
+    
+    // Sequence gaps, counted first so the list can be prefixed with its length
+    uint32_t gap_count = 0;
+    for (size_t i = 1; i < frame->sample_count; i++) {
+        gap_count += frame->sequences[i] - frame->sequences[i - 1] != 1;
+    }
+    p = put_varint(p, gap_count);
+    size_t previous_gap = 0;
+    for (size_t i = 1; gap_count > 0 && i < frame->sample_count; i++) {
+        uint32_t missing = frame->sequences[i] - frame->sequences[i - 1] - 1;
+        if (missing > 0) {
+            p = put_varint(p, i - previous_gap);
+            p = put_varint(p, missing);
+            previous_gap = i;
+        }
+    }
+    
+    // Timestamps: change of the per-sample delta
+    int64_t previous_delta = 0;
+    for (size_t i = 0; i < frame->sample_count; i++) {
+        int64_t delta = i > 0 ? frame->timestamps_us[i] - frame->timestamps_us[i - 1] : 0;
+        p = put_varint(p, zigzag(delta - previous_delta));
+        previous_delta = delta;
+    }
+    
+    // Codes: difference to the previous sample
+    int64_t previous = 0;
+    for (size_t i = 0; i < frame->sample_count; i++) {
+        p = put_varint(p, zigzag((int64_t)frame->frequency_codes[i] - previous));
+        previous = frame->frequency_codes[i];
+    }
+    previous = 0;
+    for (size_t i = 0; i < frame->sample_count; i++) {
+        p = put_varint(p, zigzag((int64_t)frame->voltage_codes[i] - previous));
+        previous = frame->voltage_codes[i];
+    }
+    
+    return p - frame->buffer;
+}
+
+// Start the next frame
+void measurement_frame_reset(measurement_frame_t *frame) {
+    if (frame && frame->sample_count > 0) {
+        frame->sample_count = 0;
+        frame->sequence++;
+    }
+}
+
+// Benchmark - one second of waveform-mode samples, as one frame and as one JSON writer message per sample
+void measurement_frame_benchmark(uint32_t iterations) {
+    static const uint8_t device_id[MEASUREMENT_FRAME_DEVICE_ID_LEN] = { 0 };
+    measurement_t samples[MEASUREMENT_FRAME_BENCHMARK_SAMPLES];
+    measurement_frame_t *frame = heap_caps_malloc(sizeof(measurement_frame_t), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    
+    if (!frame || iterations == 0) {
+        ESP_LOGE(TAG, "Frame benchmark setup failed");
+        heap_caps_free(frame);
+        return;
+    }
+    
+    // 50 Hz with a few mHz and a few tenths of a volt of wander, and some timestamp jitter
+    for (int i = 0; i < MEASUREMENT_FRAME_BENCHMARK_SAMPLES; i++) {
+        uint32_t frequency_code = 50000000 + (uint32_t)((i * 7919) % 4001) - 2000;
+        uint32_t voltage_code = 5930000 + (uint32_t)((i * 104729) % 8001) - 4000;
+        samples[i] = (measurement_t) {
+            .timestamp_us = 1760000000000000LL + i * 20000 + (i * 31) % 23,
+            .sequence = i,
+            .frequency_code = frequency_code,
+            .voltage_code = voltage_code,
+            .frequency_unit = MEASUREMENT_FREQUENCY_UNIT_MICROHERTZ,
+            .calibration_id = ADE7953_DEFAULT_CALIBRATION_ID,
+        };
+    }
+    
+    size_t frame_bytes = 0;
+    int64_t start_us = esp_timer_get_time();
+    for (uint32_t n = 0; n < iterations; n++) {
+        measurement_frame_init(frame, device_id, MEASUREMENT_FRAME_MAX_SAMPLES, 0);
+        for (int i = 0; i < MEASUREMENT_FRAME_BENCHMARK_SAMPLES; i++) {
+            measurement_frame_add(frame, &samples[i]);
+        }
+        frame_bytes = measurement_frame_finish(frame);
+    }
+    int64_t frame_us = esp_timer_get_time() - start_us;
+    
+    // The JSON path as measurement_publishing_task runs it without batching, including the unit conversion
+    static char json_buffer[JSON_WRITER_BENCHMARK_BUFFER_SIZE];
+    size_t json_bytes = 0;
+    start_us = esp_timer_get_time();
+    for (uint32_t n = 0; n < iterations; n++) {
+        json_bytes = 0;
+        for (int i = 0; i < MEASUREMENT_FRAME_BENCHMARK_SAMPLES; i++) {
+            json_writer_t writer;
+            size_t length;
+            json_writer_init(&writer, json_buffer, sizeof(json_buffer));
+            json_writer_object_begin(&writer, NULL);
+            json_writer_int(&writer, "timestamp", samples[i].timestamp_us);
+            json_writer_uint(&writer, "sequence", samples[i].sequence);
+            json_writer_float(&writer, "frequency", ade7953_measurement_frequency(&samples[i]), 6);
+            json_writer_float(&writer, "voltage", ade7953_measurement_voltage(&samples[i]), 3);
+            json_writer_object_end(&writer);
+            if (json_writer_finish(&writer, &length)) {
+                json_bytes += length;
+            }
+        }
+    }
+    int64_t json_us = esp_timer_get_time() - start_us;
+    
+    ESP_LOGI(TAG, "Frame benchmark (%d samples, %lu runs): columnar frame %u bytes in %.1f us, JSON %u bytes in %d messages in %.1f us",
+             MEASUREMENT_FRAME_BENCHMARK_SAMPLES, iterations, (unsigned)frame_bytes, (double)frame_us / iterations,
+             (unsigned)json_bytes, MEASUREMENT_FRAME_BENCHMARK_SAMPLES, (double)json_us / iterations);
+    
+    heap_caps_free(frame);
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "ade7953.h"
+
+// Binary measurement frame, little-endian:
+//
+//   offset  size  field
+//   0       2     magic "OG"
+//   2       1     version
+//   3       1     encoding (MEASUREMENT_FRAME_ENCODING_*)
+//   4       6     device MAC
+//   10      2     sample count
+//   12      4     frame sequence number
+//   16      8     base timestamp, UTC microseconds (first sample)
+//   24      ...   samples
+//
+// Packed samples (encoding 0, decoders only), 12 bytes each: uint32 offset from the base timestamp in us,
+// float32 frequency in Hz, float32 RMS voltage in V.
+//
+// Columnar samples (encoding 1):
+//   uint8   frequency unit (measurement_frequency_unit_t)
+//   uint8   calibration set ID (ade7953_calibration_t, version 2 onwards)
+//   float32 period clock in Hz of that set, frequency = clock / code for MEASUREMENT_FREQUENCY_UNIT_PERIOD
+//   float32 volts per VRMS LSB of that set, voltage = code * scale
+//   uint32  acquisition sequence number of the first sample (version 3 onwards)
+//   varint  number of sequence gaps, then for each gap two varints: the index of the sample after it,
+//           counted from the previous gap's sample (from 0 for the first), and the number of samples missing
+//   then three columns of varints, each value zigzag-encoded against the previous one (starting from 0):
+//   timestamp deltas from the previous sample (the first is 0), frequency codes, VRMS codes.
+//   The timestamp column codes the change of the delta, so a steady cycle rate costs one byte per sample.
+// The decoder repeats the firmware's float32 arithmetic, so frequency and voltage come back bit-exact.
+// The factors make a frame self-describing; ingest may override them by calibration ID to re-scale old data.
+#define MEASUREMENT_FRAME_MAGIC_0           'O'
+#define MEASUREMENT_FRAME_MAGIC_1           'G'
+#define MEASUREMENT_FRAME_VERSION           3       // 2 added the calibration set ID, 3 the sample sequence
+#define MEASUREMENT_FRAME_ENCODING_PACKED   0
+#define MEASUREMENT_FRAME_ENCODING_COLUMNAR 1
+#define MEASUREMENT_FRAME_DEVICE_ID_LEN     6
+#define MEASUREMENT_FRAME_HEADER_SIZE       24
+#define MEASUREMENT_FRAME_COLUMNAR_HEADER_SIZE 17   // Including the gap count, at most 3 varint bytes
+#define MEASUREMENT_FRAME_MAX_SAMPLE_SIZE   28      // Worst case varints: 10 (timestamp) + 5 + 5, and 3 + 5 for a gap before it
+
+// Batching
+#define MEASUREMENT_FRAME_SAMPLES_PER_SECOND 64     // Per-cycle samples at 60 Hz, with margin
+#define MEASUREMENT_FRAME_MAX_SPAN_S        4       // Longest frame, this bounds the memory of a frame
+#define MEASUREMENT_FRAME_MAX_SAMPLES       (MEASUREMENT_FRAME_MAX_SPAN_S * MEASUREMENT_FRAME_SAMPLES_PER_SECOND)
+#define MEASUREMENT_FRAME_BUFFER_SIZE       (MEASUREMENT_FRAME_HEADER_SIZE + MEASUREMENT_FRAME_COLUMNAR_HEADER_SIZE + \
+                                             MEASUREMENT_FRAME_MAX_SAMPLES * MEASUREMENT_FRAME_MAX_SAMPLE_SIZE)
+#define MEASUREMENT_FRAME_AGE_GRACE_US      500000  // A partly filled frame is sent this long after its span without a boundary
+#define MEASUREMENT_FRAME_BENCHMARK_SAMPLES 50
+
+// Frame being filled, samples are kept raw and only encoded by measurement_frame_finish()
+typedef struct {
+    uint8_t device_id[MEASUREMENT_FRAME_DEVICE_ID_LEN];
+    uint16_t max_samples;
+    uint32_t span_s;                    // Close the frame at every multiple of this many UTC seconds, 0 for count only
+    uint32_t sequence;                  // Of the frame being filled, wraps around
+    uint16_t sample_count;
+    uint8_t frequency_unit;             // Shared by all samples of a frame
+    uint8_t calibration_id;             // Likewise
+    int64_t timestamps_us[MEASUREMENT_FRAME_MAX_SAMPLES];
+    uint32_t sequences[MEASUREMENT_FRAME_MAX_SAMPLES];
+    uint32_t frequency_codes[MEASUREMENT_FRAME_MAX_SAMPLES];
+    uint32_t voltage_codes[MEASUREMENT_FRAME_MAX_SAMPLES];
+    uint8_t buffer[MEASUREMENT_FRAME_BUFFER_SIZE];
+} measurement_frame_t;
+
+// Error codes
+typedef enum {
+    MEASUREMENT_FRAME_OK = 0,
+    MEASUREMENT_FRAME_ERROR_INVALID_PARAM = -1
+} measurement_frame_error_t;
+
+// Function prototypes
+measurement_frame_error_t measurement_frame_init(measurement_frame_t *frame, const uint8_t *device_id,
+                                                 uint16_t max_samples, uint32_t span_s);
+
+// Change the span, only between frames (sample_count 0)
+measurement_frame_error_t measurement_frame_set_span(measurement_frame_t *frame, uint32_t span_s);
+
+// True if the measurement can join the current frame; otherwise finish the frame first
+bool measurement_frame_fits(const measurement_frame_t *frame, const measurement_t *measurement);
+
+// Append a measurement, returns false if it does not fit
+bool measurement_frame_add(measurement_frame_t *frame, const measurement_t *measurement);
+
+// True once no further sample can be added
+static inline bool measurement_frame_full(const measurement_frame_t *frame) {
+    return frame->sample_count >= frame->max_samples;
+}
+
+// Encode the frame into buffer and return its length (0 if empty). The frame stays valid in buffer
+// until measurement_frame_reset() starts the next one.
+size_t measurement_frame_finish(measurement_frame_t *frame);
+void measurement_frame_reset(measurement_frame_t *frame);
+
+// Benchmark - frame encoding against one JSON writer message per sample
+void measurement_frame_benchmark(uint32_t iterations);
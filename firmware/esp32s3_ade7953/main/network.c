@@ -2,6 +2,8 @@
 #include "esp_mac.h"
 #include "nvs_flash.h"
 #include "nvs.h"
+#include <math.h>
+#include <stdarg.h>
 
 static const char *TAG = "network";
 
@@ -11,7 +13,6 @@ static httpd_handle_t g_web_server = NULL;
 static TaskHandle_t g_mqtt_log_task = NULL;
 static TaskHandle_t g_measurement_task = NULL;
 static esp_mqtt_client_handle_t g_mqtt_client = NULL;
-static QueueHandle_t g_log_queue = NULL;
 static bool g_log_forwarding_initialized = false;
 static vprintf_like_t g_original_log_function = NULL;
 static TaskHandle_t g_rollback_check_task = NULL;
@@ -19,6 +20,34 @@ static bool g_time_synced = false;
 static TaskHandle_t g_deferred_shutdown_task = NULL;
 static bool g_mqtt_connected = false;
 
+// Acquisition to publisher hand-off, single producer (ade7953_task) and single consumer (measurement_publishing_task)
+static spsc_ring_t g_measurement_ring;
+static measurement_t g_measurement_ring_storage[MEASUREMENT_RING_SIZE] __attribute__((aligned(RING_BUFFER_CACHE_LINE_SIZE)));
+static uint8_t g_backfill_buffer[MEASUREMENT_FRAME_BUFFER_SIZE];
+_Static_assert(MEASUREMENT_FRAME_BUFFER_SIZE <= STORAGE_MAX_RECORD_SIZE, "A full frame must fit one spool record");
+static char g_aggregate_topics[AGGREGATION_MAX_TIERS][MQTT_TOPIC_LEN];  // Per tier, built when publishing starts
+static char g_measurement_json[MEASUREMENT_JSON_SIZE];                  // Only written by measurement_publishing_task
+static char g_event_json[EVENT_JSON_CHUNK_SIZE];                        // Only written by measurement_publishing_task
+
+// Log forwarding, many producers (every task that logs) and one consumer (mqtt_logging_task)
+static mpsc_ring_t g_log_ring;
+static uint8_t g_log_ring_storage[MPSC_RING_STORAGE_SIZE(LOG_RING_SIZE, sizeof(log_message_t))] __attribute__((aligned(4)));
+static atomic_uint_least32_t g_log_dropped;                             // Lines refused because the ring was full
+static char g_log_topics[LOG_FORWARD_LEVEL_COUNT][MQTT_TOPIC_LEN];      // Per level, built in network_init
+static char g_binlog_topics[LOG_FORWARD_LEVEL_COUNT][MQTT_TOPIC_LEN];
+static char g_crash_log_topic[MQTT_TOPIC_LEN];
+static char g_crash_binlog_topic[MQTT_TOPIC_LEN];
+_Static_assert(BINLOG_RECORD_MAX_SIZE <= LOG_MSG_MAX_SIZE, "A binary log record must fit a log slot");
+_Static_assert(6 * LOG_MSG_MAX_SIZE + 64 <= LOG_BATCH_SIZE, "An escaped log line must fit an empty batch");
+_Static_assert(BINLOG_HEADER_SIZE + BINLOG_RECORD_MAX_SIZE <= LOG_BINARY_BATCH_SIZE, "A binary log record must fit an empty batch");
+static log_text_batch_t g_log_flush_batch;                              // Used on the MQTT event task only
+static log_binary_batch_t g_crash_binlog_batch;                         // Used on the MQTT event task only
+static log_rate_bucket_t g_log_rate_buckets[LOG_RATE_BUCKETS];
+static log_rate_bucket_t g_log_rate_other[LOG_FORWARD_LEVEL_COUNT];     // Pairs that found the table full
+static portMUX_TYPE g_log_rate_lock = portMUX_INITIALIZER_UNLOCKED;
+static atomic_uint_least32_t g_log_suppressed;                          // Lines held back by the rate limit, since boot
+static const char *g_log_level_names[LOG_FORWARD_LEVEL_COUNT] = { "error", "warning", "info", "debug" };
+
 // Forward declarations
 static void wifi_event_handler(void* arg, esp_event_base_t event_base, int32_t event_id, void* event_data);
 static esp_err_t ota_upload_handler(httpd_req_t *req);
@@ -26,29 +55,163 @@ static esp_err_t web_index_handler(httpd_req_t *req);
 static esp_err_t web_api_status_handler(httpd_req_t *req);
 static esp_err_t web_api_config_handler(httpd_req_t *req);
 static esp_err_t web_api_restart_handler(httpd_req_t *req);
+static esp_err_t web_api_register_handler(httpd_req_t *req);
 static void mqtt_logging_task(void *pvParameters);
 static void measurement_publishing_task(void *pvParameters);
 static void mqtt_event_handler(void *handler_args, esp_event_base_t base, int32_t event_id, void *event_data);
 static int custom_log_writer(const char *fmt, va_list args);
+static bool binlog_forward(const binlog_site_t *site, const uint8_t *record, size_t length);
 static void rollback_check_task(void *pvParameters);
 static void deferred_shutdown_task(void *pvParameters);
-static void add_to_log_buffer(network_handle_t *handle, const char *message, const char *topic);
-static void add_to_log_buffer(network_handle_t *handle, const char *message, const char *topic);
+static void add_to_log_buffer(network_handle_t *handle, const char *message, log_forward_level_t level);
 static void handle_mqtt_command(const char *command, mqtt_command_t cmd_type);
 static esp_err_t perform_mqtt_ota(const char *url, int command_id);
 static const char* ota_state_to_string(esp_ota_img_states_t state);
+static const char* reset_reason_to_string(esp_reset_reason_t reason);
 static void sntp_sync_notification_cb(struct timeval *tv);
 esp_err_t safe_publish_mqtt(const char *topic, const char *message, int qos, int retain);
 esp_err_t safe_publish_mqtt_default(const char *topic, const char *message);
 const char* cmd_type_to_name(mqtt_command_t cmd_type);
 
-// Custom vprintf implementation - MUST BE FAST AND NON-BLOCKING
+// Level letter at the start of an ESP_LOGx line, after the colour escape when CONFIG_LOG_COLORS is on
+static log_forward_level_t log_forward_level(const char *line) {
+    if (line[0] == '\033') {
+        const char *end = strchr(line, 'm');
+        if (end) {
+            line = end + 1;
+        }
+    }
+    if (line[0] == '\0' || line[1] != ' ') {
+        return LOG_FORWARD_INFO;
+    }
+    
+    switch (line[0]) {
+        case 'E': return LOG_FORWARD_ERROR;
+        case 'W': return LOG_FORWARD_WARNING;
+        case 'D':
+        case 'V': return LOG_FORWARD_DEBUG;
+        default:  return LOG_FORWARD_INFO;
+    }
+}
+
+// Tag of an ESP_LOGx line ("E (123) tag: ..."), not terminated; length 0 if the line has no prefix
+static const char *log_line_tag(const char *line, size_t *length) {
+    *length = 0;
+    if (line[0] == '\033') {
+        const char *end = strchr(line, 'm');
+        if (end) {
+            line = end + 1;
+        }
+    }
+    if (line[0] == '\0' || line[1] != ' ' || line[2] != '(') {
+        return line;
+    }
+    
+    const char *tag = strchr(line, ')');
+    if (!tag || tag[1] != ' ') {
+        return line;
+    }
+    tag += 2;
+    const char *end = strchr(tag, ':');
+    if (end) {
+        *length = end - tag;
+    }
+    return tag;
+}
+
+// Drop the colour escape, the reset and the newline ESP_LOGx puts around a line, in place
+static const char *log_line_trim(char *line) {
+    if (line[0] == '\033') {
+        char *end = strchr(line, 'm');
+        if (end) {
+            line = end + 1;
+        }
+    }
+    
+    size_t length = strlen(line);
+    while (length > 0 && (line[length - 1] == '\n' || line[length - 1] == '\r')) {
+        length--;
+    }
+    if (length >= 4 && memcmp(line + length - 4, "\033[0m", 4) == 0) {
+        length -= 4;
+    }
+    line[length] = '\0';
+    return line;
+}
+
+// Bucket of a tag and level pair, claimed on first use. Called with g_log_rate_lock held.
+static log_rate_bucket_t *log_rate_bucket(const char *tag, size_t tag_length, log_forward_level_t level) {
+    if (tag_length >= LOG_RATE_TAG_SIZE) {
+        tag_length = LOG_RATE_TAG_SIZE - 1;
+    }
+    
+    for (int i = 0; i < LOG_RATE_BUCKETS; i++) {
+        log_rate_bucket_t *bucket = &g_log_rate_buckets[i];
+        if (!bucket->used) {
+            memcpy(bucket->tag, tag, tag_length);
+            bucket->tag[tag_length] = '\0';
+            bucket->level = level;
+            bucket->next_us = 0;
+            bucket->suppressed = 0;
+            bucket->used = true;
+            return bucket;
+        }
+        if (bucket->level == level && strncmp(bucket->tag, tag, tag_length) == 0 && bucket->tag[tag_length] == '\0') {
+            return bucket;
+        }
+    }
+    return &g_log_rate_other[level];
+}
+
+// Take a token from the pair's bucket, false (and counted) if the line is to be suppressed
+static bool log_rate_allow(network_handle_t *handle, const char *tag, size_t tag_length, log_forward_level_t level) {
+    int64_t now_us = esp_timer_get_time();
+    
+    taskENTER_CRITICAL(&g_log_rate_lock);
+    const log_rate_limit_t limit = handle->log_rate_limits[level];
+    if (limit.lines_per_second == 0) {
+        taskEXIT_CRITICAL(&g_log_rate_lock);
+        return true;
+    }
+    
+    int64_t interval_us = 1000000 / limit.lines_per_second;
+    int64_t tolerance_us = (limit.burst - 1) * interval_us;
+    log_rate_bucket_t *bucket = log_rate_bucket(tag, tag_length, level);
+    if (bucket->next_us < now_us) {
+        bucket->next_us = now_us;
+    }
+    bool allowed = bucket->next_us - now_us <= tolerance_us;
+    if (allowed) {
+        bucket->next_us += interval_us;
+    } else {
+        bucket->suppressed++;
+    }
+    taskEXIT_CRITICAL(&g_log_rate_lock);
+    
+    if (!allowed) {
+        atomic_fetch_add_explicit(&g_log_suppressed, 1, memory_order_relaxed);
+    }
+    return allowed;
+}
+
+// Take and clear the suppressed count of a bucket, with its tag
+static uint32_t log_rate_take_suppressed(log_rate_bucket_t *bucket, char *tag) {
+    taskENTER_CRITICAL(&g_log_rate_lock);
+    uint32_t suppressed = bucket->suppressed;
+    bucket->suppressed = 0;
+    memcpy(tag, bucket->tag, LOG_RATE_TAG_SIZE);
+    taskEXIT_CRITICAL(&g_log_rate_lock);
+    return suppressed;
+}
+
+// Custom vprintf implementation - MUST BE FAST AND NON-BLOCKING, and it runs on every task that logs
 static int custom_log_writer(const char *fmt, va_list args)
 {
-    // Prevent recursion and stack overflow
-    static bool in_custom_writer = false;
-    if (in_custom_writer) {
-        // If we're already in the custom writer, just use the original function
+    // Per task: a log call made from inside the writer goes straight to the console,
+    // while other tasks logging at the same time are still forwarded. So does a BINLOG_x line,
+    // its record is already forwarded and in the crash log.
+    static __thread bool in_custom_writer = false;
+    if (in_custom_writer || binlog_echoing()) {
         if (g_original_log_function) {
             return g_original_log_function(fmt, args);
         }
@@ -57,77 +220,35 @@ static int custom_log_writer(const char *fmt, va_list args)
     
     in_custom_writer = true;
     
-    char temp_buffer[MQTT_MSG_MAX_SIZE];
-    int msg_len = 0;
-    int total_len = 0;
-
+    // Formatted straight into the slot, which is copied into the ring: no heap on this path
+    log_message_t log_msg;
     va_list args_copy;
     va_copy(args_copy, args);
-    msg_len = vsnprintf(temp_buffer, sizeof(temp_buffer) - 1, fmt, args_copy);
+    int msg_len = vsnprintf(log_msg.msg, sizeof(log_msg.msg), fmt, args_copy);
     va_end(args_copy);
-
-    if (msg_len >= 0) {
-        total_len = msg_len;
-        if (total_len >= sizeof(temp_buffer)) {
-            total_len = sizeof(temp_buffer) - 1;
-        }
-        temp_buffer[total_len] = '\0';
-
-        // Determine log level and construct topic
-        const char *log_level = "info";  // Default to info if no level found
-        char topic_buffer[80];
-        const char *topic = NULL;
-        
-        if (strstr(temp_buffer, "E (") != NULL) {
-            log_level = "error";
-        } else if (strstr(temp_buffer, "W (") != NULL) {
-            log_level = "warning";
-        } else if (strstr(temp_buffer, "I (") != NULL) {
-            log_level = "info";
-        } else if (strstr(temp_buffer, "D (") != NULL) {
-            log_level = "debug";
-        }
+    
+    if (msg_len > 0) {
+        log_msg.level = log_forward_level(log_msg.msg);
+        log_msg.length = 0;
+        gettimeofday(&log_msg.timestamp, NULL);
         
-        if (g_network_handle) {
-            snprintf(topic_buffer, sizeof(topic_buffer), "%s/%s/%s/%s", 
-                     MQTT_TOPIC_BASE, g_network_handle->mac_address, MQTT_TOPIC_LOGS, log_level);
-            topic = topic_buffer;
-        } else {
-            // Fallback to default topic if handle not available
-            snprintf(topic_buffer, sizeof(topic_buffer), "%s/%s/%s", MQTT_TOPIC_BASE, MQTT_TOPIC_LOGS, log_level);
-            topic = topic_buffer;
-        }
-
-        // Try to send to MQTT queue first if available
-        if (g_log_forwarding_initialized && g_log_queue != NULL) {
-            log_message_t log_msg;
-            log_msg.msg = malloc(total_len + 1);
-            
-            if (log_msg.msg != NULL) {
-                memcpy(log_msg.msg, temp_buffer, total_len + 1);
-                log_msg.topic = malloc(strlen(topic) + 1);
-                if (log_msg.topic != NULL) {
-                    strcpy(log_msg.topic, topic);
-                }
-                gettimeofday(&log_msg.timestamp, NULL);
-
-                // Use non-blocking send to avoid blocking in interrupt context
-                if (xQueueSend(g_log_queue, &log_msg, 0) != pdTRUE) {
-                    // Queue full, free memory to avoid leak
-                    free(log_msg.msg);
-                    if (log_msg.topic) free(log_msg.topic);
-                }
+        if (g_log_forwarding_initialized) {
+            // Only the MQTT path is limited, the line is still printed below
+            size_t tag_length;
+            const char *tag = log_line_tag(log_msg.msg, &tag_length);
+            if (log_rate_allow(g_network_handle, tag, tag_length, log_msg.level) &&
+                !mpsc_ring_push(&g_log_ring, &log_msg)) {
+                atomic_fetch_add_explicit(&g_log_dropped, 1, memory_order_relaxed);
             }
         } 
-        // If MQTT queue not available, use log buffer (but only for important messages)
-        else if (g_network_handle && g_network_handle->log_buffer) {
-            // Only buffer important messages (Error, Warning, Info) to prevent buffer overflow
-            if (strstr(temp_buffer, "E (") != NULL || 
-                strstr(temp_buffer, "W (") != NULL || 
-                strstr(temp_buffer, "I (") != NULL) {
-                add_to_log_buffer(g_network_handle, temp_buffer, topic);
-            }
+        // If MQTT forwarding is not running, use log buffer (but only for important messages)
+        else if (g_network_handle && g_network_handle->log_buffer && log_msg.level <= LOG_FORWARD_INFO) {
+            add_to_log_buffer(g_network_handle, log_msg.msg, log_msg.level);
         }
+        
+        // Every line goes to the no-init ring, the slot is already copied so it is trimmed in place
+        const char *line = log_line_trim(log_msg.msg);
+        crash_log_write(log_msg.timestamp.tv_sec * 1000000LL + log_msg.timestamp.tv_usec, line, strlen(line));
     }
     
     in_custom_writer = false;
@@ -139,6 +260,161 @@ static int custom_log_writer(const char *fmt, va_list args)
     return vprintf(fmt, args);
 }
 
+// Start an empty batch
+static void log_batch_open(log_text_batch_t *batch) {
+    json_writer_init(&batch->writer, batch->json, sizeof(batch->json));
+    json_writer_array_begin(&batch->writer, NULL);
+    batch->lines = 0;
+}
+
+// Append one line, false with the batch unchanged if it does not fit with the closing bracket.
+// buffered marks lines held while MQTT was down, reset_reason (if not NULL) lines from before a reset.
+static bool log_batch_append(log_text_batch_t *batch, int64_t timestamp_us, const char *message, bool buffered,
+                             const char *reset_reason) {
+    json_writer_mark_t mark;
+    json_writer_mark(&batch->writer, &mark);
+    
+    json_writer_object_begin(&batch->writer, NULL);
+    json_writer_int(&batch->writer, "timestamp", timestamp_us);
+    json_writer_string(&batch->writer, "message", message);
+    if (buffered) {
+        json_writer_bool(&batch->writer, "buffered", true);
+    }
+    if (reset_reason) {
+        json_writer_string(&batch->writer, "reset_reason", reset_reason);
+    }
+    json_writer_object_end(&batch->writer);
+    
+    if (batch->writer.overflow || batch->writer.length + 1 >= batch->writer.size) {
+        json_writer_rewind(&batch->writer, &mark);
+        return false;
+    }
+    if (batch->lines == 0) {
+        batch->opened_us = esp_timer_get_time();
+    }
+    batch->lines++;
+    return true;
+}
+
+// Close and publish the batch if it holds anything, then start over. Not through safe_publish_mqtt:
+// its error log would come straight back into the ring.
+static void log_batch_publish(log_text_batch_t *batch, const char *topic, int qos) {
+    if (batch->lines == 0) {
+        return;
+    }
+    
+    json_writer_array_end(&batch->writer);
+    const char *json = json_writer_finish(&batch->writer, NULL);
+    if (json && g_mqtt_client && g_mqtt_connected) {
+        esp_mqtt_client_publish(g_mqtt_client, topic, json, 0, qos, 0);
+    }
+    log_batch_open(batch);
+}
+
+// Add a line, publishing the batch first when it is full
+static void log_batch_add(log_text_batch_t *batch, const char *topic, int qos, int64_t timestamp_us,
+                          const char *message, bool buffered, const char *reset_reason) {
+    if (!log_batch_append(batch, timestamp_us, message, buffered, reset_reason)) {
+        log_batch_publish(batch, topic, qos);
+        log_batch_append(batch, timestamp_us, message, buffered, reset_reason);
+    }
+}
+
+// Publish the header and the records collected so far, the decoder reads them one after another
+static void log_binary_batch_publish(log_binary_batch_t *batch, const char *topic, int qos) {
+    if (batch->length == 0) {
+        return;
+    }
+    
+    if (g_mqtt_client && g_mqtt_connected) {
+        esp_mqtt_client_publish(g_mqtt_client, topic, (const char *)batch->payload, batch->length, qos, 0);
+    }
+    batch->length = 0;
+}
+
+// Add a record, publishing the batch first when it is full. elf_sha256 names the build the records
+// belong to, NULL for the running one.
+static void log_binary_batch_add(log_binary_batch_t *batch, const char *topic, int qos, const uint8_t *elf_sha256,
+                                 const uint8_t *record, size_t length) {
+    if (batch->length + length > sizeof(batch->payload)) {
+        log_binary_batch_publish(batch, topic, qos);
+    }
+    if (batch->length == 0) {
+        if (elf_sha256) {
+            binlog_make_header(batch->payload, elf_sha256);
+        } else {
+            binlog_get_header(batch->payload);
+        }
+        batch->length = BINLOG_HEADER_SIZE;
+        batch->opened_us = esp_timer_get_time();
+    }
+    memcpy(batch->payload + batch->length, record, length);
+    batch->length += length;
+}
+
+// One "N messages suppressed" line per tag and level that lost lines since the last call,
+// into that level's batch
+static void log_rate_report(log_text_batch_t *batches) {
+    char tag[LOG_RATE_TAG_SIZE];
+    char line[LOG_RATE_TAG_SIZE + 48];
+    struct timeval now;
+    gettimeofday(&now, NULL);
+    
+    for (int i = 0; i < LOG_RATE_BUCKETS + LOG_FORWARD_LEVEL_COUNT; i++) {
+        bool other = i >= LOG_RATE_BUCKETS;
+        log_rate_bucket_t *bucket = other ? &g_log_rate_other[i - LOG_RATE_BUCKETS] : &g_log_rate_buckets[i];
+        uint8_t level = other ? i - LOG_RATE_BUCKETS : bucket->level;
+        uint32_t suppressed = log_rate_take_suppressed(bucket, tag);
+        if (suppressed == 0) {
+            continue;
+        }
+        
+        snprintf(line, sizeof(line), "%s: %lu messages suppressed", other ? "(other tags)" : tag, suppressed);
+        log_batch_add(&batches[level], g_log_topics[level], QOS_0, now.tv_sec * 1000000LL + now.tv_usec, line, false, NULL);
+    }
+}
+
+// Route ESP_LOGx output through custom_log_writer, once
+static void log_hook_install(void) {
+    if (!g_original_log_function) {
+        g_original_log_function = esp_log_set_vprintf(custom_log_writer);
+    }
+}
+
+// Restore the original log function
+static void log_hook_remove(void) {
+    if (g_original_log_function) {
+        esp_log_set_vprintf(g_original_log_function);
+        g_original_log_function = NULL;
+    }
+}
+
+// Binary log sink - BINLOG_x records take the same ring as text lines, nothing is formatted.
+// As for text lines only the MQTT path is limited: every record goes to the crash log as it is.
+static bool binlog_forward(const binlog_site_t *site, const uint8_t *record, size_t length) {
+    log_message_t log_msg;
+    
+    switch (site->level) {
+        case ESP_LOG_ERROR: log_msg.level = LOG_FORWARD_ERROR; break;
+        case ESP_LOG_WARN:  log_msg.level = LOG_FORWARD_WARNING; break;
+        case ESP_LOG_INFO:  log_msg.level = LOG_FORWARD_INFO; break;
+        default:            log_msg.level = LOG_FORWARD_DEBUG; break;
+    }
+    log_msg.length = length;
+    memcpy(log_msg.msg, record, length);
+    gettimeofday(&log_msg.timestamp, NULL);
+    crash_log_write_binlog(log_msg.timestamp.tv_sec * 1000000LL + log_msg.timestamp.tv_usec, record, length);
+    
+    if (!log_rate_allow(g_network_handle, *site->tag, strlen(*site->tag), log_msg.level)) {
+        return false;
+    }
+    if (!mpsc_ring_push(&g_log_ring, &log_msg)) {
+        atomic_fetch_add_explicit(&g_log_dropped, 1, memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
 // WiFi event handler
 static void wifi_event_handler(void* arg, esp_event_base_t event_base, int32_t event_id, void* event_data) {
     network_handle_t *handle = (network_handle_t *)arg;
@@ -429,12 +705,11 @@ static esp_err_t web_api_status_handler(httpd_req_t *req) {
         return ESP_FAIL;
     }
     
-    // Create status JSON
-    cJSON *json = cJSON_CreateObject();
-    if (!json) {
-        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Failed to create JSON");
-        return ESP_FAIL;
-    }
+    // Written straight into a stack buffer, nothing to allocate or free
+    char status_json[WEB_STATUS_JSON_SIZE];
+    json_writer_t writer;
+    json_writer_init(&writer, status_json, sizeof(status_json));
+    json_writer_object_begin(&writer, NULL);
     
     // Add basic status info
     const char *wifi_status_str = "Unknown";
@@ -445,32 +720,50 @@ static esp_err_t web_api_status_handler(httpd_req_t *req) {
         case WIFI_STATUS_FAILED: wifi_status_str = "Failed"; break;
     }
     
-    cJSON_AddStringToObject(json, "wifi_status", wifi_status_str);
-    cJSON_AddBoolToObject(json, "mqtt_connected", network_is_mqtt_connected());
-    cJSON_AddStringToObject(json, "ip_address", g_network_handle->ip_address);
-    cJSON_AddNumberToObject(json, "uptime_ms", esp_timer_get_time() / 1000);
-    cJSON_AddNumberToObject(json, "free_heap", esp_get_free_heap_size());
+    json_writer_string(&writer, "wifi_status", wifi_status_str);
+    json_writer_bool(&writer, "mqtt_connected", network_is_mqtt_connected());
+    json_writer_string(&writer, "ip_address", g_network_handle->ip_address);
+    json_writer_int(&writer, "uptime_ms", esp_timer_get_time() / 1000);
+    json_writer_uint(&writer, "free_heap", esp_get_free_heap_size());
     
     // Add last measurement if available (placeholder for now)
-    cJSON *measurement = cJSON_CreateObject();
-    float frequency = ade7953_get_latest_frequency(g_network_handle->ade7953_handle);
-    float voltage = ade7953_get_latest_voltage(g_network_handle->ade7953_handle);
-    cJSON_AddNumberToObject(measurement, "voltage", voltage);
-    cJSON_AddNumberToObject(measurement, "frequency", frequency);
-    cJSON_AddItemToObject(json, "last_measurement", measurement);
-    
-    char *json_string = cJSON_Print(json);
-    if (json_string) {
-        httpd_resp_set_type(req, "application/json");
-        httpd_resp_send(req, json_string, HTTPD_RESP_USE_STRLEN);
-        free(json_string);
-    } else {
+    json_writer_object_begin(&writer, "last_measurement");
+    json_writer_float(&writer, "voltage", ade7953_get_latest_voltage(g_network_handle->ade7953_handle), 3);
+    json_writer_float(&writer, "frequency", ade7953_get_latest_frequency(g_network_handle->ade7953_handle), 6);
+    if (g_network_handle->ade7953_handle && g_network_handle->ade7953_handle->calibration) {
+        json_writer_uint(&writer, "calibration_id", g_network_handle->ade7953_handle->calibration->id);
+    }
+    json_writer_object_end(&writer);
+    
+    // Hand-off from acquisition to publishing
+    if (g_network_handle->measurement_ring) {
+        spsc_ring_stats_t ring_stats;
+        spsc_ring_get_stats(g_network_handle->measurement_ring, &ring_stats);
+        json_writer_object_begin(&writer, "measurement_ring");
+        json_writer_uint(&writer, "capacity", ring_stats.capacity);
+        json_writer_uint(&writer, "high_water", ring_stats.high_water);
+        json_writer_uint(&writer, "dropped", ring_stats.drop_count);
+        json_writer_object_end(&writer);
+    }
+    
+    // Adaptive batching
+    static const char *link_state_names[] = { "healthy", "congested", "exhausted" };
+    json_writer_object_begin(&writer, "link");
+    json_writer_string(&writer, "state", link_state_names[g_network_handle->measurement_link_state]);
+    json_writer_int(&writer, "outbox_bytes", g_network_handle->mqtt_outbox_bytes);
+    json_writer_int(&writer, "rssi", g_network_handle->wifi_rssi);
+    json_writer_uint(&writer, "frame_span_s", g_network_handle->measurement_frame_span_s);
+    json_writer_object_end(&writer);
+    json_writer_object_end(&writer);
+    
+    size_t length;
+    if (!json_writer_finish(&writer, &length)) {
         httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Failed to serialize JSON");
-        cJSON_Delete(json);
         return ESP_FAIL;
     }
     
-    cJSON_Delete(json);
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_send(req, status_json, length);
     return ESP_OK;
 }
 
@@ -635,6 +928,121 @@ static esp_err_t web_api_restart_handler(httpd_req_t *req) {
     }
 }
 
+// Register field of a POST body, a number or a string such as "0x0102"
+static bool register_json_value(const cJSON *json, const char *name, uint32_t *value) {
+    const cJSON *item = cJSON_GetObjectItem(json, name);
+    
+    if (cJSON_IsNumber(item) && item->valuedouble >= 0 && item->valuedouble <= UINT32_MAX) {
+        *value = (uint32_t)item->valuedouble;
+        return true;
+    }
+    if (cJSON_IsString(item)) {
+        char *end;
+        *value = strtoul(item->valuestring, &end, 0);
+        return end != item->valuestring && *end == '\0';
+    }
+    return false;
+}
+
+// Web API register handler
+// GET /api/register?address=0x031C&bits=32 reads a register, except the status registers cleared on read.
+// POST /api/register {"address":"0x0381","bits":32,"value":"0x400000"} writes, calibration and thresholds only.
+// Runs in the web server task, so the access goes through the acquisition task's command queue
+static esp_err_t web_api_register_handler(httpd_req_t *req) {
+    if (!g_network_handle || !g_network_handle->ade7953_handle) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "ADE7953 handle not available");
+        return ESP_FAIL;
+    }
+    
+    uint16_t address;
+    uint8_t bits;
+    uint32_t value = 0;
+    bool write = req->method == HTTP_POST;
+    
+    if (write) {
+        char content[128];
+        int received = httpd_req_recv(req, content, sizeof(content) - 1);
+        if (received <= 0) {
+            httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Failed to receive data");
+            return ESP_FAIL;
+        }
+        content[received] = '\0';
+        
+        cJSON *json = cJSON_Parse(content);
+        uint32_t address_value, bits_value;
+        bool valid = json && register_json_value(json, "address", &address_value) &&
+                     register_json_value(json, "bits", &bits_value) && register_json_value(json, "value", &value);
+        cJSON_Delete(json);
+        if (!valid) {
+            httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "address, bits and value are required");
+            return ESP_FAIL;
+        }
+        if (address_value > UINT16_MAX || bits_value > 32 ||
+            !ade7953_register_writable((uint16_t)address_value, (uint8_t)bits_value)) {
+            ESP_LOGW(TAG, "Rejected write of register 0x%04lX (%lu bits)", address_value, bits_value);
+            httpd_resp_send_err(req, HTTPD_403_FORBIDDEN, "Register is not writable");
+            return ESP_FAIL;
+        }
+        address = (uint16_t)address_value;
+        bits = (uint8_t)bits_value;
+    } else {
+        char query[96];
+        char address_str[16], bits_str[8];
+        if (httpd_req_get_url_query_str(req, query, sizeof(query)) != ESP_OK ||
+            httpd_query_key_value(query, "address", address_str, sizeof(address_str)) != ESP_OK ||
+            httpd_query_key_value(query, "bits", bits_str, sizeof(bits_str)) != ESP_OK) {
+            httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "address and bits are required");
+            return ESP_FAIL;
+        }
+        uint32_t address_value = strtoul(address_str, NULL, 0);
+        uint32_t bits_value = strtoul(bits_str, NULL, 0);
+        if (address_value > UINT16_MAX || bits_value > 32 ||
+            !ade7953_register_readable((uint16_t)address_value, (uint8_t)bits_value)) {
+            ESP_LOGW(TAG, "Rejected read of register 0x%04lX (%lu bits)", address_value, bits_value);
+            httpd_resp_send_err(req, HTTPD_403_FORBIDDEN, "Register is not readable");
+            return ESP_FAIL;
+        }
+        address = (uint16_t)address_value;
+        bits = (uint8_t)bits_value;
+    }
+    
+    ade7953_error_t ret = write
+        ? ade7953_write_register_verified(g_network_handle->ade7953_handle, address, bits, value)
+        : ade7953_read_register(g_network_handle->ade7953_handle, address, bits, &value);
+    
+    cJSON *response = cJSON_CreateObject();
+    if (!response) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Failed to create JSON");
+        return ESP_FAIL;
+    }
+    
+    char hex[16];
+    snprintf(hex, sizeof(hex), "0x%04X", address);
+    cJSON_AddStringToObject(response, "address", hex);
+    cJSON_AddNumberToObject(response, "bits", bits);
+    cJSON_AddStringToObject(response, "operation", write ? "write" : "read");
+    cJSON_AddNumberToObject(response, "error", ret);
+    if (ret == ADE7953_OK) {
+        snprintf(hex, sizeof(hex), "0x%08lX", value);
+        cJSON_AddStringToObject(response, "value", hex);
+    }
+    
+    char *response_string = cJSON_Print(response);
+    cJSON_Delete(response);
+    if (!response_string) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Failed to serialize JSON");
+        return ESP_FAIL;
+    }
+    
+    if (ret != ADE7953_OK) {
+        httpd_resp_set_status(req, ret == ADE7953_ERROR_TIMEOUT ? "504 Gateway Timeout" : "502 Bad Gateway");
+    }
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_send(req, response_string, HTTPD_RESP_USE_STRLEN);
+    free(response_string);
+    return ESP_OK;
+}
+
 // MQTT event handler
 static void mqtt_event_handler(void *handler_args, esp_event_base_t base, int32_t event_id, void *event_data)
 {
@@ -659,9 +1067,10 @@ static void mqtt_event_handler(void *handler_args, esp_event_base_t base, int32_
                 network_flush_log_buffer(g_network_handle);
             }
             
-            // Publish firmware information on connect
+            // Publish firmware information on connect, then what was logged before the reset it reports
             if (g_network_handle) {
                 network_publish_firmware_info(g_network_handle);
+                network_publish_crash_log(g_network_handle);
             }
 
             // Subscribe to command topic if command handling is enabled
@@ -866,25 +1275,62 @@ static void mqtt_logging_task(void *pvParameters) {
     network_handle_t *handle = (network_handle_t *)pvParameters;
     log_message_t log_msg;
     TickType_t system_info_timer = 0;
+    TickType_t rate_summary_timer = xTaskGetTickCount();
     char system_info[512];
+    measurement_loss_stats_t loss;
+    
+    // One batch per level and kind, about 8 KB of this task's stack
+    log_text_batch_t text_batches[LOG_FORWARD_LEVEL_COUNT];
+    log_binary_batch_t binary_batches[LOG_FORWARD_LEVEL_COUNT];
+    for (int level = 0; level < LOG_FORWARD_LEVEL_COUNT; level++) {
+        log_batch_open(&text_batches[level]);
+        binary_batches[level].length = 0;
+    }
     
     ESP_LOGI(TAG, "MQTT logging task started");
     
     while (handle->mqtt_logging_enabled) {
-        // Check for log messages in queue
-        if (xQueueReceive(handle->log_queue, &log_msg, pdMS_TO_TICKS(100)) == pdTRUE) {
-            if (handle->status == WIFI_STATUS_CONNECTED && g_mqtt_connected && log_msg.msg != NULL) {
-                // Forward log message via MQTT
-                const char *topic = log_msg.topic ? log_msg.topic : handle->mqtt_topic_logs;
-                esp_mqtt_client_publish(g_mqtt_client, topic, log_msg.msg, 0, QOS_0, 0);
+        // Collect everything logged since the last pass, lines are dropped while offline
+        while (mpsc_ring_pop(handle->log_ring, &log_msg)) {
+            if (handle->status != WIFI_STATUS_CONNECTED || !g_mqtt_connected) {
+                continue;
             }
             
-            // Free the allocated message memory
-            if (log_msg.msg != NULL) {
-                free(log_msg.msg);
+            uint8_t level = log_msg.level;
+            if (log_msg.length > 0) {
+                // Records behind one payload header, tools/log_decoder.py expands them with the ELF
+                log_binary_batch_add(&binary_batches[level], g_binlog_topics[level], QOS_0, NULL,
+                                     (const uint8_t *)log_msg.msg, log_msg.length);
+            } else {
+                log_batch_add(&text_batches[level], g_log_topics[level], QOS_0,
+                              log_msg.timestamp.tv_sec * 1000000LL + log_msg.timestamp.tv_usec,
+                              log_line_trim(log_msg.msg), false, NULL);
             }
-            if (log_msg.topic != NULL) {
-                free(log_msg.topic);
+            
+            // Errors are not held back, nothing is without batching
+            if (level == LOG_FORWARD_ERROR || !handle->log_batching) {
+                log_batch_publish(&text_batches[level], g_log_topics[level], QOS_0);
+                log_binary_batch_publish(&binary_batches[level], g_binlog_topics[level], QOS_0);
+            }
+        }
+        
+        // Report what the rate limit held back, counts are kept while offline
+        if (handle->status == WIFI_STATUS_CONNECTED && g_mqtt_connected &&
+            (xTaskGetTickCount() - rate_summary_timer) > pdMS_TO_TICKS(LOG_RATE_SUMMARY_INTERVAL_MS)) {
+            log_rate_report(text_batches);
+            rate_summary_timer = xTaskGetTickCount();
+        }
+        
+        // Publish batches whose oldest line has waited long enough
+        int64_t now_us = esp_timer_get_time();
+        for (int level = 0; level < LOG_FORWARD_LEVEL_COUNT; level++) {
+            if (text_batches[level].lines > 0 &&
+                now_us - text_batches[level].opened_us >= LOG_BATCH_MAX_AGE_MS * 1000LL) {
+                log_batch_publish(&text_batches[level], g_log_topics[level], QOS_0);
+            }
+            if (binary_batches[level].length > 0 &&
+                now_us - binary_batches[level].opened_us >= LOG_BATCH_MAX_AGE_MS * 1000LL) {
+                log_binary_batch_publish(&binary_batches[level], g_binlog_topics[level], QOS_0);
             }
         }
         
@@ -892,28 +1338,40 @@ static void mqtt_logging_task(void *pvParameters) {
         if (handle->status == WIFI_STATUS_CONNECTED && g_mqtt_connected &&
             (xTaskGetTickCount() - system_info_timer) > pdMS_TO_TICKS(MQTT_STATUS_INTERVAL)) {
             
-            snprintf(system_info, sizeof(system_info), 
-                "{\"device\":\"open_grid_monitor\",\"ip\":\"%s\",\"uptime\":%lu,\"free_heap\":%lu,\"timestamp\":%llu}",
-                handle->ip_address, 
-                xTaskGetTickCount() * portTICK_PERIOD_MS / 1000, 
-                esp_get_free_heap_size(),
-                time(NULL)
-            );
+            json_writer_t writer;
+            json_writer_init(&writer, system_info, sizeof(system_info));
+            json_writer_object_begin(&writer, NULL);
+            json_writer_string(&writer, "device", "open_grid_monitor");
+            json_writer_string(&writer, "ip", handle->ip_address);
+            json_writer_uint(&writer, "uptime", xTaskGetTickCount() * portTICK_PERIOD_MS / 1000);
+            json_writer_uint(&writer, "free_heap", esp_get_free_heap_size());
+            json_writer_int(&writer, "timestamp", time(NULL));
+            
+            // Loss counters are cumulative since boot, the sequence says how many samples they are out of
+            network_get_measurement_loss_stats(handle, &loss);
+            json_writer_object_begin(&writer, "samples");
+            json_writer_uint(&writer, "sequence", loss.sequence);
+            json_writer_uint(&writer, "queue_full", loss.queue_full);
+            json_writer_uint(&writer, "plausibility_reject", loss.plausibility_reject);
+            json_writer_uint(&writer, "not_connected", loss.not_connected);
+            json_writer_uint(&writer, "publish_error", loss.publish_error);
+            json_writer_object_end(&writer);
+            json_writer_uint(&writer, "log_dropped", atomic_load_explicit(&g_log_dropped, memory_order_relaxed));
+            json_writer_uint(&writer, "log_suppressed", atomic_load_explicit(&g_log_suppressed, memory_order_relaxed));
+            json_writer_object_end(&writer);
             
-            safe_publish_mqtt_default(handle->mqtt_topic_system, system_info);
+            if (json_writer_finish(&writer, NULL)) {
+                safe_publish_mqtt_default(handle->mqtt_topic_system, system_info);
+            }
             system_info_timer = xTaskGetTickCount();
             ESP_LOGD(TAG, "Published system info to %s", handle->mqtt_topic_system);
         }
+        
+        vTaskDelay(pdMS_TO_TICKS(LOG_RING_POLL_MS));
     }
     
-    // Clean up remaining messages in queue
-    while (xQueueReceive(handle->log_queue, &log_msg, 0) == pdTRUE) {
-        if (log_msg.msg != NULL) {
-            free(log_msg.msg);
-        }
-        if (log_msg.topic != NULL) {
-            free(log_msg.topic);
-        }
+    // Discard what is left, the slots are static and the batches on the stack so there is nothing to free
+    while (mpsc_ring_pop(handle->log_ring, &log_msg)) {
     }
     
     ESP_LOGI(TAG, "MQTT logging task stopped");
@@ -923,6 +1381,23 @@ static void mqtt_logging_task(void *pvParameters) {
     vTaskDelete(NULL);
 }
 
+// Helper function to convert reset reason enum to string
+static const char* reset_reason_to_string(esp_reset_reason_t reason) {
+    switch (reason) {
+        case ESP_RST_POWERON: return "power_on";
+        case ESP_RST_EXT: return "external_reset";
+        case ESP_RST_SW: return "software_reset";
+        case ESP_RST_PANIC: return "panic";
+        case ESP_RST_INT_WDT: return "interrupt_watchdog";
+        case ESP_RST_TASK_WDT: return "task_watchdog";
+        case ESP_RST_WDT: return "other_watchdog";
+        case ESP_RST_DEEPSLEEP: return "deep_sleep";
+        case ESP_RST_BROWNOUT: return "brownout";
+        case ESP_RST_SDIO: return "sdio";
+        default: return "unknown";
+    }
+}
+
 // Helper function to convert OTA state enum to string
 static const char* ota_state_to_string(esp_ota_img_states_t state) {
     switch (state) {
@@ -946,6 +1421,9 @@ static const char* ota_state_to_string(esp_ota_img_states_t state) {
 // SNTP time synchronization callback
 static void sntp_sync_notification_cb(struct timeval *tv) {
     g_time_synced = true;
+    if (g_network_handle && g_network_handle->ade7953_handle) {
+        ade7953_set_time_synchronized(g_network_handle->ade7953_handle, true);
+    }
     ESP_LOGI(TAG, "Time synchronized via SNTP");
 }
 
@@ -955,7 +1433,9 @@ esp_err_t network_init_sntp(void) {
     
     esp_sntp_setoperatingmode(SNTP_OPMODE_POLL);
     esp_sntp_setservername(0, SNTP_SERVER);
-    esp_sntp_set_sync_mode(SNTP_SYNC_MODE_IMMED);
+    // Slew rather than step once synchronized, so synchrophasor angles and timestamps never jump
+    // (the first sync still steps, the clock starts out decades off)
+    esp_sntp_set_sync_mode(SNTP_SYNC_MODE_SMOOTH);
     esp_sntp_set_time_sync_notification_cb(sntp_sync_notification_cb);
     esp_sntp_init();
     
@@ -983,40 +1463,452 @@ int64_t network_get_time_ms(void) {
     return (int64_t)tv.tv_sec * 1000LL + (int64_t)tv.tv_usec / 1000LL;
 }
 
+// Send the current measurement frame. While offline, with the outbox exhausted, or if the client refuses it,
+// the frame goes to the flash spool for the backfill; only without a spool, or if the append fails, is it
+// dropped and its samples counted as lost. The sequence number advances either way, so the ingest side can
+// tell frames that never arrive apart.
+static void publish_measurement_frame(network_handle_t *handle) {
+    measurement_frame_t *frame = handle->measurement_frame;
+    size_t length = measurement_frame_finish(frame);
+    
+    if (length > 0) {
+        // Enqueued rather than published, so a slow link fills the outbox (which we watch) instead of blocking this task
+        int msg_id = -1;
+        if (handle->status == WIFI_STATUS_CONNECTED && g_mqtt_connected && g_mqtt_client &&
+            handle->measurement_link_state != MEASUREMENT_LINK_EXHAUSTED) {
+            msg_id = esp_mqtt_client_enqueue(g_mqtt_client, handle->mqtt_topic_measurement_frame, (const char *)frame->buffer, length, QOS_0, 0, true);
+        }
+        
+        // Offline, outbox at its bound, or the client refused it: keep the frame on flash for the backfill
+        if (msg_id < 0 && (!handle->measurement_spool ||
+                           storage_log_append(handle->measurement_spool, frame->buffer, length) != STORAGE_OK)) {
+            if (handle->status == WIFI_STATUS_CONNECTED && g_mqtt_connected) {
+                handle->measurement_lost_publish_error += frame->sample_count;
+            } else {
+                handle->measurement_lost_not_connected += frame->sample_count;
+            }
+        }
+    }
+    measurement_frame_reset(frame);
+}
+
+// Classify the link from the esp-mqtt outbox and the RSSI, and step the frame span once per check:
+// doubled while congested, halved while healthy, kept in the hysteresis band between
+static void update_measurement_backpressure(network_handle_t *handle) {
+    int64_t now_us = esp_timer_get_time();
+    if (now_us - handle->measurement_backpressure_checked_us < MEASUREMENT_BACKPRESSURE_INTERVAL_US) {
+        return;
+    }
+    handle->measurement_backpressure_checked_us = now_us;
+    
+    wifi_ap_record_t ap_info;
+    if (handle->status == WIFI_STATUS_CONNECTED && esp_wifi_sta_get_ap_info(&ap_info) == ESP_OK) {
+        handle->wifi_rssi = ap_info.rssi;
+    }
+    handle->mqtt_outbox_bytes = g_mqtt_client ? esp_mqtt_client_get_outbox_size(g_mqtt_client) : 0;
+    
+    measurement_link_state_t previous = handle->measurement_link_state;
+    bool weak_signal = handle->wifi_rssi != 0 && handle->wifi_rssi < WIFI_RSSI_WEAK_DBM;
+    bool good_signal = handle->wifi_rssi == 0 || handle->wifi_rssi >= WIFI_RSSI_WEAK_DBM + WIFI_RSSI_HYSTERESIS_DB;
+    
+    if (handle->mqtt_outbox_bytes >= (int)handle->mqtt_outbox_limit_bytes) {
+        handle->measurement_link_state = MEASUREMENT_LINK_EXHAUSTED;
+    } else if (handle->mqtt_outbox_bytes >= MQTT_OUTBOX_HIGH_WATER_BYTES || weak_signal) {
+        handle->measurement_link_state = MEASUREMENT_LINK_CONGESTED;
+    } else if (handle->mqtt_outbox_bytes <= MQTT_OUTBOX_LOW_WATER_BYTES && good_signal) {
+        handle->measurement_link_state = MEASUREMENT_LINK_HEALTHY;
+    }
+    
+    uint32_t span_s = handle->measurement_frame_span_s;
+    if (handle->measurement_link_state == MEASUREMENT_LINK_HEALTHY) {
+        span_s = span_s / 2 >= MEASUREMENT_MIN_FRAME_SPAN_S ? span_s / 2 : MEASUREMENT_MIN_FRAME_SPAN_S;
+    } else {
+        span_s = span_s * 2 <= handle->measurement_max_frame_span_s ? span_s * 2 : handle->measurement_max_frame_span_s;
+    }
+    
+    if (handle->measurement_link_state != previous || span_s != handle->measurement_frame_span_s) {
+        static const char *state_names[] = { "healthy", "congested", "exhausted" };
+        ESP_LOGI(TAG, "Link %s (outbox %d bytes, RSSI %d dBm), frame span %lu s",
+                 state_names[handle->measurement_link_state], handle->mqtt_outbox_bytes, handle->wifi_rssi, span_s);
+    }
+    handle->measurement_frame_span_s = span_s;
+}
+
+// Spool while offline; once back online, replay spooled frames at a bounded rate between the live ones
+static void service_measurement_spool(network_handle_t *handle, bool *was_online) {
+    storage_log_t *spool = handle->measurement_spool;
+    bool online = handle->status == WIFI_STATUS_CONNECTED && g_mqtt_connected && g_mqtt_client;
+    
+    if (!online) {
+        storage_log_poll(spool);
+        *was_online = false;
+        return;
+    }
+    
+    // Close the outage's segment so it can be replayed
+    if (!*was_online) {
+        storage_log_seal(spool);
+        *was_online = true;
+    }
+    
+    // Frames spilled while online (outbox exhausted) are flushed on the same schedule as while offline
+    storage_log_poll(spool);
+    
+    // Replay only adds to the load of a congested link
+    int64_t now_us = esp_timer_get_time();
+    if (handle->measurement_link_state != MEASUREMENT_LINK_HEALTHY ||
+        now_us - handle->measurement_backfill_last_us < MEASUREMENT_BACKFILL_INTERVAL_US) {
+        return;
+    }
+    
+    // Healthy again: once the older backlog is replayed, seal what was spilled since so it follows.
+    // Not before, so a flapping link does not leave a string of small segments to take the slots.
+    if (!storage_log_pending(spool) && storage_log_unsealed(spool)) {
+        storage_log_seal(spool);
+    }
+    
+    size_t length = storage_log_peek(spool, g_backfill_buffer, sizeof(g_backfill_buffer));
+    if (length == 0) {
+        return;
+    }
+    
+    // QoS 1 and a separate topic, so live sequence tracking is not disturbed and the frame is only dropped once accepted
+    handle->measurement_backfill_last_us = now_us;
+    if (esp_mqtt_client_enqueue(g_mqtt_client, handle->mqtt_topic_measurement_backfill, (const char *)g_backfill_buffer, length, QOS_1, 0, true) >= 0) {
+        storage_log_advance(spool);
+    }
+}
+
+// Add a measurement to the current frame, sending the frame once the sample closes it
+static void batch_measurement(network_handle_t *handle, const measurement_t *measurement) {
+    measurement_frame_t *frame = handle->measurement_frame;
+    
+    if (!measurement_frame_fits(frame, measurement)) {
+        publish_measurement_frame(handle);
+    }
+    if (frame->sample_count == 0) {
+        // A new span from the backpressure check takes effect with the next frame
+        measurement_frame_set_span(frame, handle->measurement_frame_span_s);
+        handle->measurement_frame_opened_us = esp_timer_get_time();
+    }
+    measurement_frame_add(frame, measurement);
+    
+    if (measurement_frame_full(frame)) {
+        publish_measurement_frame(handle);
+    }
+}
+
+// Publish a harmonic analysis record
+static void publish_harmonics_record(network_handle_t *handle, const harmonics_record_t *record) {
+    json_writer_t writer;
+    json_writer_init(&writer, g_measurement_json, sizeof(g_measurement_json));
+    json_writer_object_begin(&writer, NULL);
+    json_writer_int(&writer, "timestamp", record->timestamp_us);
+    json_writer_float(&writer, "frequency", record->frequency, 6);
+    json_writer_float(&writer, "voltage", record->fundamental_voltage, 3);
+    json_writer_float(&writer, "thd", record->thd, 3);
+    
+    // Orders 2..HARMONICS_MAX_ORDER in % of the fundamental
+    json_writer_array_begin(&writer, "harmonics");
+    for (int i = 0; i < HARMONICS_COUNT; i++) {
+        json_writer_float(&writer, NULL, record->magnitudes[i] / HARMONICS_MAGNITUDE_SCALE, 3);
+    }
+    json_writer_array_end(&writer);
+    json_writer_object_end(&writer);
+    
+    size_t length;
+    if (json_writer_finish(&writer, &length)) {
+        esp_mqtt_client_publish(g_mqtt_client, handle->mqtt_topic_harmonics, g_measurement_json, length, QOS_0, 0);
+    }
+}
+
+// Publish a closed aggregation window on its tier's topic and QoS
+static void publish_aggregation_record(network_handle_t *handle, const aggregation_record_t *record) {
+    if (handle->status != WIFI_STATUS_CONNECTED || !g_mqtt_connected || !g_mqtt_client) {
+        return;
+    }
+    
+    // Flat fields, so Telegraf's json input maps them one to one
+    json_writer_t writer;
+    json_writer_init(&writer, g_measurement_json, sizeof(g_measurement_json));
+    json_writer_object_begin(&writer, NULL);
+    json_writer_int(&writer, "timestamp", record->start_us);
+    json_writer_uint(&writer, "count", record->count);
+    json_writer_float(&writer, "frequency_min", record->frequency.min, 6);
+    json_writer_float(&writer, "frequency_max", record->frequency.max, 6);
+    json_writer_float(&writer, "frequency_mean", record->frequency.mean, 6);
+    json_writer_float(&writer, "frequency_stddev", record->frequency.stddev, 6);
+    json_writer_float(&writer, "voltage_min", record->voltage.min, 3);
+    json_writer_float(&writer, "voltage_max", record->voltage.max, 3);
+    json_writer_float(&writer, "voltage_mean", record->voltage.mean, 3);
+    json_writer_float(&writer, "voltage_stddev", record->voltage.stddev, 3);
+    
+    // Streaming estimates, so reports need no pass over the raw data
+    if (record->has_quantiles) {
+        static const char *quantile_names[AGGREGATION_QUANTILE_COUNT] = AGGREGATION_QUANTILE_NAMES;
+        char key[32];
+        for (size_t i = 0; i < AGGREGATION_QUANTILE_COUNT; i++) {
+            snprintf(key, sizeof(key), "frequency_deviation_%s", quantile_names[i]);
+            json_writer_float(&writer, key, record->deviation_quantiles[i], 6);
+        }
+    }
+    json_writer_object_end(&writer);
+    
+    size_t length;
+    if (json_writer_finish(&writer, &length)) {
+        uint8_t qos = handle->aggregation->tiers[record->tier].config.qos;
+        esp_mqtt_client_enqueue(g_mqtt_client, g_aggregate_topics[record->tier], g_measurement_json, length, qos, 0, true);
+    }
+}
+
+// Messages a capture takes, at least one for the summary
+static size_t grid_event_chunk_count(const grid_event_record_t *record) {
+    return record->sample_count == 0 ? 1 : (record->sample_count + EVENT_CHUNK_SAMPLES - 1) / EVENT_CHUNK_SAMPLES;
+}
+
+// Publish one chunk of a frozen grid event capture: every chunk carries the event's timestamp and
+// sequence with its index and EVENT_CHUNK_SAMPLES points from first_index, chunk 0 also the summary
+static void publish_grid_event_chunk(network_handle_t *handle, const grid_event_record_t *record, size_t chunk) {
+    size_t chunks = grid_event_chunk_count(record);
+    size_t first = chunk * EVENT_CHUNK_SAMPLES;
+    size_t end = MIN(first + EVENT_CHUNK_SAMPLES, record->sample_count);
+    json_writer_t writer;
+    
+    json_writer_init(&writer, g_event_json, sizeof(g_event_json));
+    json_writer_object_begin(&writer, NULL);
+    json_writer_int(&writer, "timestamp", record->trigger_timestamp_us);
+    json_writer_uint(&writer, "sequence", record->sequence);
+    json_writer_uint(&writer, "chunk", chunk);
+    json_writer_uint(&writer, "chunks", chunks);
+    json_writer_uint(&writer, "first_index", first);
+    
+    if (chunk == 0) {
+        float min_frequency = record->trigger_frequency, max_frequency = record->trigger_frequency;
+        float min_voltage = record->trigger_voltage, max_voltage = record->trigger_voltage;
+        float max_rocof = 0.0f;
+        for (size_t i = 0; i < record->sample_count; i++) {
+            const grid_events_sample_t *sample = &record->samples[i];
+            min_frequency = fminf(min_frequency, sample->frequency);
+            max_frequency = fmaxf(max_frequency, sample->frequency);
+            min_voltage = fminf(min_voltage, sample->voltage);
+            max_voltage = fmaxf(max_voltage, sample->voltage);
+            if (fabsf(sample->rocof) > fabsf(max_rocof)) {
+                max_rocof = sample->rocof;
+            }
+        }
+        
+        json_writer_array_begin(&writer, "causes");
+        for (uint32_t cause = 1; cause <= GRID_EVENT_CAUSE_SWELL; cause <<= 1) {
+            if (record->causes & cause) {
+                json_writer_string(&writer, NULL, grid_events_cause_name(cause));
+            }
+        }
+        json_writer_array_end(&writer);
+        json_writer_object_begin(&writer, "trigger");
+        json_writer_float(&writer, "frequency", record->trigger_frequency, 4);
+        json_writer_float(&writer, "rocof", record->trigger_rocof, 4);
+        json_writer_float(&writer, "voltage", record->trigger_voltage, 2);
+        json_writer_object_end(&writer);
+        json_writer_float(&writer, "frequency_min", min_frequency, 4);
+        json_writer_float(&writer, "frequency_max", max_frequency, 4);
+        json_writer_float(&writer, "rocof_max", max_rocof, 4);
+        json_writer_float(&writer, "voltage_min", min_voltage, 2);
+        json_writer_float(&writer, "voltage_max", max_voltage, 2);
+        json_writer_uint(&writer, "trigger_index", record->trigger_index);
+        json_writer_uint(&writer, "sample_count", record->sample_count);
+    }
+    
+    // Columns, with times as microsecond offsets from the trigger
+    json_writer_array_begin(&writer, "offset_us");
+    for (size_t i = first; i < end; i++) {
+        json_writer_int(&writer, NULL, record->samples[i].timestamp_us - record->trigger_timestamp_us);
+    }
+    json_writer_array_end(&writer);
+    json_writer_array_begin(&writer, "frequency");
+    for (size_t i = first; i < end; i++) {
+        json_writer_float(&writer, NULL, record->samples[i].frequency, 4);
+    }
+    json_writer_array_end(&writer);
+    json_writer_array_begin(&writer, "rocof");
+    for (size_t i = first; i < end; i++) {
+        json_writer_float(&writer, NULL, record->samples[i].rocof, 3);
+    }
+    json_writer_array_end(&writer);
+    json_writer_array_begin(&writer, "voltage");
+    for (size_t i = first; i < end; i++) {
+        json_writer_float(&writer, NULL, record->samples[i].voltage, 1);
+    }
+    json_writer_array_end(&writer);
+    json_writer_object_end(&writer);
+    
+    size_t length;
+    if (!json_writer_finish(&writer, &length)) {
+        ESP_LOGE(TAG, "Grid event %lu chunk %u does not fit the JSON buffer", record->sequence, (unsigned int)chunk);
+        return;
+    }
+    // QoS 1, an event is rare and worth the acknowledgement. Enqueued: the outbox holds the copy until acknowledged.
+    esp_mqtt_client_enqueue(g_mqtt_client, handle->mqtt_topic_events, g_event_json, length, QOS_1, 0, true);
+    if (chunk + 1 == chunks) {
+        ESP_LOGI(TAG, "Published grid event %lu (%u samples in %u messages)", record->sequence,
+                 (unsigned int)record->sample_count, (unsigned int)chunks);
+    }
+}
+
+// Publish queued synchrophasor reports as binary C37.118 data frames, preceded by the CFG-2 frame once per connection
+static void publish_synchrophasors(network_handle_t *handle, bool *config_sent) {
+    synchrophasor_measurement_t phasor;
+    uint8_t frame[C37118_CONFIG_FRAME_SIZE];
+    
+    while (xQueueReceive(handle->synchrophasor_queue, &phasor, 0) == pdTRUE) {
+        if (!*config_sent) {
+            size_t length = synchrophasor_encode_config_frame(handle->pmu_idcode, handle->pmu_station_name,
+                                                              handle->ade7953_handle->synchrophasor_rate,
+                                                              (uint32_t)handle->ade7953_handle->nominal_frequency,
+                                                              phasor.timestamp_us, frame, sizeof(frame));
+            // Retained, so a PDC bridge that subscribes later can still decode the data frames
+            esp_mqtt_client_publish(g_mqtt_client, handle->mqtt_topic_synchrophasor_config, (const char *)frame, length, QOS_1, 1);
+            *config_sent = true;
+        }
+        
+        size_t length = synchrophasor_encode_data_frame(&phasor, handle->pmu_idcode, frame, sizeof(frame));
+        esp_mqtt_client_publish(g_mqtt_client, handle->mqtt_topic_synchrophasor, (const char *)frame, length, QOS_0, 0);
+    }
+}
+
 // Measurement publishing task
 static void measurement_publishing_task(void *pvParameters) {
     network_handle_t *handle = (network_handle_t *)pvParameters;
-    measurement_t measurement;
+    measurement_t measurements[MEASUREMENT_RING_BULK_SIZE];
+    aggregation_record_t aggregates[AGGREGATION_MAX_TIERS];
+    harmonics_record_t harmonics;
+    grid_event_record_t *event = NULL;                  // Being published, EVENT_CHUNK_SAMPLES points per message
+    size_t event_chunk = 0;
+    bool synchrophasor_config_sent = false;
+    bool spool_online = false;
     
     ESP_LOGI(TAG, "Measurement publishing task started");
     
     while (handle->measurement_publishing_enabled) {
-        // Wait for measurement data
-        if (xQueueReceive(handle->measurement_queue, &measurement, pdMS_TO_TICKS(20)) == pdTRUE) {
-            if (handle->status == WIFI_STATUS_CONNECTED && g_mqtt_connected && g_mqtt_client) {
-                // Create JSON payload
-                cJSON *json = cJSON_CreateObject();
-                if (json != NULL) {
-                    cJSON_AddNumberToObject(json, "timestamp", measurement.timestamp_us);
-                    cJSON_AddNumberToObject(json, "frequency", measurement.frequency);
-                    cJSON_AddNumberToObject(json, "voltage", measurement.voltage);
-                    
-                    char *json_string = cJSON_Print(json);
-                    if (json_string != NULL) {
-                        // Publish to MQTT
-                        esp_mqtt_client_publish(g_mqtt_client, handle->mqtt_topic_measurement, json_string, 0, QOS_0, 0);
-                        free(json_string);
-                    }
-                    cJSON_Delete(json);
+        // Drain a batch of measurements, or sleep a poll interval if none are waiting
+        size_t count = spsc_ring_pop_bulk(handle->measurement_ring, measurements, MEASUREMENT_RING_BULK_SIZE);
+        if (count == 0) {
+            vTaskDelay(pdMS_TO_TICKS(MEASUREMENT_RING_POLL_MS));
+        }
+        
+        for (size_t i = 0; i < count; i++) {
+            const measurement_t *measurement = &measurements[i];
+            
+            // Aggregates are independent of the raw stream, and only ever cost a message per window
+            if (handle->aggregation) {
+                size_t closed = aggregation_push(handle->aggregation, measurement->timestamp_us,
+                                                 ade7953_measurement_frequency(measurement),
+                                                 ade7953_measurement_voltage(measurement), aggregates);
+                for (size_t j = 0; j < closed; j++) {
+                    publish_aggregation_record(handle, &aggregates[j]);
+                }
+            }
+            
+            if (!handle->measurement_raw_enabled) {
+                continue;
+            }
+            if (handle->measurement_frame) {
+                batch_measurement(handle, measurement);
+            } else if (handle->status == WIFI_STATUS_CONNECTED && g_mqtt_connected && g_mqtt_client) {
+                // Raw codes are converted here, at the edge: µHz and mV resolution
+                json_writer_t writer;
+                json_writer_init(&writer, g_measurement_json, sizeof(g_measurement_json));
+                json_writer_object_begin(&writer, NULL);
+                json_writer_int(&writer, "timestamp", measurement->timestamp_us);
+                json_writer_uint(&writer, "sequence", measurement->sequence);
+                json_writer_float(&writer, "frequency", ade7953_measurement_frequency(measurement), 6);
+                json_writer_float(&writer, "voltage", ade7953_measurement_voltage(measurement), 3);
+                json_writer_object_end(&writer);
+                
+                size_t length;
+                int msg_id = -1;
+                if (json_writer_finish(&writer, &length)) {
+                    msg_id = esp_mqtt_client_publish(g_mqtt_client, handle->mqtt_topic_measurement, g_measurement_json, length, QOS_0, 0);
+                }
+                if (msg_id < 0) {
+                    handle->measurement_lost_publish_error++;
                 }
+            } else {
+                handle->measurement_lost_not_connected++;
             }
         }
+        
+        // A partly filled frame still goes out if the samples stop before the end of its span
+        if (handle->measurement_frame && handle->measurement_frame->sample_count > 0 &&
+            esp_timer_get_time() - handle->measurement_frame_opened_us >=
+            (int64_t)handle->measurement_frame->span_s * 1000000 + MEASUREMENT_FRAME_AGE_GRACE_US) {
+            publish_measurement_frame(handle);
+        }
+        
+        if (handle->measurement_frame) {
+            update_measurement_backpressure(handle);
+        }
+        
+        // Windows whose samples stopped coming
+        if (handle->aggregation) {
+            size_t closed = aggregation_flush(handle->aggregation, network_get_time_ms() * 1000, aggregates);
+            for (size_t j = 0; j < closed; j++) {
+                publish_aggregation_record(handle, &aggregates[j]);
+            }
+        }
+        
+        if (handle->measurement_spool) {
+            service_measurement_spool(handle, &spool_online);
+        }
+        
+        // Harmonic records are rare (about one per second), so just poll for them
+        if (xQueueReceive(handle->harmonics_queue, &harmonics, 0) == pdTRUE) {
+            if (handle->status == WIFI_STATUS_CONNECTED && g_mqtt_connected && g_mqtt_client) {
+                publish_harmonics_record(handle, &harmonics);
+            }
+        }
+        
+        // Grid events, a chunk per pass while the outbox is below its high water mark. The record goes back
+        // to the detector after the last chunk, or at once while offline.
+        if (!event && xQueueReceive(handle->events_queue, &event, 0) == pdTRUE) {
+            event_chunk = 0;
+        }
+        if (event) {
+            if (handle->status != WIFI_STATUS_CONNECTED || !g_mqtt_connected || !g_mqtt_client) {
+                event_chunk = grid_event_chunk_count(event);
+            } else if (esp_mqtt_client_get_outbox_size(g_mqtt_client) < MQTT_OUTBOX_HIGH_WATER_BYTES) {
+                publish_grid_event_chunk(handle, event, event_chunk++);
+            }
+            if (event_chunk >= grid_event_chunk_count(event)) {
+                grid_events_release(event);
+                event = NULL;
+            }
+        }
+        
+        // Synchrophasors, up to 50 per second, so drain everything that is waiting
+        if (handle->status == WIFI_STATUS_CONNECTED && g_mqtt_connected && g_mqtt_client) {
+            publish_synchrophasors(handle, &synchrophasor_config_sent);
+        } else {
+            xQueueReset(handle->synchrophasor_queue);
+            synchrophasor_config_sent = false;
+        }
     }
     
-    // Clean up remaining measurements in queue
-    while (xQueueReceive(handle->measurement_queue, &measurement, 0) == pdTRUE) {
-        // Just drain the queue
+    // Send what has been batched so far, then clean up remaining measurements in queue
+    if (handle->measurement_frame) {
+        publish_measurement_frame(handle);
+    }
+    if (handle->measurement_spool) {
+        storage_log_seal(handle->measurement_spool);
     }
+    spsc_ring_discard(handle->measurement_ring);
+    xQueueReset(handle->harmonics_queue);
+    if (event) {
+        grid_events_release(event);
+    }
+    while (xQueueReceive(handle->events_queue, &event, 0) == pdTRUE) {
+        grid_events_release(event);
+    }
+    xQueueReset(handle->synchrophasor_queue);
     
     ESP_LOGI(TAG, "Measurement publishing task stopped");
     
@@ -1039,19 +1931,35 @@ esp_err_t network_init(network_handle_t *handle, led_handle_t *led_handle, ade79
     
     g_network_handle = handle;
     
-    // Create log queue
-    handle->log_queue = xQueueCreate(MQTT_QUEUE_SIZE, sizeof(log_message_t));
-    if (!handle->log_queue) {
-        ESP_LOGE(TAG, "Failed to create log queue");
+    // Log ring, its storage is static so this cannot run out of memory
+    mpsc_ring_init(&g_log_ring, g_log_ring_storage, LOG_RING_SIZE, sizeof(log_message_t));
+    handle->log_ring = &g_log_ring;
+    
+    // Measurement ring, its storage is static so this cannot run out of memory
+    spsc_ring_init(&g_measurement_ring, g_measurement_ring_storage, MEASUREMENT_RING_SIZE, sizeof(measurement_t));
+    handle->measurement_ring = &g_measurement_ring;
+    
+    // Create harmonics queue
+    handle->harmonics_queue = xQueueCreate(HARMONICS_QUEUE_SIZE, sizeof(harmonics_record_t));
+    if (!handle->harmonics_queue) {
+        ESP_LOGE(TAG, "Failed to create harmonics queue");
+        return ESP_ERR_NO_MEM;
+    }
+    
+    // Create grid events queue
+    handle->events_queue = xQueueCreate(EVENTS_QUEUE_SIZE, sizeof(grid_event_record_t *));
+    if (!handle->events_queue) {
+        ESP_LOGE(TAG, "Failed to create events queue");
+        vQueueDelete(handle->harmonics_queue);
         return ESP_ERR_NO_MEM;
     }
-    g_log_queue = handle->log_queue;
     
-    // Create measurement queue
-    handle->measurement_queue = xQueueCreate(MEASUREMENT_QUEUE_SIZE, sizeof(measurement_t));
-    if (!handle->measurement_queue) {
-        ESP_LOGE(TAG, "Failed to create measurement queue");
-        vQueueDelete(handle->log_queue);
+    // Create synchrophasor queue
+    handle->synchrophasor_queue = xQueueCreate(SYNCHROPHASOR_QUEUE_SIZE, sizeof(synchrophasor_measurement_t));
+    if (!handle->synchrophasor_queue) {
+        ESP_LOGE(TAG, "Failed to create synchrophasor queue");
+        vQueueDelete(handle->harmonics_queue);
+        vQueueDelete(handle->events_queue);
         return ESP_ERR_NO_MEM;
     }
     
@@ -1059,17 +1967,23 @@ esp_err_t network_init(network_handle_t *handle, led_handle_t *led_handle, ade79
     esp_err_t ret = network_init_log_buffer(handle);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to initialize log buffer");
-        vQueueDelete(handle->log_queue);
-        vQueueDelete(handle->measurement_queue);
+        vQueueDelete(handle->harmonics_queue);
+        vQueueDelete(handle->events_queue);
+        vQueueDelete(handle->synchrophasor_queue);
         return ret;
     }
     
+    // Keep the lines from before the last reset; this boot's lines are captured once the hook is in,
+    // see network_start_wifi
+    crash_log_init();
+    
     // Get MAC address and initialize MQTT client ID and topics
     ret = network_get_formatted_mac_address(handle->mac_address, sizeof(handle->mac_address));
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to get MAC address");
-        vQueueDelete(handle->log_queue);
-        vQueueDelete(handle->measurement_queue);
+        vQueueDelete(handle->harmonics_queue);
+        vQueueDelete(handle->events_queue);
+        vQueueDelete(handle->synchrophasor_queue);
         network_deinit_log_buffer(handle);
         return ret;
     }
@@ -1079,8 +1993,36 @@ esp_err_t network_init(network_handle_t *handle, led_handle_t *led_handle, ade79
     
     // Initialize MQTT topics with MAC address as second element using defined topic suffixes
     snprintf(handle->mqtt_topic_logs, sizeof(handle->mqtt_topic_logs), "%s/%s/%s", MQTT_TOPIC_BASE, handle->mac_address, MQTT_TOPIC_LOGS);
+    for (int level = 0; level < LOG_FORWARD_LEVEL_COUNT; level++) {
+        snprintf(g_log_topics[level], MQTT_TOPIC_LEN, "%s/%s", handle->mqtt_topic_logs, g_log_level_names[level]);
+        snprintf(g_binlog_topics[level], MQTT_TOPIC_LEN, "%s/%s/%s", handle->mqtt_topic_logs, MQTT_TOPIC_LOGS_BINARY,
+                 g_log_level_names[level]);
+        handle->log_rate_limits[level].lines_per_second = LOG_RATE_DEFAULT_LINES_PER_S;
+        handle->log_rate_limits[level].burst = LOG_RATE_DEFAULT_BURST;
+    }
+    snprintf(g_crash_log_topic, MQTT_TOPIC_LEN, "%s/%s", handle->mqtt_topic_logs, MQTT_TOPIC_LOGS_CRASH);
+    snprintf(g_crash_binlog_topic, MQTT_TOPIC_LEN, "%s/%s/%s", handle->mqtt_topic_logs, MQTT_TOPIC_LOGS_CRASH,
+             MQTT_TOPIC_LOGS_BINARY);
     snprintf(handle->mqtt_topic_status, sizeof(handle->mqtt_topic_status), "%s/%s/%s", MQTT_TOPIC_BASE, handle->mac_address, MQTT_TOPIC_STATUS);
     snprintf(handle->mqtt_topic_measurement, sizeof(handle->mqtt_topic_measurement), "%s/%s/%s", MQTT_TOPIC_BASE, handle->mac_address, MQTT_TOPIC_MEASUREMENT);
+    snprintf(handle->mqtt_topic_measurement_frame, sizeof(handle->mqtt_topic_measurement_frame), "%s/%s/%s", MQTT_TOPIC_BASE, handle->mac_address, MQTT_TOPIC_MEASUREMENT_FRAME);
+    snprintf(handle->mqtt_topic_measurement_backfill, sizeof(handle->mqtt_topic_measurement_backfill), "%s/%s/%s", MQTT_TOPIC_BASE, handle->mac_address, MQTT_TOPIC_MEASUREMENT_BACKFILL);
+    snprintf(handle->mqtt_topic_harmonics, sizeof(handle->mqtt_topic_harmonics), "%s/%s/%s", MQTT_TOPIC_BASE, handle->mac_address, MQTT_TOPIC_HARMONICS);
+    snprintf(handle->mqtt_topic_events, sizeof(handle->mqtt_topic_events), "%s/%s/%s", MQTT_TOPIC_BASE, handle->mac_address, MQTT_TOPIC_EVENTS);
+    snprintf(handle->mqtt_topic_synchrophasor, sizeof(handle->mqtt_topic_synchrophasor), "%s/%s/%s", MQTT_TOPIC_BASE, handle->mac_address, MQTT_TOPIC_SYNCHROPHASOR);
+    snprintf(handle->mqtt_topic_synchrophasor_config, sizeof(handle->mqtt_topic_synchrophasor_config), "%s/%s/%s", MQTT_TOPIC_BASE, handle->mac_address, MQTT_TOPIC_SYNCHROPHASOR_CONFIG);
+    
+    // Raw stream on, no aggregation until tiers are set
+    handle->measurement_raw_enabled = true;
+    
+    // Adaptive batching starts at the low-latency end
+    handle->measurement_frame_span_s = MEASUREMENT_MIN_FRAME_SPAN_S;
+    handle->measurement_max_frame_span_s = MEASUREMENT_DEFAULT_MAX_FRAME_SPAN_S;
+    handle->mqtt_outbox_limit_bytes = MQTT_OUTBOX_DEFAULT_LIMIT_BYTES;
+    
+    // PMU identity for the C37.118 frames
+    handle->pmu_idcode = (uint16_t)strtoul(handle->mac_address + 8, NULL, 16);
+    snprintf(handle->pmu_station_name, sizeof(handle->pmu_station_name), "OGM-%s", handle->mac_address);
     snprintf(handle->mqtt_topic_system, sizeof(handle->mqtt_topic_system), "%s/%s/%s", MQTT_TOPIC_BASE, handle->mac_address, MQTT_TOPIC_SYSTEM);
     snprintf(handle->mqtt_topic_commands_restart, sizeof(handle->mqtt_topic_commands_restart), "%s/%s/%s/%s", MQTT_TOPIC_BASE, handle->mac_address, MQTT_TOPIC_COMMANDS, MQTT_TOPIC_COMMAND_RESTART);
     snprintf(handle->mqtt_topic_commands_ota, sizeof(handle->mqtt_topic_commands_ota), "%s/%s/%s/%s", MQTT_TOPIC_BASE, handle->mac_address, MQTT_TOPIC_COMMANDS, MQTT_TOPIC_COMMAND_OTA);
@@ -1101,9 +2043,6 @@ esp_err_t network_init(network_handle_t *handle, led_handle_t *led_handle, ade79
                  handle->mqtt_credentials.use_auth ? "enabled" : "disabled");
     }
     
-    // Don't setup log forwarding here to prevent stack overflow during WiFi init
-    // Log forwarding will be set up when MQTT logging starts
-    
     // Initialize TCP/IP stack
     ESP_ERROR_CHECK(esp_netif_init());
     ESP_ERROR_CHECK(esp_event_loop_create_default());
@@ -1117,8 +2056,6 @@ esp_err_t network_init(network_handle_t *handle, led_handle_t *led_handle, ade79
     handle->wifi_event_group = xEventGroupCreate();
     if (!handle->wifi_event_group) {
         ESP_LOGE(TAG, "Failed to create WiFi event group");
-        vQueueDelete(handle->log_queue);
-        vQueueDelete(handle->measurement_queue);
         return ESP_ERR_NO_MEM;
     }
     
@@ -1139,6 +2076,7 @@ esp_err_t network_deinit(network_handle_t *handle) {
     }
     
     network_stop_log_forwarding(handle);
+    log_hook_remove();
     network_stop_measurement_publishing(handle);
     network_stop_mqtt_logging(handle);
     network_stop_web_server(handle);
@@ -1164,32 +2102,36 @@ esp_err_t network_deinit(network_handle_t *handle) {
         vEventGroupDelete(handle->wifi_event_group);
     }
     
-    if (handle->log_queue) {
-        // Clean up any remaining messages
-        log_message_t log_msg;
-        while (xQueueReceive(handle->log_queue, &log_msg, 0) == pdTRUE) {
-            if (log_msg.msg != NULL) {
-                free(log_msg.msg);
-            }
-            if (log_msg.topic != NULL) {
-                free(log_msg.topic);
-            }
-        }
-        vQueueDelete(handle->log_queue);
-        handle->log_queue = NULL;
-        g_log_queue = NULL;
+    handle->log_ring = NULL;
+    handle->measurement_ring = NULL;
+    
+    if (handle->harmonics_queue) {
+        vQueueDelete(handle->harmonics_queue);
+        handle->harmonics_queue = NULL;
     }
     
-    if (handle->measurement_queue) {
-        // Clean up any remaining measurements
-        measurement_t measurement;
-        while (xQueueReceive(handle->measurement_queue, &measurement, 0) == pdTRUE) {
-            // Just drain the queue
+    if (handle->events_queue) {
+        grid_event_record_t *event;
+        while (xQueueReceive(handle->events_queue, &event, 0) == pdTRUE) {
+            grid_events_release(event);
         }
-        vQueueDelete(handle->measurement_queue);
-        handle->measurement_queue = NULL;
+        vQueueDelete(handle->events_queue);
+        handle->events_queue = NULL;
     }
     
+    if (handle->synchrophasor_queue) {
+        vQueueDelete(handle->synchrophasor_queue);
+        handle->synchrophasor_queue = NULL;
+    }
+    
+    free(handle->measurement_frame);
+    handle->measurement_frame = NULL;
+    free(handle->aggregation);
+    handle->aggregation = NULL;
+    storage_log_deinit(handle->measurement_spool);
+    free(handle->measurement_spool);
+    handle->measurement_spool = NULL;
+    
     // Cleanup log buffer
     network_deinit_log_buffer(handle);
     
@@ -1229,6 +2171,11 @@ esp_err_t network_start_wifi(network_handle_t *handle) {
                                           pdFALSE,
                                           portMAX_DELAY);
     
+    // Only now capture lines for the boot buffer and the crash log, forwarding follows once MQTT
+    // logging starts. The hook's line slot sits on the logging task's stack, and during WiFi init
+    // and the first connect that is the small sys_evt, wifi and esp_timer stacks, which overflowed.
+    log_hook_install();
+    
     if (bits & WIFI_CONNECTED_BIT) {
         ESP_LOGI(TAG, "Connected to WiFi SSID: %s", WIFI_SSID);
         return ESP_OK;
@@ -1330,6 +2277,20 @@ esp_err_t network_start_web_server(network_handle_t *handle) {
         .user_ctx = NULL
     };
     
+    httpd_uri_t register_get_uri = {
+        .uri = "/api/register",
+        .method = HTTP_GET,
+        .handler = web_api_register_handler,
+        .user_ctx = NULL
+    };
+    
+    httpd_uri_t register_post_uri = {
+        .uri = "/api/register",
+        .method = HTTP_POST,
+        .handler = web_api_register_handler,
+        .user_ctx = NULL
+    };
+    
     httpd_uri_t ota_uri = {
         .uri = "/api/update",
         .method = HTTP_POST,
@@ -1345,6 +2306,8 @@ esp_err_t network_start_web_server(network_handle_t *handle) {
         httpd_register_uri_handler(g_web_server, &config_get_uri);
         httpd_register_uri_handler(g_web_server, &config_post_uri);
         httpd_register_uri_handler(g_web_server, &restart_uri);
+        httpd_register_uri_handler(g_web_server, &register_get_uri);
+        httpd_register_uri_handler(g_web_server, &register_post_uri);
         httpd_register_uri_handler(g_web_server, &ota_uri);
         
         handle->web_server_enabled = true;
@@ -1561,13 +2524,15 @@ bool network_is_mqtt_connected(void) {
 // UDP log function
 // Setup log forwarding
 esp_err_t network_setup_log_forwarding(network_handle_t *handle) {
-    if (!handle || !handle->log_queue) {
+    if (!handle || !handle->log_ring) {
         return ESP_ERR_INVALID_STATE;
     }
     
-    // Save original log function
-    g_original_log_function = esp_log_set_vprintf(custom_log_writer);
+    log_hook_install();
     g_log_forwarding_initialized = true;
+    if (handle->log_binary) {
+        binlog_set_sink(binlog_forward);
+    }
     
     ESP_LOGI(TAG, "Log forwarding enabled - all logs will be sent via MQTT");
     return ESP_OK;
@@ -1579,13 +2544,9 @@ esp_err_t network_stop_log_forwarding(network_handle_t *handle) {
         return ESP_ERR_INVALID_ARG;
     }
     
+    // The hook stays for the log buffer and the crash log until network_deinit
     g_log_forwarding_initialized = false;
-    
-    // Restore original log function
-    if (g_original_log_function) {
-        esp_log_set_vprintf(g_original_log_function);
-        g_original_log_function = NULL;
-    }
+    binlog_set_sink(NULL);
     
     ESP_LOGI(TAG, "Log forwarding disabled");
     return ESP_OK;
@@ -2103,6 +3064,55 @@ esp_err_t network_start_measurement_publishing(network_handle_t *handle) {
         return ESP_ERR_INVALID_STATE;
     }
     
+    // Binary batching needs a frame buffer, fall back to JSON per sample without one
+    if (handle->measurement_batching && !handle->measurement_frame) {
+        uint8_t device_id[MEASUREMENT_FRAME_DEVICE_ID_LEN];
+        for (int i = 0; i < MEASUREMENT_FRAME_DEVICE_ID_LEN; i++) {
+            char byte[3] = { handle->mac_address[2 * i], handle->mac_address[2 * i + 1], '\0' };
+            device_id[i] = (uint8_t)strtoul(byte, NULL, 16);
+        }
+        
+        handle->measurement_frame = calloc(1, sizeof(measurement_frame_t));
+        if (!handle->measurement_frame ||
+            measurement_frame_init(handle->measurement_frame, device_id, MEASUREMENT_FRAME_MAX_SAMPLES,
+                                   handle->measurement_frame_span_s) != MEASUREMENT_FRAME_OK) {
+            ESP_LOGW(TAG, "Measurement batching unavailable, publishing JSON per sample");
+            free(handle->measurement_frame);
+            handle->measurement_frame = NULL;
+        }
+    } else if (!handle->measurement_batching && handle->measurement_frame) {
+        free(handle->measurement_frame);
+        handle->measurement_frame = NULL;
+    }
+    
+    // Store-and-forward keeps whole frames, so it only runs with batching
+    if (handle->measurement_frame && !handle->measurement_spool) {
+        handle->measurement_spool = calloc(1, sizeof(storage_log_t));
+        if (!handle->measurement_spool || storage_log_init(handle->measurement_spool) != STORAGE_OK) {
+            ESP_LOGW(TAG, "Store-and-forward unavailable, frames are dropped while offline");
+            free(handle->measurement_spool);
+            handle->measurement_spool = NULL;
+        }
+    }
+    
+    // Aggregation restarts with empty windows, on one topic per tier
+    free(handle->aggregation);
+    handle->aggregation = NULL;
+    if (handle->aggregation_tier_count > 0) {
+        handle->aggregation = malloc(sizeof(aggregation_t));
+        if (!handle->aggregation ||
+            aggregation_init(handle->aggregation, handle->aggregation_tiers, handle->aggregation_tier_count,
+                             handle->aggregation_nominal_frequency) != AGGREGATION_OK) {
+            ESP_LOGW(TAG, "Aggregation unavailable");
+            free(handle->aggregation);
+            handle->aggregation = NULL;
+        }
+        for (size_t i = 0; handle->aggregation && i < handle->aggregation_tier_count; i++) {
+            snprintf(g_aggregate_topics[i], MQTT_TOPIC_LEN, "%s/%s/%s/%lus", MQTT_TOPIC_BASE, handle->mac_address,
+                     MQTT_TOPIC_AGGREGATE, handle->aggregation_tiers[i].window_s);
+        }
+    }
+    
     handle->measurement_publishing_enabled = true;
     
     BaseType_t task_ret = xTaskCreate(measurement_publishing_task, MEASUREMENT_TASK_NAME, 
@@ -2156,32 +3166,149 @@ esp_err_t network_stop_measurement_publishing(network_handle_t *handle) {
     return ESP_OK;
 }
 
-// Queue a measurement for MQTT publishing
-esp_err_t network_queue_measurement(network_handle_t *handle, const measurement_t *measurement) {
-    if (!handle || !measurement) {
+// Select binary measurement frames or JSON per sample, takes effect when publishing (re)starts
+esp_err_t network_set_measurement_batching(network_handle_t *handle, bool enabled) {
+    if (!handle) {
         return ESP_ERR_INVALID_ARG;
     }
     
-    if (!handle->measurement_publishing_enabled || !handle->measurement_queue) {
-        return ESP_ERR_INVALID_STATE;
+    if (g_measurement_task) {
+        ESP_LOGW(TAG, "Measurement batching change applies after publishing restarts");
+    }
+    handle->measurement_batching = enabled;
+    return ESP_OK;
+}
+
+// Turn the raw stream (frames or JSON per sample) on or off, aggregates are published either way
+esp_err_t network_set_raw_measurement_publishing(network_handle_t *handle, bool enabled) {
+    if (!handle) {
+        return ESP_ERR_INVALID_ARG;
     }
     
-    // Try to send measurement to queue (non-blocking)
-    if (xQueueSend(handle->measurement_queue, measurement, 0) != pdTRUE) {
-        // Queue is full, measurement dropped
-        ESP_LOGD(TAG, "Measurement queue full, dropping measurement");
-        return ESP_ERR_NO_MEM;
+    handle->measurement_raw_enabled = enabled;
+    return ESP_OK;
+}
+
+// Hold forwarded lines for up to LOG_BATCH_MAX_AGE_MS and publish them per level in one message
+esp_err_t network_set_log_batching(network_handle_t *handle, bool enabled) {
+    if (!handle) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    handle->log_batching = enabled;
+    return ESP_OK;
+}
+
+// Lines per second and burst forwarded per tag at a level, lines_per_second 0 lifts the limit; takes effect at once
+esp_err_t network_set_log_rate_limit(network_handle_t *handle, log_forward_level_t level, uint16_t lines_per_second, uint16_t burst) {
+    if (!handle || level >= LOG_FORWARD_LEVEL_COUNT || (lines_per_second > 0 && burst == 0)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    // Both halves together, the log writer reads them on other tasks
+    taskENTER_CRITICAL(&g_log_rate_lock);
+    handle->log_rate_limits[level].lines_per_second = lines_per_second;
+    handle->log_rate_limits[level].burst = burst;
+    taskEXIT_CRITICAL(&g_log_rate_lock);
+    return ESP_OK;
+}
+
+// Forward BINLOG_x sites as binary records instead of text, takes effect at once if forwarding runs
+esp_err_t network_set_binary_logging(network_handle_t *handle, bool enabled) {
+    if (!handle) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    handle->log_binary = enabled;
+    if (g_log_forwarding_initialized) {
+        binlog_set_sink(enabled ? binlog_forward : NULL);
+    }
+    return ESP_OK;
+}
+
+// Set the aggregation tiers and the grid's nominal frequency, tier_count 0 turns aggregation off
+esp_err_t network_set_aggregation_tiers(network_handle_t *handle, const aggregation_tier_config_t *tiers, size_t tier_count,
+                                        float nominal_frequency) {
+    if (!handle || !aggregation_tiers_valid(tiers, tier_count) || nominal_frequency <= 0.0f) {
+        return ESP_ERR_INVALID_ARG;
     }
     
+    if (g_measurement_task) {
+        ESP_LOGW(TAG, "Aggregation change applies after publishing restarts");
+    }
+    if (tier_count > 0) {
+        memcpy(handle->aggregation_tiers, tiers, tier_count * sizeof(aggregation_tier_config_t));
+    }
+    handle->aggregation_tier_count = tier_count;
+    handle->aggregation_nominal_frequency = nominal_frequency;
     return ESP_OK;
 }
 
-// Get measurement queue handle
-QueueHandle_t network_get_measurement_queue(network_handle_t *handle) {
+// Loss counters by cause, gathered from the acquisition task, the ring and the publisher
+void network_get_measurement_loss_stats(network_handle_t *handle, measurement_loss_stats_t *stats) {
+    if (!handle || !stats) {
+        return;
+    }
+    
+    memset(stats, 0, sizeof(measurement_loss_stats_t));
+    if (handle->ade7953_handle) {
+        stats->sequence = handle->ade7953_handle->sample_sequence;
+        stats->plausibility_reject = handle->ade7953_handle->plausibility_reject_count;
+    }
+    if (handle->measurement_ring) {
+        spsc_ring_stats_t ring_stats;
+        spsc_ring_get_stats(handle->measurement_ring, &ring_stats);
+        stats->queue_full = ring_stats.drop_count;
+    }
+    stats->not_connected = handle->measurement_lost_not_connected;
+    stats->publish_error = handle->measurement_lost_publish_error;
+}
+
+// Set how far adaptive batching may go: the longest frame (latency) and the most outbox bytes (memory)
+esp_err_t network_set_measurement_batching_bounds(network_handle_t *handle, uint32_t max_frame_span_s, uint32_t outbox_limit_bytes) {
+    if (!handle || max_frame_span_s < MEASUREMENT_MIN_FRAME_SPAN_S || max_frame_span_s > MEASUREMENT_FRAME_MAX_SPAN_S ||
+        outbox_limit_bytes <= MQTT_OUTBOX_HIGH_WATER_BYTES) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    handle->measurement_max_frame_span_s = max_frame_span_s;
+    handle->mqtt_outbox_limit_bytes = outbox_limit_bytes;
+    if (handle->measurement_frame_span_s > max_frame_span_s) {
+        handle->measurement_frame_span_s = max_frame_span_s;
+    }
+    return ESP_OK;
+}
+
+// Get measurement ring
+spsc_ring_t *network_get_measurement_ring(network_handle_t *handle) {
     if (!handle) {
         return NULL;
     }
-    return handle->measurement_queue;
+    return handle->measurement_ring;
+}
+
+// Get harmonics queue handle
+QueueHandle_t network_get_harmonics_queue(network_handle_t *handle) {
+    if (!handle) {
+        return NULL;
+    }
+    return handle->harmonics_queue;
+}
+
+// Get grid events queue handle
+QueueHandle_t network_get_events_queue(network_handle_t *handle) {
+    if (!handle) {
+        return NULL;
+    }
+    return handle->events_queue;
+}
+
+// Get synchrophasor queue handle
+QueueHandle_t network_get_synchrophasor_queue(network_handle_t *handle) {
+    if (!handle) {
+        return NULL;
+    }
+    return handle->synchrophasor_queue;
 }
 
 // Initialize log buffer for capturing logs before MQTT connection
@@ -2202,8 +3329,8 @@ esp_err_t network_init_log_buffer(network_handle_t *handle) {
 }
 
 // Add a log message to the buffer (called by custom log writer)
-static void add_to_log_buffer(network_handle_t *handle, const char *message, const char *topic) {
-    if (!handle || !handle->log_buffer || !message || !topic) {
+static void add_to_log_buffer(network_handle_t *handle, const char *message, log_forward_level_t level) {
+    if (!handle || !handle->log_buffer || !message) {
         return;
     }
     
@@ -2213,9 +3340,8 @@ static void add_to_log_buffer(network_handle_t *handle, const char *message, con
     strncpy(buffer->messages[buffer->write_index], message, LOG_BUFFER_MSG_SIZE - 1);
     buffer->messages[buffer->write_index][LOG_BUFFER_MSG_SIZE - 1] = '\0';
     
-    // Store the topic
-    strncpy(buffer->topics[buffer->write_index], topic, sizeof(buffer->topics[0]) - 1);
-    buffer->topics[buffer->write_index][sizeof(buffer->topics[0]) - 1] = '\0';
+    // Store the level, the topic is picked when flushing
+    buffer->levels[buffer->write_index] = level;
     
     // Store timestamp
     gettimeofday(&buffer->timestamps[buffer->write_index], NULL);
@@ -2230,6 +3356,47 @@ static void add_to_log_buffer(network_handle_t *handle, const char *message, con
     }
 }
 
+// Publish the lines logged before the last reset to .../logs/crash, once, as arrays like the forwarded
+// lines with the reset reason on each. BINLOG_x records go to .../logs/crash/binary as they were kept,
+// under the payload header of the build that wrote them.
+esp_err_t network_publish_crash_log(network_handle_t *handle) {
+    if (!handle || !g_mqtt_client) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!crash_log_has_previous()) {
+        return ESP_OK;
+    }
+    
+    const char *reset_reason = reset_reason_to_string(esp_reset_reason());
+    crash_log_cursor_t cursor;
+    crash_log_record_type_t type;
+    int64_t timestamp_us;
+    uint8_t data[CRASH_LOG_LINE_MAX_SIZE + 1];
+    size_t length;
+    uint8_t elf_sha256[CRASH_LOG_ELF_SHA256_SIZE];
+    uint32_t lines = 0;
+    
+    crash_log_previous_elf_sha256(elf_sha256);
+    crash_log_cursor_init(&cursor);
+    log_batch_open(&g_log_flush_batch);
+    g_crash_binlog_batch.length = 0;
+    while (crash_log_next(&cursor, &timestamp_us, &type, data, sizeof(data), &length)) {
+        if (type == CRASH_LOG_RECORD_BINLOG) {
+            log_binary_batch_add(&g_crash_binlog_batch, g_crash_binlog_topic, QOS_1, elf_sha256, data, length);
+        } else {
+            log_batch_add(&g_log_flush_batch, g_crash_log_topic, QOS_1, timestamp_us, (const char *)data, false,
+                          reset_reason);
+        }
+        lines++;
+    }
+    log_batch_publish(&g_log_flush_batch, g_crash_log_topic, QOS_1);
+    log_binary_batch_publish(&g_crash_binlog_batch, g_crash_binlog_topic, QOS_1);
+    crash_log_release_previous();
+    
+    ESP_LOGI(TAG, "Published %lu log lines from before the reset (%s)", lines, reset_reason);
+    return ESP_OK;
+}
+
 // Flush all buffered logs to MQTT
 esp_err_t network_flush_log_buffer(network_handle_t *handle) {
     if (!handle || !handle->log_buffer || !g_mqtt_client) {
@@ -2247,27 +3414,19 @@ esp_err_t network_flush_log_buffer(network_handle_t *handle) {
     int start_index = buffer->overflow ? buffer->write_index : 0;
     int messages_to_send = buffer->overflow ? LOG_BUFFER_SIZE : buffer->count;
     
-    for (int i = 0; i < messages_to_send; i++) {
-        int index = (start_index + i) % LOG_BUFFER_SIZE;
-        
-        // Create a JSON message with timestamp
-        cJSON *json = cJSON_CreateObject();
-        if (json) {
-            cJSON_AddStringToObject(json, "message", buffer->messages[index]);
-            cJSON_AddNumberToObject(json, "timestamp", 
-                buffer->timestamps[index].tv_sec * 1000LL + buffer->timestamps[index].tv_usec / 1000);
-            cJSON_AddStringToObject(json, "source", "buffered");
-            
-            char *json_string = cJSON_Print(json);
-            if (json_string) {
-                safe_publish_mqtt(buffer->topics[index], json_string, QOS_1, 0);
-                free(json_string);
+    // One batch per level, in the same format as forwarded lines
+    for (int level = 0; level < LOG_FORWARD_LEVEL_COUNT; level++) {
+        log_batch_open(&g_log_flush_batch);
+        for (int i = 0; i < messages_to_send; i++) {
+            int index = (start_index + i) % LOG_BUFFER_SIZE;
+            if (buffer->levels[index] != level) {
+                continue;
             }
-            cJSON_Delete(json);
+            log_batch_add(&g_log_flush_batch, g_log_topics[level], QOS_1,
+                          buffer->timestamps[index].tv_sec * 1000000LL + buffer->timestamps[index].tv_usec,
+                          log_line_trim(buffer->messages[index]), true, NULL);
         }
-        
-        // Small delay to avoid overwhelming MQTT broker
-        vTaskDelay(pdMS_TO_TICKS(10));
+        log_batch_publish(&g_log_flush_batch, g_log_topics[level], QOS_1);
     }
     
     // Clear the buffer
@@ -2336,22 +3495,7 @@ esp_err_t network_publish_firmware_info(network_handle_t *handle) {
     }
     
     // Add reset reason
-    esp_reset_reason_t reset_reason = esp_reset_reason();
-    const char* reset_reason_str = "unknown";
-    switch (reset_reason) {
-        case ESP_RST_POWERON: reset_reason_str = "power_on"; break;
-        case ESP_RST_EXT: reset_reason_str = "external_reset"; break;
-        case ESP_RST_SW: reset_reason_str = "software_reset"; break;
-        case ESP_RST_PANIC: reset_reason_str = "panic"; break;
-        case ESP_RST_INT_WDT: reset_reason_str = "interrupt_watchdog"; break;
-        case ESP_RST_TASK_WDT: reset_reason_str = "task_watchdog"; break;
-        case ESP_RST_WDT: reset_reason_str = "other_watchdog"; break;
-        case ESP_RST_DEEPSLEEP: reset_reason_str = "deep_sleep"; break;
-        case ESP_RST_BROWNOUT: reset_reason_str = "brownout"; break;
-        case ESP_RST_SDIO: reset_reason_str = "sdio"; break;
-        default: break;
-    }
-    cJSON_AddStringToObject(json, "reset_reason", reset_reason_str);
+    cJSON_AddStringToObject(json, "reset_reason", reset_reason_to_string(esp_reset_reason()));
     
     // Add uptime
     int64_t uptime_ms = esp_timer_get_time() / 1000;
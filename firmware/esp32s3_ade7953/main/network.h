@@ -33,6 +33,12 @@
 #include <time.h>
 
 #include "ade7953.h"
+#include "measurement_frame.h"
+#include "aggregation.h"
+#include "json_writer.h"
+#include "binlog.h"
+#include "crash_log.h"
+#include "storage.h"
 #include "led.h"
 #include "secrets.h"
 
@@ -48,6 +54,7 @@
 #define WEB_SERVER_PORT         80
 #define WEB_SERVER_MAX_URI      10
 #define WEB_SERVER_STACK_SIZE   (8 * 1024)
+#define WEB_STATUS_JSON_SIZE    1024    // /api/status document, on the server task's stack
 
 // Graceful shutdown configuration
 #define GRACEFUL_SHUTDOWN_TIMEOUT_MS  10000  // Maximum time to wait for graceful shutdown
@@ -64,16 +71,41 @@
 #define MQTT_TASK_NAME          "mqtt_task"
 #define MQTT_TASK_STACK_SIZE    (32 * 1024)  // Increased for log processing
 #define MQTT_TASK_PRIORITY      3
-#define MQTT_QUEUE_SIZE         100
-#define MQTT_MSG_MAX_SIZE       256
+
+// Log forwarding: ESP_LOGx lines are copied into a static ring of fixed-size slots, never the heap
+#define LOG_RING_SIZE           32      // Power of two, slots of LOG_MSG_MAX_SIZE bytes
+#define LOG_MSG_MAX_SIZE        192     // Longer lines are truncated
+#define LOG_RING_POLL_MS        50      // Logging task sleep between drains of the ring
+
+// Log batching: lines of one level go out together as a JSON array, binary records behind one header
+#define LOG_BATCH_SIZE          1536    // A full slot fits an empty batch even if every byte needs escaping
+#define LOG_BINARY_BATCH_SIZE   512
+#define LOG_BATCH_MAX_AGE_MS    1000    // Oldest line waits at most this long, ERROR goes out at once
+
+// Log rate limiting per tag and level, on the MQTT path only: the console still gets every line
+#define LOG_RATE_BUCKETS                16      // Tag and level pairs tracked, later pairs share one bucket per level
+#define LOG_RATE_TAG_SIZE               16      // Longer tags are told apart by their first 15 characters
+#define LOG_RATE_DEFAULT_LINES_PER_S    10
+#define LOG_RATE_DEFAULT_BURST          20
+#define LOG_RATE_SUMMARY_INTERVAL_MS    10000   // How often "N messages suppressed" lines go out
 
 // MQTT Topics
 #define MQTT_TOPIC_LEN          64
 #define MQTT_TOPIC_BASE         "open_grid_monitor"
 #define MQTT_TOPIC_LOGS         "logs"
+#define MQTT_TOPIC_LOGS_BINARY  "binary"    // .../logs/binary/{level}, BINLOG_x records
+#define MQTT_TOPIC_LOGS_CRASH   "crash"     // .../logs/crash, the lines before the last reset
+                                            // .../logs/crash/binary, the BINLOG_x records among them
 #define MQTT_TOPIC_STATUS       "status" 
 #define MQTT_TOPIC_SYSTEM       "system"
 #define MQTT_TOPIC_MEASUREMENT  "measurement"
+#define MQTT_TOPIC_MEASUREMENT_FRAME "measurement/frame"
+#define MQTT_TOPIC_MEASUREMENT_BACKFILL "measurement/backfill"
+#define MQTT_TOPIC_AGGREGATE    "aggregate"     // Followed by the window, e.g. "aggregate/10s"
+#define MQTT_TOPIC_HARMONICS    "harmonics"
+#define MQTT_TOPIC_EVENTS       "events"
+#define MQTT_TOPIC_SYNCHROPHASOR "synchrophasor"
+#define MQTT_TOPIC_SYNCHROPHASOR_CONFIG "synchrophasor/config"
 #define MQTT_TOPIC_DEBUG        "debug"
 #define MQTT_TOPIC_COMMANDS     "commands"
 #define MQTT_TOPIC_RESPONSES    "responses"
@@ -111,20 +143,49 @@
 #define DEFERRED_SHUTDOWN_TASK_PRIORITY   2
 
 // Measurement queue configuration
-#define MEASUREMENT_QUEUE_SIZE  100
+#define MEASUREMENT_RING_SIZE   128     // Power of two, over two seconds of per-cycle samples
+#define MEASUREMENT_RING_BULK_SIZE 16   // Measurements taken out of the ring per publishing loop
+#define MEASUREMENT_RING_POLL_MS 20     // Publisher sleep while the ring is empty
+#define MEASUREMENT_JSON_SIZE   1024    // Largest JSON message of the publishing task (a harmonics record)
+#define HARMONICS_QUEUE_SIZE    5
+#define EVENTS_QUEUE_SIZE       1       // The detector owns a single frozen record
+#define EVENT_CHUNK_SAMPLES     40      // Per-cycle points per events message, a full capture takes up to 16
+#define EVENT_JSON_CHUNK_SIZE   2048    // Largest events message: the summary and EVENT_CHUNK_SAMPLES points
+#define SYNCHROPHASOR_QUEUE_SIZE SYNCHROPHASOR_MAX_RATE   // One second of reports at the highest rate
 #define MEASUREMENT_TASK_NAME   "measurement_pub_task"
 #define MEASUREMENT_TASK_STACK_SIZE (8 * 1024)
 #define MEASUREMENT_TASK_PRIORITY   7
+#define MEASUREMENT_BACKFILL_INTERVAL_US 100000 // One spooled frame per 100 ms, a backlog drains at ten times real time
+
+// Adaptive batching: frames grow from MIN to the max span while the link is congested and shrink back when healthy
+#define MEASUREMENT_BACKPRESSURE_INTERVAL_US 1000000   // How often the outbox and RSSI are checked
+#define MEASUREMENT_MIN_FRAME_SPAN_S        1           // Latency when the link is healthy
+#define MEASUREMENT_DEFAULT_MAX_FRAME_SPAN_S MEASUREMENT_FRAME_MAX_SPAN_S   // Latency bound, the frame buffer caps it
+#define MQTT_OUTBOX_LOW_WATER_BYTES         2048        // Healthy below this
+#define MQTT_OUTBOX_HIGH_WATER_BYTES        8192        // Congested above this
+#define MQTT_OUTBOX_DEFAULT_LIMIT_BYTES     32768       // Memory bound: frames go to flash instead of the outbox above this
+#define WIFI_RSSI_WEAK_DBM                  -80         // Congested below this
+#define WIFI_RSSI_HYSTERESIS_DB             5
 
 // SNTP configuration
 #define SNTP_SERVER             "pool.ntp.org"
 #define SNTP_SYNC_INTERVAL_MS   3600000  // 1 hour
 
-// Log message structure for MQTT forwarding
+// Forwarded log levels, each with its own topic under .../logs/
+typedef enum {
+    LOG_FORWARD_ERROR = 0,
+    LOG_FORWARD_WARNING,
+    LOG_FORWARD_INFO,                   // Also lines without a level prefix
+    LOG_FORWARD_DEBUG,                  // Debug and verbose
+    LOG_FORWARD_LEVEL_COUNT
+} log_forward_level_t;
+
+// Log line slot for MQTT forwarding
 typedef struct {
-    char *msg;
-    char *topic;
     struct timeval timestamp;
+    uint8_t level;                      // log_forward_level_t
+    uint8_t length;                     // Bytes of a binary record in msg, 0 for a text line
+    char msg[LOG_MSG_MAX_SIZE];
 } log_message_t;
 
 // WiFi status
@@ -135,16 +196,54 @@ typedef enum {
     WIFI_STATUS_FAILED
 } wifi_status_t;
 
+// State of the path to the broker, as seen by the measurement publisher
+typedef enum {
+    MEASUREMENT_LINK_HEALTHY = 0,       // Outbox nearly empty and a usable signal: shortest frames
+    MEASUREMENT_LINK_CONGESTED,         // Outbox filling or weak signal: longer frames, no backfill
+    MEASUREMENT_LINK_EXHAUSTED          // Outbox at its memory bound: frames spill to flash
+} measurement_link_state_t;
+
 // Log buffer structure
 typedef struct {
     char messages[LOG_BUFFER_SIZE][LOG_BUFFER_MSG_SIZE];
-    char topics[LOG_BUFFER_SIZE][64];
+    uint8_t levels[LOG_BUFFER_SIZE];    // log_forward_level_t
     struct timeval timestamps[LOG_BUFFER_SIZE];
     int write_index;
     int count;
     bool overflow;
 } log_buffer_t;
 
+// Token bucket of one level, lines_per_second 0 forwards everything
+typedef struct {
+    uint16_t lines_per_second;
+    uint16_t burst;
+} log_rate_limit_t;
+
+// One tag and level pair. The bucket is kept as the time it is next full (GCRA): a line passes
+// if that is at most burst - 1 intervals ahead, and moves it one interval on.
+typedef struct {
+    char tag[LOG_RATE_TAG_SIZE];
+    uint8_t level;                      // log_forward_level_t
+    bool used;
+    int64_t next_us;
+    uint32_t suppressed;                // Since the last summary
+} log_rate_bucket_t;
+
+// Lines of one level waiting to be published: [{"timestamp":us,"message":"..."},...]
+typedef struct {
+    json_writer_t writer;
+    char json[LOG_BATCH_SIZE];
+    uint16_t lines;
+    int64_t opened_us;
+} log_text_batch_t;
+
+// Binary records of one level waiting to be published, behind the binlog payload header
+typedef struct {
+    uint8_t payload[LOG_BINARY_BATCH_SIZE];
+    size_t length;                      // 0 when empty
+    int64_t opened_us;
+} log_binary_batch_t;
+
 // MQTT credentials structure
 typedef struct {
     char broker_uri[128];
@@ -170,20 +269,65 @@ typedef struct {
     char mqtt_topic_logs[MQTT_TOPIC_LEN];
     char mqtt_topic_status[MQTT_TOPIC_LEN];
     char mqtt_topic_measurement[MQTT_TOPIC_LEN];
+    char mqtt_topic_measurement_frame[MQTT_TOPIC_LEN];
+    char mqtt_topic_measurement_backfill[MQTT_TOPIC_LEN];
+    char mqtt_topic_harmonics[MQTT_TOPIC_LEN];
+    char mqtt_topic_events[MQTT_TOPIC_LEN];
+    char mqtt_topic_synchrophasor[MQTT_TOPIC_LEN];
+    char mqtt_topic_synchrophasor_config[MQTT_TOPIC_LEN];
     char mqtt_topic_system[MQTT_TOPIC_LEN];
     char mqtt_topic_commands_restart[MQTT_TOPIC_LEN];
     char mqtt_topic_commands_ota[MQTT_TOPIC_LEN];
     char mqtt_topic_responses_restart[MQTT_TOPIC_LEN];
     char mqtt_topic_responses_ota[MQTT_TOPIC_LEN];
     char mqtt_topic_firmware[MQTT_TOPIC_LEN];
-    QueueHandle_t log_queue;
-    QueueHandle_t measurement_queue;
+    mpsc_ring_t *log_ring;              // Statically allocated in network.c, one producer per logging task
+    bool log_binary;                   // BINLOG_x sites forwarded as binary records while forwarding runs
+    bool log_batching;                 // Coalesce lines per level for up to LOG_BATCH_MAX_AGE_MS
+    log_rate_limit_t log_rate_limits[LOG_FORWARD_LEVEL_COUNT];
+    spsc_ring_t *measurement_ring;      // Statically allocated in network.c
+    QueueHandle_t harmonics_queue;
+    QueueHandle_t events_queue;
+    QueueHandle_t synchrophasor_queue;
+    bool measurement_batching;         // Binary frames of 1 to 4 UTC seconds instead of one JSON message per sample
+    measurement_frame_t *measurement_frame;
+    int64_t measurement_frame_opened_us;
+    storage_log_t *measurement_spool;  // Frames that could not be sent, replayed on reconnect (batching only)
+    int64_t measurement_backfill_last_us;
+    uint32_t measurement_lost_not_connected;   // Samples, see measurement_loss_stats_t
+    uint32_t measurement_lost_publish_error;
+    bool measurement_raw_enabled;      // Off leaves only the aggregates
+    aggregation_tier_config_t aggregation_tiers[AGGREGATION_MAX_TIERS];
+    size_t aggregation_tier_count;     // 0 disables aggregation
+    float aggregation_nominal_frequency;   // Hz, reference of the frequency deviation quantiles
+    aggregation_t *aggregation;
+    
+    // Backpressure from the esp-mqtt outbox and the WiFi link
+    measurement_link_state_t measurement_link_state;
+    uint32_t measurement_frame_span_s;
+    uint32_t measurement_max_frame_span_s;
+    uint32_t mqtt_outbox_limit_bytes;
+    int mqtt_outbox_bytes;             // At the last check
+    int8_t wifi_rssi;
+    int64_t measurement_backpressure_checked_us;
+    uint16_t pmu_idcode;               // C37.118 IDCODE, from the last two MAC bytes
+    char pmu_station_name[C37118_STATION_NAME_LEN + 1];
     log_buffer_t *log_buffer;
     led_handle_t *led_handle;
     ade7953_handle_t *ade7953_handle;
     mqtt_credentials_t mqtt_credentials;
 } network_handle_t;
 
+// Samples lost between acquisition and the broker, by cause. Anything lost after the broker
+// accepted it (QoS 0 frames) only shows up as a gap in the sample sequence at the receiver.
+typedef struct {
+    uint32_t sequence;                 // Next sample sequence number, the samples acquired since boot
+    uint32_t queue_full;               // Measurement ring full, the publisher fell behind
+    uint32_t plausibility_reject;      // Invalid or out-of-range readings
+    uint32_t not_connected;            // Offline, and not spooled
+    uint32_t publish_error;            // Refused by the MQTT client or outbox full, and not spooled
+} measurement_loss_stats_t;
+
 typedef enum {
     MQTT_COMMAND_RESTART,
     MQTT_COMMAND_OTA
@@ -215,10 +359,21 @@ esp_err_t network_stop_mqtt_commands(network_handle_t *handle);
 // MQTT measurement publishing functions
 esp_err_t network_start_measurement_publishing(network_handle_t *handle);
 esp_err_t network_stop_measurement_publishing(network_handle_t *handle);
-esp_err_t network_queue_measurement(network_handle_t *handle, const measurement_t *measurement);
-
-// Get measurement queue handle
-QueueHandle_t network_get_measurement_queue(network_handle_t *handle);
+esp_err_t network_set_measurement_batching(network_handle_t *handle, bool enabled);
+esp_err_t network_set_measurement_batching_bounds(network_handle_t *handle, uint32_t max_frame_span_s, uint32_t outbox_limit_bytes);
+void network_get_measurement_loss_stats(network_handle_t *handle, measurement_loss_stats_t *stats);
+esp_err_t network_set_raw_measurement_publishing(network_handle_t *handle, bool enabled);
+esp_err_t network_set_binary_logging(network_handle_t *handle, bool enabled);
+esp_err_t network_set_log_batching(network_handle_t *handle, bool enabled);
+esp_err_t network_set_log_rate_limit(network_handle_t *handle, log_forward_level_t level, uint16_t lines_per_second, uint16_t burst);
+esp_err_t network_set_aggregation_tiers(network_handle_t *handle, const aggregation_tier_config_t *tiers, size_t tier_count,
+                                        float nominal_frequency);
+
+// Get the measurement ring and the record queue handles
+spsc_ring_t *network_get_measurement_ring(network_handle_t *handle);
+QueueHandle_t network_get_harmonics_queue(network_handle_t *handle);
+QueueHandle_t network_get_events_queue(network_handle_t *handle);
+QueueHandle_t network_get_synchrophasor_queue(network_handle_t *handle);
 
 // Time synchronization functions
 esp_err_t network_init_sntp(void);
@@ -235,6 +390,7 @@ esp_err_t network_schedule_deferred_restart(const char *reason);
 
 // Firmware functions
 esp_err_t network_publish_firmware_info(network_handle_t *handle);
+esp_err_t network_publish_crash_log(network_handle_t *handle);
 
 // HTTP Web Server functions
 esp_err_t network_start_web_server(network_handle_t *handle);
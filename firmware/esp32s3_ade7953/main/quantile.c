@@ -0,0 +1,101 @@
+#include "quantile.h"
+
+// Set up an empty estimator for quantile p
+quantile_error_t quantile_p2_init(quantile_p2_t *estimator, float p) {
+    if (!estimator || !(p > 0.0f && p < 1.0f)) {
+        return QUANTILE_ERROR_INVALID_PARAM;
+    }
+    
+    estimator->p = p;
+    quantile_p2_reset(estimator);
+    return QUANTILE_OK;
+}
+
+// Forget all samples, keeping the quantile
+void quantile_p2_reset(quantile_p2_t *estimator) {
+    float p = estimator->p;
+    
+    estimator->count = 0;
+    for (int i = 0; i < QUANTILE_P2_MARKERS; i++) {
+        estimator->heights[i] = 0.0f;
+        estimator->positions[i] = i + 1;
+    }
+    estimator->increments[0] = 0.0f;
+    estimator->increments[1] = p / 2.0f;
+    estimator->increments[2] = p;
+    estimator->increments[3] = (1.0f + p) / 2.0f;
+    estimator->increments[4] = 1.0f;
+}
+
+// Piecewise-parabolic prediction of marker i moved by d (+1 or -1)
+static float quantile_p2_parabolic(const quantile_p2_t *estimator, int i, int d) {
+    const float *q = estimator->heights;
+    const int32_t *n = estimator->positions;
+    
+    return q[i] + (float)d / (n[i + 1] - n[i - 1]) *
+           ((n[i] - n[i - 1] + d) * (q[i + 1] - q[i]) / (n[i + 1] - n[i]) +
+            (n[i + 1] - n[i] - d) * (q[i] - q[i - 1]) / (n[i] - n[i - 1]));
+}
+
+// Add a sample: place it between the markers, then move the inner markers toward their desired positions
+void quantile_p2_add(quantile_p2_t *estimator, float value) {
+    float *q = estimator->heights;
+    int32_t *n = estimator->positions;
+    
+    // The first five samples become the markers, kept sorted by insertion
+    if (estimator->count < QUANTILE_P2_MARKERS) {
+        int i = estimator->count++;
+        while (i > 0 && q[i - 1] > value) {
+            q[i] = q[i - 1];
+            i--;
+        }
+        q[i] = value;
+        return;
+    }
+    estimator->count++;
+    
+    // Cell the sample falls in, extending the extreme markers if needed
+    int k;
+    if (value < q[0]) {
+        q[0] = value;
+        k = 0;
+    } else if (value >= q[4]) {
+        q[4] = value;
+        k = 3;
+    } else {
+        k = 0;
+        while (k < 3 && value >= q[k + 1]) {
+            k++;
+        }
+    }
+    
+    for (int i = k + 1; i < QUANTILE_P2_MARKERS; i++) {
+        n[i]++;
+    }
+    for (int i = 1; i < QUANTILE_P2_MARKERS - 1; i++) {
+        // Desired position from the count: summing the increments in float drifts by whole positions over long windows
+        float offset = 1.0f + (estimator->count - 1) * estimator->increments[i] - n[i];
+        if ((offset >= 1.0f && n[i + 1] - n[i] > 1) || (offset <= -1.0f && n[i - 1] - n[i] < -1)) {
+            int d = offset > 0.0f ? 1 : -1;
+            float height = quantile_p2_parabolic(estimator, i, d);
+            if (!(q[i - 1] < height && height < q[i + 1])) {
+                // Linear when the parabola would overtake a neighbour
+                height = q[i] + d * (q[i + d] - q[i]) / (n[i + d] - n[i]);
+            }
+            q[i] = height;
+            n[i] += d;
+        }
+    }
+}
+
+// Middle marker, or the nearest-rank value of the few samples seen so far
+float quantile_p2_get(const quantile_p2_t *estimator) {
+    if (estimator->count == 0) {
+        return 0.0f;
+    }
+    if (estimator->count < QUANTILE_P2_MARKERS) {
+        uint32_t rank = (uint32_t)(estimator->p * estimator->count);
+        return estimator->heights[rank < estimator->count ? rank : estimator->count - 1];
+    }
+    return estimator->heights[2];
+}
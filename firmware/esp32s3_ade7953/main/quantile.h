@@ -0,0 +1,32 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// P² streaming quantile estimator (Jain and Chlamtac, 1985): five markers per quantile,
+// fixed memory and O(1) work per sample however long the interval
+#define QUANTILE_P2_MARKERS             5
+
+// Estimator state for one quantile
+typedef struct {
+    float p;                            // Quantile, 0 < p < 1
+    uint32_t count;
+    float heights[QUANTILE_P2_MARKERS]; // Marker heights, the middle one estimates the quantile
+    int32_t positions[QUANTILE_P2_MARKERS];
+    float increments[QUANTILE_P2_MARKERS]; // Desired marker position per sample, (count - 1) * increment + 1
+} quantile_p2_t;
+
+// Error codes
+typedef enum {
+    QUANTILE_OK = 0,
+    QUANTILE_ERROR_INVALID_PARAM = -1
+} quantile_error_t;
+
+// Function prototypes
+quantile_error_t quantile_p2_init(quantile_p2_t *estimator, float p);
+void quantile_p2_reset(quantile_p2_t *estimator);
+void quantile_p2_add(quantile_p2_t *estimator, float value);
+
+// Current estimate, exact while fewer than five samples have been added (0 with none)
+float quantile_p2_get(const quantile_p2_t *estimator);
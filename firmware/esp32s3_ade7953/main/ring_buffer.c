@@ -0,0 +1,161 @@
+#include "ring_buffer.h"
+#include <string.h>
+
+// Sequence number at the start of a slot
+static inline atomic_size_t *mpsc_ring_sequence(const mpsc_ring_t *ring, size_t position) {
+    return (atomic_size_t *)(ring->storage + (position & ring->mask) * ring->slot_size);
+}
+
+// Initialize a ring over caller-provided storage (MPSC_RING_STORAGE_SIZE bytes)
+ring_buffer_error_t mpsc_ring_init(mpsc_ring_t *ring, void *storage, size_t capacity, size_t element_size) {
+    if (!ring || !storage || capacity < 2 || (capacity & (capacity - 1)) != 0 || element_size == 0 ||
+        ((uintptr_t)storage % sizeof(atomic_size_t)) != 0) {
+        return RING_BUFFER_ERROR_INVALID_PARAM;
+    }
+    
+    ring->storage = storage;
+    ring->element_size = element_size;
+    ring->slot_size = MPSC_RING_SLOT_SIZE(element_size);
+    ring->mask = capacity - 1;
+    
+    // Slot i is free for the producer that claims position i
+    for (size_t i = 0; i < capacity; i++) {
+        atomic_init(mpsc_ring_sequence(ring, i), i);
+    }
+    atomic_init(&ring->enqueue_position, 0);
+    atomic_init(&ring->dequeue_position, 0);
+    
+    return RING_BUFFER_OK;
+}
+
+// Claim a slot, copy the element in, then publish it to the consumer
+bool mpsc_ring_push(mpsc_ring_t *ring, const void *element) {
+    size_t position = atomic_load_explicit(&ring->enqueue_position, memory_order_relaxed);
+    atomic_size_t *sequence;
+    
+    while (true) {
+        sequence = mpsc_ring_sequence(ring, position);
+        size_t slot_sequence = atomic_load_explicit(sequence, memory_order_acquire);
+        intptr_t difference = (intptr_t)slot_sequence - (intptr_t)position;
+        
+        if (difference == 0) {
+            if (atomic_compare_exchange_weak_explicit(&ring->enqueue_position, &position, position + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                break;
+            }
+            // position was reloaded by the failed compare-and-swap
+        } else if (difference < 0) {
+            return false;   // The consumer has not freed this slot yet
+        } else {
+            position = atomic_load_explicit(&ring->enqueue_position, memory_order_relaxed);
+        }
+    }
+    
+    memcpy((uint8_t *)sequence + sizeof(atomic_size_t), element, ring->element_size);
+    atomic_store_explicit(sequence, position + 1, memory_order_release);
+    return true;
+}
+
+// Take the oldest published element
+bool mpsc_ring_pop(mpsc_ring_t *ring, void *element) {
+    size_t position = atomic_load_explicit(&ring->dequeue_position, memory_order_relaxed);
+    atomic_size_t *sequence = mpsc_ring_sequence(ring, position);
+    
+    if (atomic_load_explicit(sequence, memory_order_acquire) != position + 1) {
+        return false;   // Empty, or the producer that claimed this slot is still copying
+    }
+    
+    memcpy(element, (uint8_t *)sequence + sizeof(atomic_size_t), ring->element_size);
+    
+    // Hand the slot to the producer one lap ahead
+    atomic_store_explicit(sequence, position + ring->mask + 1, memory_order_release);
+    atomic_store_explicit(&ring->dequeue_position, position + 1, memory_order_relaxed);
+    return true;
+}
+
+// Initialize a ring over caller-provided storage (SPSC_RING_STORAGE_SIZE bytes)
+ring_buffer_error_t spsc_ring_init(spsc_ring_t *ring, void *storage, size_t capacity, size_t element_size) {
+    if (!ring || !storage || capacity < 2 || (capacity & (capacity - 1)) != 0 || element_size == 0) {
+        return RING_BUFFER_ERROR_INVALID_PARAM;
+    }
+    
+    ring->storage = storage;
+    ring->element_size = element_size;
+    ring->mask = capacity - 1;
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+    atomic_init(&ring->high_water, 0);
+    atomic_init(&ring->drop_count, 0);
+    
+    return RING_BUFFER_OK;
+}
+
+// Copy the element into the next free slot, then publish it by advancing head
+bool spsc_ring_push(spsc_ring_t *ring, const void *element) {
+    size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    
+    if (head - tail > ring->mask) {
+        atomic_fetch_add_explicit(&ring->drop_count, 1, memory_order_relaxed);
+        return false;
+    }
+    
+    memcpy(ring->storage + (head & ring->mask) * ring->element_size, element, ring->element_size);
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+    
+    // Only the producer writes the high-water mark, so a plain load and store is enough
+    size_t count = head + 1 - tail;
+    if (count > atomic_load_explicit(&ring->high_water, memory_order_relaxed)) {
+        atomic_store_explicit(&ring->high_water, count, memory_order_relaxed);
+    }
+    return true;
+}
+
+// Copy out everything published so far (up to max_count) in at most two chunks, then free the slots
+size_t spsc_ring_pop_bulk(spsc_ring_t *ring, void *elements, size_t max_count) {
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    size_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    size_t count = head - tail;
+    
+    if (count > max_count) {
+        count = max_count;
+    }
+    if (count == 0) {
+        return 0;
+    }
+    
+    size_t first = tail & ring->mask;
+    size_t until_wrap = ring->mask + 1 - first;
+    size_t first_count = count < until_wrap ? count : until_wrap;
+    memcpy(elements, ring->storage + first * ring->element_size, first_count * ring->element_size);
+    if (count > first_count) {
+        memcpy((uint8_t *)elements + first_count * ring->element_size, ring->storage,
+               (count - first_count) * ring->element_size);
+    }
+    
+    atomic_store_explicit(&ring->tail, tail + count, memory_order_release);
+    return count;
+}
+
+// Move tail up to head
+size_t spsc_ring_discard(spsc_ring_t *ring) {
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    size_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    
+    atomic_store_explicit(&ring->tail, head, memory_order_release);
+    return head - tail;
+}
+
+// Snapshot of the counters
+void spsc_ring_get_stats(spsc_ring_t *ring, spsc_ring_stats_t *stats) {
+    if (!ring || !stats) {
+        return;
+    }
+    
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    stats->capacity = ring->mask + 1;
+    stats->count = head - tail;
+    stats->high_water = atomic_load_explicit(&ring->high_water, memory_order_relaxed);
+    stats->drop_count = atomic_load_explicit(&ring->drop_count, memory_order_relaxed);
+}
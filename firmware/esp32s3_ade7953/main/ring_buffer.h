@@ -0,0 +1,79 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdatomic.h>
+
+// Storage sizing: each slot carries a sequence number in front of the element
+#define MPSC_RING_SLOT_SIZE(element_size) \
+    ((sizeof(atomic_size_t) + (element_size) + sizeof(atomic_size_t) - 1) / sizeof(atomic_size_t) * sizeof(atomic_size_t))
+#define MPSC_RING_STORAGE_SIZE(capacity, element_size) ((capacity) * MPSC_RING_SLOT_SIZE(element_size))
+#define SPSC_RING_STORAGE_SIZE(capacity, element_size) ((capacity) * (element_size))
+
+// Keeps the producer and consumer indices on separate lines (ESP32-S3 data cache line size)
+#define RING_BUFFER_CACHE_LINE_SIZE 32
+
+// Bounded multi-producer single-consumer ring (per-slot sequence numbers, no locks).
+// Producers claim a slot with a compare-and-swap on the enqueue position; the consumer never blocks them.
+typedef struct {
+    uint8_t *storage;                   // capacity slots of slot_size bytes, aligned for atomic_size_t
+    size_t element_size;
+    size_t slot_size;
+    size_t mask;                        // capacity - 1, capacity is a power of two
+    atomic_size_t enqueue_position;
+    atomic_size_t dequeue_position;     // Only written by the consumer
+} mpsc_ring_t;
+
+// Bounded single-producer single-consumer ring (two indices, no locks, no compare-and-swap).
+// Each index is written by one side only and lives on its own cache line; the storage is plain elements.
+typedef struct {
+    // Producer side
+    atomic_size_t head __attribute__((aligned(RING_BUFFER_CACHE_LINE_SIZE)));
+    atomic_size_t high_water;           // Most elements ever waiting
+    atomic_uint_least32_t drop_count;   // Pushes refused because the ring was full
+    
+    // Consumer side
+    atomic_size_t tail __attribute__((aligned(RING_BUFFER_CACHE_LINE_SIZE)));
+    
+    // Constant after init
+    uint8_t *storage __attribute__((aligned(RING_BUFFER_CACHE_LINE_SIZE)));
+    size_t element_size;
+    size_t mask;                        // capacity - 1, capacity is a power of two
+} spsc_ring_t;
+
+typedef struct {
+    size_t capacity;
+    size_t count;                       // Waiting right now
+    size_t high_water;
+    uint32_t drop_count;
+} spsc_ring_stats_t;
+
+// Error codes
+typedef enum {
+    RING_BUFFER_OK = 0,
+    RING_BUFFER_ERROR_INVALID_PARAM = -1
+} ring_buffer_error_t;
+
+// Function prototypes
+ring_buffer_error_t mpsc_ring_init(mpsc_ring_t *ring, void *storage, size_t capacity, size_t element_size);
+
+// Any task or ISR - returns false when the ring is full
+bool mpsc_ring_push(mpsc_ring_t *ring, const void *element);
+
+// Single consumer only - returns false when the ring is empty
+bool mpsc_ring_pop(mpsc_ring_t *ring, void *element);
+
+ring_buffer_error_t spsc_ring_init(spsc_ring_t *ring, void *storage, size_t capacity, size_t element_size);
+
+// Producer only - returns false and counts a drop when the ring is full
+bool spsc_ring_push(spsc_ring_t *ring, const void *element);
+
+// Consumer only - copy up to max_count of the oldest elements into elements, returns how many
+size_t spsc_ring_pop_bulk(spsc_ring_t *ring, void *elements, size_t max_count);
+
+// Consumer only - drop everything waiting, returns how many
+size_t spsc_ring_discard(spsc_ring_t *ring);
+
+// Any task
+void spsc_ring_get_stats(spsc_ring_t *ring, spsc_ring_stats_t *stats);
@@ -0,0 +1,282 @@
+#include "storage.h"
+#include <string.h>
+#include <stdlib.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "esp_littlefs.h"
+#include "esp_rom_crc.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+static const char *TAG = "storage";
+
+// Path of a segment file, IDs are hex so the names sort in write order
+static void storage_segment_path(uint32_t segment, char *path) {
+    snprintf(path, STORAGE_PATH_LEN, STORAGE_SPOOL_DIR "/%08lx.seg", (unsigned long)segment);
+}
+
+// Delete the oldest segment, sent or not
+static void storage_log_remove_first(storage_log_t *log) {
+    char path[STORAGE_PATH_LEN];
+    
+    if (log->read_file) {
+        fclose(log->read_file);
+        log->read_file = NULL;
+    }
+    storage_segment_path(log->first_segment, path);
+    remove(path);
+    
+    log->first_segment++;
+    log->read_offset = 0;
+    log->peeked_length = 0;
+}
+
+// Write the buffered records to the open segment, creating (and rotating) segments as needed
+static storage_error_t storage_log_flush(storage_log_t *log) {
+    if (log->write_length == 0) {
+        return STORAGE_OK;
+    }
+    
+    if (!log->write_file) {
+        // Oldest data goes first when the partition budget is used up
+        while (log->next_segment - log->first_segment >= STORAGE_MAX_SEGMENTS) {
+            ESP_LOGW(TAG, "Spool full, dropping segment %lu", log->first_segment);
+            storage_log_remove_first(log);
+            log->stats.dropped_segments++;
+        }
+        
+        char path[STORAGE_PATH_LEN];
+        storage_segment_path(log->next_segment, path);
+        log->write_file = fopen(path, "wb");
+        if (!log->write_file) {
+            ESP_LOGE(TAG, "Failed to create %s", path);
+            log->write_length = 0;
+            return STORAGE_ERROR_IO;
+        }
+        log->next_segment++;
+        log->write_file_size = 0;
+    }
+    
+    // One sector-sized write and one commit per flush
+    bool written = fwrite(log->write_buffer, 1, log->write_length, log->write_file) == log->write_length &&
+                   fflush(log->write_file) == 0 && fsync(fileno(log->write_file)) == 0;
+    log->write_file_size += log->write_length;
+    log->write_length = 0;
+    
+    if (!written || log->write_file_size >= STORAGE_SEGMENT_SIZE) {
+        fclose(log->write_file);
+        log->write_file = NULL;
+    }
+    
+    if (!written) {
+        ESP_LOGE(TAG, "Failed to write segment %lu", log->next_segment - 1);
+        return STORAGE_ERROR_IO;
+    }
+    return STORAGE_OK;
+}
+
+// Mount the data partition and find the segments left from before the last reset
+storage_error_t storage_log_init(storage_log_t *log) {
+    if (!log) {
+        return STORAGE_ERROR_INVALID_PARAM;
+    }
+    
+    memset(log, 0, sizeof(storage_log_t));
+    
+    esp_vfs_littlefs_conf_t conf = {
+        .base_path = STORAGE_BASE_PATH,
+        .partition_label = STORAGE_PARTITION_LABEL,
+        .format_if_mount_failed = true,
+        .dont_mount = false,
+    };
+    esp_err_t ret = esp_vfs_littlefs_register(&conf);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to mount littlefs partition '%s': %s", STORAGE_PARTITION_LABEL, esp_err_to_name(ret));
+        return STORAGE_ERROR_MOUNT;
+    }
+    log->mounted = true;
+    mkdir(STORAGE_SPOOL_DIR, 0755);
+    
+    DIR *dir = opendir(STORAGE_SPOOL_DIR);
+    if (!dir) {
+        ESP_LOGE(TAG, "Failed to open %s", STORAGE_SPOOL_DIR);
+        storage_log_deinit(log);
+        return STORAGE_ERROR_IO;
+    }
+    
+    // Gaps between IDs are skipped on replay
+    bool found = false;
+    uint32_t lowest = 0, highest = 0;
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        char *end;
+        uint32_t segment = strtoul(entry->d_name, &end, 16);
+        if (end == entry->d_name || strcmp(end, ".seg") != 0) {
+            continue;
+        }
+        if (!found || segment < lowest) {
+            lowest = segment;
+        }
+        if (!found || segment > highest) {
+            highest = segment;
+        }
+        found = true;
+    }
+    closedir(dir);
+    
+    // Segments from before the reset are sealed, new records start a new one
+    if (found) {
+        log->first_segment = lowest;
+        log->next_segment = highest + 1;
+    }
+    
+    size_t total = 0, used = 0;
+    esp_littlefs_info(STORAGE_PARTITION_LABEL, &total, &used);
+    ESP_LOGI(TAG, "Spool mounted: %lu segments waiting, %u of %u bytes used",
+             log->next_segment - log->first_segment, (unsigned)used, (unsigned)total);
+    return STORAGE_OK;
+}
+
+// Write out what is buffered and unmount
+void storage_log_deinit(storage_log_t *log) {
+    if (!log || !log->mounted) {
+        return;
+    }
+    
+    storage_log_seal(log);
+    if (log->read_file) {
+        fclose(log->read_file);
+        log->read_file = NULL;
+    }
+    esp_vfs_littlefs_unregister(STORAGE_PARTITION_LABEL);
+    log->mounted = false;
+}
+
+// Frame a record into the write buffer
+storage_error_t storage_log_append(storage_log_t *log, const uint8_t *data, size_t length) {
+    if (!log || !log->mounted || !data || length == 0 || length > STORAGE_MAX_RECORD_SIZE) {
+        return STORAGE_ERROR_INVALID_PARAM;
+    }
+    
+    if (log->write_length + STORAGE_RECORD_HEADER_SIZE + length > STORAGE_WRITE_BUFFER_SIZE) {
+        storage_log_flush(log);
+    }
+    if (log->write_length == 0) {
+        log->write_buffer_since_us = esp_timer_get_time();
+    }
+    
+    uint32_t crc = esp_rom_crc32_le(0, data, length);
+    uint8_t *p = log->write_buffer + log->write_length;
+    p[0] = STORAGE_RECORD_MAGIC & 0xFF;
+    p[1] = STORAGE_RECORD_MAGIC >> 8;
+    p[2] = length & 0xFF;
+    p[3] = length >> 8;
+    p[4] = crc & 0xFF;
+    p[5] = (crc >> 8) & 0xFF;
+    p[6] = (crc >> 16) & 0xFF;
+    p[7] = crc >> 24;
+    memcpy(p + STORAGE_RECORD_HEADER_SIZE, data, length);
+    log->write_length += STORAGE_RECORD_HEADER_SIZE + length;
+    log->stats.appended_records++;
+    
+    return STORAGE_OK;
+}
+
+// Bound the data at risk in RAM while records trickle in
+void storage_log_poll(storage_log_t *log) {
+    if (log && log->write_length > 0 && esp_timer_get_time() - log->write_buffer_since_us >= STORAGE_FLUSH_INTERVAL_US) {
+        storage_log_flush(log);
+    }
+}
+
+// Flush and close the open segment
+void storage_log_seal(storage_log_t *log) {
+    if (!log || !log->mounted) {
+        return;
+    }
+    
+    storage_log_flush(log);
+    if (log->write_file) {
+        fclose(log->write_file);
+        log->write_file = NULL;
+    }
+}
+
+// Sealed segments are all but the one still open for writing
+bool storage_log_pending(const storage_log_t *log) {
+    if (!log || !log->mounted) {
+        return false;
+    }
+    return log->next_segment - log->first_segment > (log->write_file ? 1u : 0u);
+}
+
+bool storage_log_unsealed(const storage_log_t *log) {
+    return log && log->mounted && (log->write_file || log->write_length > 0);
+}
+
+// Read and check the record at the replay position, moving past finished or damaged segments
+size_t storage_log_peek(storage_log_t *log, uint8_t *buffer, size_t size) {
+    if (!log || !buffer) {
+        return 0;
+    }
+    
+    while (storage_log_pending(log)) {
+        if (!log->read_file) {
+            char path[STORAGE_PATH_LEN];
+            storage_segment_path(log->first_segment, path);
+            log->read_file = fopen(path, "rb");
+            if (!log->read_file) {
+                storage_log_remove_first(log);  // Missing, nothing to replay
+                continue;
+            }
+        }
+        
+        uint8_t header[STORAGE_RECORD_HEADER_SIZE];
+        size_t header_length = 0;
+        if (fseek(log->read_file, log->read_offset, SEEK_SET) == 0) {
+            header_length = fread(header, 1, sizeof(header), log->read_file);
+        }
+        if (header_length == 0) {
+            storage_log_remove_first(log);      // Segment fully replayed
+            continue;
+        }
+        
+        uint16_t magic = header[0] | (header[1] << 8);
+        size_t length = header[2] | (header[3] << 8);
+        uint32_t crc = header[4] | (header[5] << 8) | (header[6] << 16) | ((uint32_t)header[7] << 24);
+        
+        // A record cut short by a reset, or damaged, ends the segment
+        if (header_length != sizeof(header) || magic != STORAGE_RECORD_MAGIC || length == 0 || length > size ||
+            fread(buffer, 1, length, log->read_file) != length || esp_rom_crc32_le(0, buffer, length) != crc) {
+            ESP_LOGW(TAG, "Corrupt record in segment %lu at offset %ld, skipping the rest", log->first_segment, log->read_offset);
+            log->stats.corrupt_records++;
+            storage_log_remove_first(log);
+            continue;
+        }
+        
+        log->peeked_length = STORAGE_RECORD_HEADER_SIZE + length;
+        return length;
+    }
+    
+    return 0;
+}
+
+// Move past the record returned by the last peek
+void storage_log_advance(storage_log_t *log) {
+    if (log && log->peeked_length > 0) {
+        log->read_offset += log->peeked_length;
+        log->peeked_length = 0;
+        log->stats.replayed_records++;
+    }
+}
+
+// Snapshot of the counters
+void storage_log_get_stats(const storage_log_t *log, storage_log_stats_t *stats) {
+    if (!log || !stats) {
+        return;
+    }
+    
+    memcpy(stats, &log->stats, sizeof(storage_log_stats_t));
+    stats->segment_count = log->next_segment - log->first_segment;
+}
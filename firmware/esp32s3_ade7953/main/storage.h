@@ -0,0 +1,82 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+// Partition (see partitions.csv)
+#define STORAGE_PARTITION_LABEL     "data"
+#define STORAGE_BASE_PATH           "/data"
+#define STORAGE_SPOOL_DIR           STORAGE_BASE_PATH "/spool"
+#define STORAGE_PATH_LEN            48
+
+// Segment log: append-only files written a block at a time, deleted whole once sent
+#define STORAGE_SEGMENT_SIZE        (64 * 1024)
+#define STORAGE_MAX_SEGMENTS        12          // 768 KB of the 1 MB partition, the rest is littlefs metadata and headroom
+#define STORAGE_WRITE_BUFFER_SIZE   8192        // Two flash sectors (blocks are never rewritten for a partial append), fits the largest frame
+#define STORAGE_FLUSH_INTERVAL_US   (30 * 1000000LL) // Most a power cut can lose while offline
+
+// Record: uint16 magic, uint16 payload length, uint32 CRC-32 of the payload, payload (little-endian)
+#define STORAGE_RECORD_MAGIC        0x5247      // "GR"
+#define STORAGE_RECORD_HEADER_SIZE  8
+#define STORAGE_MAX_RECORD_SIZE     (STORAGE_WRITE_BUFFER_SIZE - STORAGE_RECORD_HEADER_SIZE)
+
+// Counters
+typedef struct {
+    uint32_t appended_records;
+    uint32_t replayed_records;
+    uint32_t dropped_segments;          // Oldest segments deleted unsent to make room
+    uint32_t corrupt_records;           // Failed the CRC or cut short, the rest of that segment is skipped
+    uint32_t segment_count;             // On flash right now
+} storage_log_stats_t;
+
+// Log state, owned by one task. Segments first_segment .. next_segment - 1 are on flash.
+typedef struct {
+    bool mounted;
+    uint32_t first_segment;             // Oldest, read from here
+    uint32_t next_segment;              // ID of the next segment to create
+    FILE *write_file;                   // Open segment being appended to, NULL once sealed
+    size_t write_file_size;
+    uint8_t write_buffer[STORAGE_WRITE_BUFFER_SIZE];
+    size_t write_length;
+    int64_t write_buffer_since_us;      // esp_timer time of the oldest buffered record
+    FILE *read_file;                    // first_segment, opened for replay
+    long read_offset;
+    size_t peeked_length;               // Record returned by the last storage_log_peek(), with its header
+    storage_log_stats_t stats;
+} storage_log_t;
+
+// Error codes
+typedef enum {
+    STORAGE_OK = 0,
+    STORAGE_ERROR_MOUNT = -1,
+    STORAGE_ERROR_IO = -2,
+    STORAGE_ERROR_INVALID_PARAM = -3
+} storage_error_t;
+
+// Function prototypes
+storage_error_t storage_log_init(storage_log_t *log);
+void storage_log_deinit(storage_log_t *log);
+
+// Buffer a record, it reaches flash when the buffer fills, on storage_log_poll() or storage_log_seal()
+storage_error_t storage_log_append(storage_log_t *log, const uint8_t *data, size_t length);
+
+// Write out the buffer once it has waited STORAGE_FLUSH_INTERVAL_US
+void storage_log_poll(storage_log_t *log);
+
+// Write out the buffer and close the open segment, so everything appended so far can be replayed
+void storage_log_seal(storage_log_t *log);
+
+// True if sealed records are waiting for replay
+bool storage_log_pending(const storage_log_t *log);
+
+// True if records appended since the last seal are still in the buffer or the open segment
+bool storage_log_unsealed(const storage_log_t *log);
+
+// Copy the oldest sealed record into buffer and return its length, 0 if there is none.
+// The same record is returned again until storage_log_advance() is called.
+size_t storage_log_peek(storage_log_t *log, uint8_t *buffer, size_t size);
+void storage_log_advance(storage_log_t *log);
+
+void storage_log_get_stats(const storage_log_t *log, storage_log_stats_t *stats);
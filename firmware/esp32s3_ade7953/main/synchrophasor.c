@@ -0,0 +1,289 @@
+#include "synchrophasor.h"
+#include "dsp.h"
+#include <string.h>
+#include <math.h>
+#include "esp_log.h"
+
+static const char *TAG = "synchrophasor";
+
+// Wrap an angle to [-pi, pi)
+static float synchrophasor_wrap(double angle) {
+    angle = fmod(angle + M_PI, 2.0 * M_PI);
+    if (angle < 0.0) {
+        angle += 2.0 * M_PI;
+    }
+    return (float)(angle - M_PI);
+}
+
+// Estimate the phasor of the pending window and queue the report
+static void synchrophasor_estimate(synchrophasor_t *sp) {
+    synchrophasor_measurement_t *m = &sp->pending;
+    size_t n = sp->window_size;
+    float *x = sp->buffer;
+    
+    dsp_int32_to_float(sp->samples, x, n, 1.0f);
+    
+    // Total RMS of the window in LSB ties the waveform scale to the calibrated VRMS reading
+    float total_rms = sqrtf(dsp_dotprod(x, x, n) / n);
+    if (total_rms <= 0.0f) {
+        return;
+    }
+    float volts_per_lsb = m->magnitude / total_rms;
+    
+    if (sp->window_function_size != n) {
+        dsp_window_hann(sp->window, n);
+        sp->window_function_size = n;
+        sp->window_sum = 0.0f;
+        for (size_t i = 0; i < n; i++) {
+            sp->window_sum += sp->window[i];
+        }
+    }
+    dsp_multiply(x, sp->window, x, n);
+    
+    // Goertzel gives the phase of the fundamental at the last sample of the block
+    float amplitude, phase;
+    dsp_goertzel(x, n, m->frequency / (float)WAVEFORM_SAMPLE_RATE_HZ, &amplitude, &phase);
+    
+    // Rotate from the last sample to the reporting instant at the measured frequency, then subtract the
+    // phase of the UTC-aligned nominal reference (integer Hz, so exact in integer microseconds)
+    int64_t reference_us = (m->timestamp_us % 1000000) * sp->nominal_frequency % 1000000;
+    double advance = 2.0 * M_PI * m->frequency * (m->timestamp_us - sp->last_sample_us) * 1e-6;
+    double reference = 2.0 * M_PI * reference_us * 1e-6;
+    m->angle = synchrophasor_wrap(phase + advance - reference);
+    
+    // Undo the coherent gain of the window (just under 0.5 for a short Hann window), then peak to RMS
+    m->magnitude = amplitude * n / sp->window_sum / sqrtf(2.0f) * volts_per_lsb;
+    
+    if (sp->output_queue) {
+        // Queue report (non-blocking), a full queue drops it like the measurement queue does
+        xQueueSend(sp->output_queue, m, 0);
+    }
+}
+
+// Estimation task - one report per notification
+static void synchrophasor_task(void *pvParameters) {
+    synchrophasor_t *sp = (synchrophasor_t *)pvParameters;
+    
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        synchrophasor_estimate(sp);
+        sp->busy = false;
+    }
+}
+
+// Initialize the estimator and start its task, C37.118 knows 50 and 60 Hz grids only
+synchrophasor_error_t synchrophasor_init(synchrophasor_t *sp, uint32_t rate, uint32_t nominal_frequency) {
+    if (!sp || (nominal_frequency != 50 && nominal_frequency != 60)) {
+        return SYNCHROPHASOR_ERROR_INVALID_PARAM;
+    }
+    
+    QueueHandle_t output_queue = sp->output_queue;
+    memset(sp, 0, sizeof(synchrophasor_t));
+    sp->output_queue = output_queue;
+    sp->nominal_frequency = nominal_frequency;
+    
+    if (synchrophasor_set_rate(sp, rate) != SYNCHROPHASOR_OK || dsp_init() != DSP_OK) {
+        return SYNCHROPHASOR_ERROR_INIT;
+    }
+    
+    BaseType_t ret = xTaskCreatePinnedToCore(
+        synchrophasor_task,
+        SYNCHROPHASOR_TASK_NAME,
+        SYNCHROPHASOR_TASK_STACK_SIZE,
+        sp,
+        SYNCHROPHASOR_TASK_PRIORITY,
+        &sp->task_handle,
+        SYNCHROPHASOR_TASK_CORE
+    );
+    
+    if (ret != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create synchrophasor task");
+        return SYNCHROPHASOR_ERROR_INIT;
+    }
+    
+    return SYNCHROPHASOR_OK;
+}
+
+// Stop the estimation task
+void synchrophasor_deinit(synchrophasor_t *sp) {
+    if (sp && sp->task_handle) {
+        vTaskDelete(sp->task_handle);
+        sp->task_handle = NULL;
+    }
+}
+
+// Set the reporting rate, reports stay on whole multiples of 1 / rate seconds of UTC
+synchrophasor_error_t synchrophasor_set_rate(synchrophasor_t *sp, uint32_t rate) {
+    if (!sp || rate == 0 || rate > SYNCHROPHASOR_MAX_RATE || 1000000 % rate != 0) {
+        return SYNCHROPHASOR_ERROR_INVALID_PARAM;
+    }
+    
+    sp->rate = rate;
+    sp->period_us = 1000000 / rate;
+    sp->next_report_us = 0;     // Realigned on the next sample
+    return SYNCHROPHASOR_OK;
+}
+
+// Set the queue that receives synchrophasor_measurement_t
+void synchrophasor_set_queue(synchrophasor_t *sp, QueueHandle_t output_queue) {
+    if (sp) {
+        sp->output_queue = output_queue;
+    }
+}
+
+// Hand the window ending at the newest waveform sample to the estimation task
+synchrophasor_error_t synchrophasor_submit(synchrophasor_t *sp, const waveform_estimator_t *wf, int64_t sample_us,
+                                           float frequency, float rocof, float voltage_rms, uint16_t stat, uint8_t time_quality) {
+    if (!sp || !sp->task_handle) {
+        return SYNCHROPHASOR_ERROR_INVALID_PARAM;
+    }
+    
+    // Schedule the next instant first, so a skipped report or a clock step never stalls the schedule
+    int64_t report_us = sp->next_report_us;
+    sp->next_report_us = (sample_us / sp->period_us + 1) * sp->period_us;
+    if (report_us == 0 || sample_us < report_us || sample_us - report_us >= sp->period_us) {
+        return SYNCHROPHASOR_ERROR_INVALID_PARAM;   // First sample, a gap or a clock step, wait for the next instant
+    }
+    
+    if (sp->busy) {
+        sp->skipped_count++;
+        return SYNCHROPHASOR_ERROR_BUSY;
+    }
+    
+    if (frequency <= 0.0f || voltage_rms <= 0.0f) {
+        return SYNCHROPHASOR_ERROR_INVALID_PARAM;
+    }
+    
+    size_t window_size = (size_t)(SYNCHROPHASOR_WINDOW_CYCLES * WAVEFORM_SAMPLE_RATE_HZ / frequency + 0.5);
+    if (window_size > SYNCHROPHASOR_MAX_WINDOW_SIZE) {
+        return SYNCHROPHASOR_ERROR_INVALID_PARAM;
+    }
+    
+    // Only a plain copy here, the estimation itself runs at lower priority so no waveform sample is missed
+    if (waveform_copy_latest(wf, sp->samples, window_size) != window_size) {
+        return SYNCHROPHASOR_ERROR_BUSY;    // Not enough history since the last estimator reset
+    }
+    
+    sp->window_size = window_size;
+    sp->last_sample_us = sample_us - SYNCHROPHASOR_SAMPLE_DELAY_US;
+    sp->pending = (synchrophasor_measurement_t) {
+        .timestamp_us = report_us,
+        .magnitude = voltage_rms,       // Replaced by the fundamental once estimated
+        .frequency = frequency,
+        .rocof = rocof,
+        .stat = stat,
+        .time_quality = time_quality,
+    };
+    sp->busy = true;
+    xTaskNotifyGive(sp->task_handle);
+    
+    return SYNCHROPHASOR_OK;
+}
+
+// Big-endian writers
+static uint8_t *put_u16(uint8_t *p, uint16_t value) {
+    p[0] = value >> 8;
+    p[1] = value & 0xFF;
+    return p + 2;
+}
+
+static uint8_t *put_u32(uint8_t *p, uint32_t value) {
+    p[0] = value >> 24;
+    p[1] = (value >> 16) & 0xFF;
+    p[2] = (value >> 8) & 0xFF;
+    p[3] = value & 0xFF;
+    return p + 4;
+}
+
+static uint8_t *put_f32(uint8_t *p, float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return put_u32(p, bits);
+}
+
+// CRC-CCITT as specified by C37.118 (polynomial 0x1021, initial value 0xFFFF)
+uint16_t synchrophasor_crc_ccitt(const uint8_t *data, size_t length) {
+    uint16_t crc = 0xFFFF;
+    
+    for (size_t i = 0; i < length; i++) {
+        uint16_t temp = (crc >> 8) ^ data[i];
+        crc <<= 8;
+        uint16_t quick = temp ^ (temp >> 4);
+        crc ^= quick;
+        quick <<= 5;
+        crc ^= quick;
+        quick <<= 7;
+        crc ^= quick;
+    }
+    
+    return crc;
+}
+
+// SOC and FRACSEC of a UTC timestamp
+static uint8_t *put_time(uint8_t *p, int64_t timestamp_us, uint8_t time_quality) {
+    p = put_u32(p, (uint32_t)(timestamp_us / 1000000));
+    return put_u32(p, ((uint32_t)time_quality << 24) | (uint32_t)(timestamp_us % 1000000));
+}
+
+// Encode a data frame with one phasor
+size_t synchrophasor_encode_data_frame(const synchrophasor_measurement_t *measurement, uint16_t idcode, uint8_t *buffer, size_t size) {
+    if (!measurement || !buffer || size < C37118_DATA_FRAME_SIZE) {
+        return 0;
+    }
+    
+    uint8_t *p = buffer;
+    p = put_u16(p, C37118_SYNC_DATA);
+    p = put_u16(p, C37118_DATA_FRAME_SIZE);
+    p = put_u16(p, idcode);
+    p = put_time(p, measurement->timestamp_us, measurement->time_quality);
+    p = put_u16(p, measurement->stat);
+    p = put_f32(p, measurement->magnitude);
+    p = put_f32(p, measurement->angle);
+    p = put_f32(p, measurement->frequency);     // Float FREQ is the actual frequency in Hz
+    p = put_f32(p, measurement->rocof);
+    p = put_u16(p, synchrophasor_crc_ccitt(buffer, p - buffer));
+    
+    return p - buffer;
+}
+
+// Encode the CFG-2 frame that describes the data frames
+size_t synchrophasor_encode_config_frame(uint16_t idcode, const char *station_name, uint32_t rate,
+                                         uint32_t nominal_frequency, int64_t timestamp_us, uint8_t *buffer, size_t size) {
+    if (!buffer || size < C37118_CONFIG_FRAME_SIZE) {
+        return 0;
+    }
+    
+    uint8_t *p = buffer;
+    p = put_u16(p, C37118_SYNC_CONFIG2);
+    p = put_u16(p, C37118_CONFIG_FRAME_SIZE);
+    p = put_u16(p, idcode);
+    p = put_time(p, timestamp_us, 0);
+    p = put_u32(p, C37118_TIME_BASE);
+    p = put_u16(p, 1);                          // NUM_PMU
+    
+    // Station name, space padded
+    memset(p, ' ', C37118_STATION_NAME_LEN);
+    if (station_name) {
+        size_t length = strlen(station_name);
+        memcpy(p, station_name, length < C37118_STATION_NAME_LEN ? length : C37118_STATION_NAME_LEN);
+    }
+    p += C37118_STATION_NAME_LEN;
+    
+    p = put_u16(p, idcode);
+    p = put_u16(p, C37118_FORMAT_FLOAT_POLAR);
+    p = put_u16(p, 1);                          // PHNMR
+    p = put_u16(p, 0);                          // ANNMR
+    p = put_u16(p, 0);                          // DGNMR
+    
+    memset(p, ' ', C37118_STATION_NAME_LEN);
+    memcpy(p, "VA", 2);
+    p += C37118_STATION_NAME_LEN;
+    
+    p = put_u32(p, 0);                          // PHUNIT: voltage, scale unused with float phasors
+    p = put_u16(p, nominal_frequency == 50 ? C37118_FNOM_50HZ : 0);
+    p = put_u16(p, 0);                          // CFGCNT
+    p = put_u16(p, (uint16_t)rate);
+    p = put_u16(p, synchrophasor_crc_ccitt(buffer, p - buffer));
+    
+    return p - buffer;
+}
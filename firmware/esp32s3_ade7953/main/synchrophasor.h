@@ -0,0 +1,109 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "waveform.h"
+
+// Estimation configuration
+#define SYNCHROPHASOR_DEFAULT_RATE          10      // Reports per second, must divide one second in whole microseconds
+#define SYNCHROPHASOR_MAX_RATE              50
+#define SYNCHROPHASOR_WINDOW_CYCLES         2       // Hann window of two cycles at the measured frequency
+#define SYNCHROPHASOR_MAX_WINDOW_SIZE       360     // Samples for 2 cycles down to ~39 Hz
+#define SYNCHROPHASOR_SAMPLE_DELAY_US       0       // Delay between a V sample and its WSMP edge, calibrate against a reference PMU
+
+// Task configuration (lower priority than acquisition, same core)
+#define SYNCHROPHASOR_TASK_STACK_SIZE       (4 * 1024)
+#define SYNCHROPHASOR_TASK_PRIORITY         5
+#define SYNCHROPHASOR_TASK_NAME             "synchrophasor_task"
+#define SYNCHROPHASOR_TASK_CORE             1
+
+// IEEE C37.118.2-2011 framing
+#define C37118_SYNC_DATA                    0xAA02  // Data frame, version 2
+#define C37118_SYNC_CONFIG2                 0xAA32  // Configuration frame 2, version 2
+#define C37118_TIME_BASE                    1000000 // FRACSEC counts microseconds
+#define C37118_DATA_FRAME_SIZE              34      // One float polar phasor, float FREQ/DFREQ, no analogs or digitals
+#define C37118_CONFIG_FRAME_SIZE            74
+#define C37118_STATION_NAME_LEN             16
+#define C37118_FORMAT_FLOAT_POLAR           0x000B  // FREQ/DFREQ float, phasors float, polar
+#define C37118_FNOM_50HZ                    0x0001
+
+// STAT word bits
+#define C37118_STAT_SYNC_ERROR              (1 << 13)   // Not synchronized to UTC
+#define C37118_STAT_TRIGGER                 (1 << 11)
+#define C37118_STAT_TIME_QUALITY_SHIFT      6
+#define C37118_STAT_TIME_QUALITY_10MS       0x6         // Time error below 10 ms
+#define C37118_STAT_TIME_QUALITY_UNKNOWN    0x7
+#define C37118_TRIGGER_MAGNITUDE_LOW        0x1
+#define C37118_TRIGGER_MAGNITUDE_HIGH       0x2
+#define C37118_TRIGGER_FREQUENCY            0x4
+#define C37118_TRIGGER_DFDT                 0x5
+
+// FRACSEC time quality (most significant byte)
+#define C37118_TIME_QUALITY_10MS            0x8         // SNTP over WiFi, within 10 ms of UTC
+#define C37118_TIME_QUALITY_FAULT           0xF
+
+// One synchrophasor report
+typedef struct {
+    int64_t timestamp_us;               // UTC reporting instant
+    float magnitude;                    // Fundamental RMS voltage
+    float angle;                        // Radians in [-pi, pi), relative to a nominal-frequency cosine aligned to UTC
+    float frequency;                    // Hz
+    float rocof;                        // Hz/s
+    uint16_t stat;                      // C37.118 STAT word
+    uint8_t time_quality;               // C37.118 FRACSEC time quality
+} synchrophasor_measurement_t;
+
+// Estimator state
+typedef struct {
+    TaskHandle_t task_handle;
+    QueueHandle_t output_queue;
+    volatile bool busy;                 // A window is waiting for or being processed
+    uint32_t skipped_count;             // Reports dropped because the previous one was still being processed
+    uint32_t rate;
+    uint32_t nominal_frequency;         // Hz, 50 or 60: angles are referenced to a cosine at this frequency
+    int64_t period_us;
+    int64_t next_report_us;
+    
+    // Window handed over by the acquisition task
+    int32_t samples[SYNCHROPHASOR_MAX_WINDOW_SIZE];
+    float buffer[SYNCHROPHASOR_MAX_WINDOW_SIZE] __attribute__((aligned(16)));
+    float window[SYNCHROPHASOR_MAX_WINDOW_SIZE] __attribute__((aligned(16)));
+    size_t window_size;
+    size_t window_function_size;        // Length the Hann window was last computed for
+    float window_sum;
+    int64_t last_sample_us;             // UTC time of the newest sample in the window
+    synchrophasor_measurement_t pending;
+} synchrophasor_t;
+
+// Error codes
+typedef enum {
+    SYNCHROPHASOR_OK = 0,
+    SYNCHROPHASOR_ERROR_INIT = -1,
+    SYNCHROPHASOR_ERROR_BUSY = -2,
+    SYNCHROPHASOR_ERROR_INVALID_PARAM = -3
+} synchrophasor_error_t;
+
+// Function prototypes
+synchrophasor_error_t synchrophasor_init(synchrophasor_t *sp, uint32_t rate, uint32_t nominal_frequency);
+void synchrophasor_deinit(synchrophasor_t *sp);
+synchrophasor_error_t synchrophasor_set_rate(synchrophasor_t *sp, uint32_t rate);
+void synchrophasor_set_queue(synchrophasor_t *sp, QueueHandle_t output_queue);
+
+// True once the sample at sample_us (UTC) reaches the next reporting instant, or the clock stepped back
+static inline bool synchrophasor_due(const synchrophasor_t *sp, int64_t sample_us) {
+    return sample_us >= sp->next_report_us || sp->next_report_us - sample_us > sp->period_us;
+}
+
+// Hand the window ending at the newest waveform sample to the estimation task and schedule the next report
+synchrophasor_error_t synchrophasor_submit(synchrophasor_t *sp, const waveform_estimator_t *wf, int64_t sample_us,
+                                           float frequency, float rocof, float voltage_rms, uint16_t stat, uint8_t time_quality);
+
+// C37.118 frame encoding (big-endian, CRC-CCITT), both return the frame length or 0 if it does not fit
+size_t synchrophasor_encode_data_frame(const synchrophasor_measurement_t *measurement, uint16_t idcode, uint8_t *buffer, size_t size);
+size_t synchrophasor_encode_config_frame(uint16_t idcode, const char *station_name, uint32_t rate,
+                                         uint32_t nominal_frequency, int64_t timestamp_us, uint8_t *buffer, size_t size);
+uint16_t synchrophasor_crc_ccitt(const uint8_t *data, size_t length);
@@ -0,0 +1,158 @@
+#include "waveform.h"
+#include "dsp.h"
+#include <string.h>
+#include <math.h>
+
+#define WAVEFORM_RING_MASK (WAVEFORM_RING_SIZE - 1)
+
+// Sample at absolute index
+static inline int32_t waveform_sample_at(const waveform_estimator_t *wf, uint32_t index) {
+    return wf->samples[index & WAVEFORM_RING_MASK];
+}
+
+// Initialize the estimator and its reference tables for a window of two nominal cycles
+void waveform_init(waveform_estimator_t *wf, float nominal_frequency) {
+    memset(wf, 0, sizeof(waveform_estimator_t));
+    
+    wf->window_size = (uint32_t)lround(WAVEFORM_DFT_CYCLES * WAVEFORM_SAMPLE_RATE_HZ / nominal_frequency);
+    if (wf->window_size > WAVEFORM_DFT_MAX_WINDOW_SIZE) {
+        wf->window_size = WAVEFORM_DFT_MAX_WINDOW_SIZE;
+    }
+    
+    for (uint32_t n = 0; n < wf->window_size; n++) {
+        double hann = 0.5 - 0.5 * cos(2.0 * M_PI * n / wf->window_size);
+        double angle = 2.0 * M_PI * nominal_frequency * n / WAVEFORM_SAMPLE_RATE_HZ;
+        wf->ref_cos[n] = (float)(hann * cos(angle));
+        wf->ref_sin[n] = (float)(hann * sin(angle));
+    }
+    
+    waveform_reset(wf);
+}
+
+// Forget all history, e.g. after samples were lost
+void waveform_reset(waveform_estimator_t *wf) {
+    wf->fill = 0;
+    wf->zc_armed = false;
+    wf->hysteresis = WAVEFORM_MIN_AMPLITUDE / WAVEFORM_HYSTERESIS_DIVIDER;
+    wf->cycle_peak = 0;
+    wf->have_crossing = false;
+    wf->have_phase = false;
+}
+
+// Phase of the fundamental over the window ending at end_index (inclusive)
+static double waveform_window_phase(waveform_estimator_t *wf, uint32_t end_index) {
+    uint32_t start = end_index + 1 - wf->window_size;
+    
+    for (uint32_t n = 0; n < wf->window_size; n++) {
+        wf->window[n] = (float)waveform_sample_at(wf, start + n);
+    }
+    
+    float re = dsp_dotprod(wf->window, wf->ref_cos, wf->window_size);
+    float im = -dsp_dotprod(wf->window, wf->ref_sin, wf->window_size);
+    
+    return atan2((double)im, (double)re);
+}
+
+// Frequency from the phase advance between this window and the previous one.
+// The advance is 2*pi*f*M/fs modulo 2*pi; the zero-crossing estimate picks the right turn count.
+static bool waveform_phase_frequency(waveform_estimator_t *wf, uint32_t end_index, double zc_frequency, double *frequency) {
+    double phase = waveform_window_phase(wf, end_index);
+    bool valid = false;
+    
+    if (wf->have_phase) {
+        double m = (double)(end_index - wf->last_phase_index);
+        double advance = phase - wf->last_phase;
+        double expected = 2.0 * M_PI * zc_frequency * m / WAVEFORM_SAMPLE_RATE_HZ;
+        advance += 2.0 * M_PI * round((expected - advance) / (2.0 * M_PI));
+    
+        *frequency = advance * WAVEFORM_SAMPLE_RATE_HZ / (2.0 * M_PI * m);
+        valid = true;
+    }
+    
+    wf->last_phase = phase;
+    wf->last_phase_index = end_index;
+    wf->have_phase = true;
+    return valid;
+}
+
+// Add one sample; returns true and fills cycle when it completes a line cycle
+bool waveform_push_sample(waveform_estimator_t *wf, int32_t sample, waveform_cycle_t *cycle) {
+    uint32_t index = wf->sample_count++;
+    wf->samples[index & WAVEFORM_RING_MASK] = sample;
+    if (wf->fill < WAVEFORM_RING_SIZE) {
+        wf->fill++;
+    }
+    
+    int32_t magnitude = sample < 0 ? -sample : sample;
+    if (magnitude > wf->cycle_peak) {
+        wf->cycle_peak = magnitude;
+    }
+    
+    if (wf->fill < 2) {
+        return false;
+    }
+    
+    // Hysteresis: only a rise that follows a real negative half cycle counts as a crossing
+    if (sample < -wf->hysteresis) {
+        wf->zc_armed = true;
+        return false;
+    }
+    
+    int32_t previous = waveform_sample_at(wf, index - 1);
+    if (!wf->zc_armed || previous >= 0 || sample < 0) {
+        return false;
+    }
+    wf->zc_armed = false;
+    
+    // Linear interpolation between the two samples that straddle zero
+    float fraction = (float)sample / (float)(sample - previous);   // Distance of the crossing before this sample
+    
+    int32_t peak = wf->cycle_peak;
+    wf->cycle_peak = 0;
+    wf->hysteresis = (peak > WAVEFORM_MIN_AMPLITUDE ? peak : WAVEFORM_MIN_AMPLITUDE) / WAVEFORM_HYSTERESIS_DIVIDER;
+    
+    bool had_crossing = wf->have_crossing;
+    uint32_t last_index = wf->last_crossing_index;
+    float last_fraction = wf->last_crossing_fraction;
+    wf->have_crossing = true;
+    wf->last_crossing_index = index;
+    wf->last_crossing_fraction = fraction;
+    
+    if (!had_crossing || peak < WAVEFORM_MIN_AMPLITUDE) {
+        wf->have_phase = false;
+        return false;
+    }
+    
+    double period = (double)(index - last_index) - fraction + last_fraction;
+    double zc_frequency = WAVEFORM_SAMPLE_RATE_HZ / period;
+    if (zc_frequency < WAVEFORM_MIN_FREQUENCY_HZ || zc_frequency > WAVEFORM_MAX_FREQUENCY_HZ) {
+        wf->have_phase = false;
+        return false;
+    }
+    
+    double frequency = zc_frequency;
+    bool dft_valid = false;
+    if (wf->fill >= wf->window_size) {
+        dft_valid = waveform_phase_frequency(wf, index, zc_frequency, &frequency);
+    }
+    
+    cycle->frequency = (float)frequency;
+    cycle->zc_frequency = (float)zc_frequency;
+    cycle->samples_since_crossing = fraction;
+    cycle->peak = peak;
+    cycle->dft_valid = dft_valid;
+    return true;
+}
+
+// Copy the newest n samples (oldest first), returns the number copied
+size_t waveform_copy_latest(const waveform_estimator_t *wf, int32_t *dst, size_t n) {
+    if (n > wf->fill) {
+        n = wf->fill;
+    }
+    
+    uint32_t start = wf->sample_count - n;
+    for (size_t i = 0; i < n; i++) {
+        dst[i] = waveform_sample_at(wf, start + i);
+    }
+    return n;
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Sampling configuration (ADE7953 waveform registers update at CLKIN/512)
+#define WAVEFORM_CLKIN_HZ               3579545.0
+#define WAVEFORM_SAMPLE_RATE_HZ         (WAVEFORM_CLKIN_HZ / 512.0)   // 6991.3 Hz
+#define WAVEFORM_SAMPLE_PERIOD_US       (1000000.0 / WAVEFORM_SAMPLE_RATE_HZ)
+
+// Ring buffer of raw voltage samples (power of two)
+#define WAVEFORM_RING_SIZE              2048    // ~293 ms of waveform
+
+// Phase-based DFT estimator
+// A Hann window spanning exactly two nominal cycles puts the negative-frequency image and every
+// harmonic on a window null, so the fundamental phase is not pulled by them.
+#define WAVEFORM_DFT_CYCLES             2
+#define WAVEFORM_DFT_MAX_WINDOW_SIZE    280     // Two cycles at 50 Hz, the lowest nominal frequency (233 at 60 Hz)
+
+// Zero-crossing detection
+#define WAVEFORM_MIN_AMPLITUDE          500000  // Peak below this (in LSB, ~20 V) is treated as no signal
+#define WAVEFORM_HYSTERESIS_DIVIDER     8       // Re-arm only after the signal falls below -peak/8
+#define WAVEFORM_MIN_FREQUENCY_HZ       40.0
+#define WAVEFORM_MAX_FREQUENCY_HZ       70.0
+
+// One completed line cycle (positive-going zero crossing to positive-going zero crossing)
+typedef struct {
+    float frequency;            // Best estimate: phase-based DFT, or zero-crossing when the DFT is not ready yet
+    float zc_frequency;         // From linearly interpolated zero crossings
+    float samples_since_crossing; // How long before the newest sample the crossing occurred, in samples
+    int32_t peak;               // Largest absolute sample of the cycle
+    bool dft_valid;             // True if frequency comes from the DFT estimator
+} waveform_cycle_t;
+
+// Estimator state (about 11 KB, keep it off the stack)
+typedef struct {
+    int32_t samples[WAVEFORM_RING_SIZE];
+    uint32_t sample_count;      // Index of the next sample (wraps after ~7 days)
+    uint32_t fill;              // Samples pushed since the last reset, saturates at WAVEFORM_RING_SIZE
+    
+    // Hann-weighted reference oscillator at the nominal frequency, plus the unwrapped window
+    // (16-byte aligned for the vector dot product)
+    float ref_cos[WAVEFORM_DFT_MAX_WINDOW_SIZE] __attribute__((aligned(16)));
+    float ref_sin[WAVEFORM_DFT_MAX_WINDOW_SIZE] __attribute__((aligned(16)));
+    float window[WAVEFORM_DFT_MAX_WINDOW_SIZE] __attribute__((aligned(16)));
+    uint32_t window_size;       // round(WAVEFORM_DFT_CYCLES * WAVEFORM_SAMPLE_RATE_HZ / nominal frequency)
+    
+    // Zero-crossing state
+    bool zc_armed;              // Signal went below -hysteresis since the last crossing
+    int32_t hysteresis;
+    int32_t cycle_peak;
+    bool have_crossing;
+    uint32_t last_crossing_index;   // Sample index just after the last crossing
+    float last_crossing_fraction;   // Crossing position before that sample, 0..1
+    
+    // Phase-based DFT state
+    bool have_phase;
+    double last_phase;          // Phase of the window ending at last_phase_index
+    uint32_t last_phase_index;
+} waveform_estimator_t;
+
+// Function prototypes
+void waveform_init(waveform_estimator_t *wf, float nominal_frequency);
+void waveform_reset(waveform_estimator_t *wf);
+
+// Add one sample; returns true and fills cycle when it completes a line cycle
+bool waveform_push_sample(waveform_estimator_t *wf, int32_t sample, waveform_cycle_t *cycle);
+
+// Copy the newest n samples (oldest first), returns the number copied
+size_t waveform_copy_latest(const waveform_estimator_t *wf, int32_t *dst, size_t n);
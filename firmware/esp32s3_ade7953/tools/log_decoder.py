@@ -0,0 +1,339 @@
+#!/usr/bin/env python3
+"""
+Grid Frequency Monitor - Binary Log Decoder
+Expands the deferred log records published on
+open_grid_monitor/{device_id}/logs/binary/{level} (see main/binlog.h), and those kept
+across a reset on open_grid_monitor/{device_id}/logs/crash/binary, back into ESP-IDF
+style log lines.
+
+A record holds only the address of its call site's descriptor, a timestamp and the
+raw arguments. The firmware ELF is the table from that address to the format string,
+tag, file and line, so the decoder needs the ELF of the build that is running (the
+payload carries the first bytes of its SHA-256 and a mismatch is reported), or a
+table exported from it with --export.
+
+Can be imported (SiteTable, decode_payload, format_record) or run as a tool:
+  - print the decoded lines of live payloads or of payload files
+  - --list: print every log site found in the ELF
+  - --export: write the site table as JSON, to decode without the ELF later
+"""
+
+import sys
+import os
+import re
+import json
+import struct
+import hashlib
+import argparse
+
+
+BASE_TOPIC = "open_grid_monitor"
+BINARY_LOG_TOPIC = f"{BASE_TOPIC}/+/logs/binary/+"
+CRASH_BINARY_LOG_TOPIC = f"{BASE_TOPIC}/+/logs/crash/binary"
+
+MAGIC = b"BL"
+HEADER = struct.Struct("<2sB4s")        # magic, version, first 4 bytes of the ELF SHA-256
+RECORD = struct.Struct("<IIB")          # site address, esp_log_timestamp() ms, argument length
+SITE = struct.Struct("<IBxHIII")        # binlog_site_t: magic, level, line, &TAG, format, file
+SUPPORTED_VERSIONS = (1,)
+SITE_MAGIC = 0x53474C42
+ARGS_TRUNCATED = 0x80
+LEVEL_LETTERS = {1: "E", 2: "W", 3: "I", 4: "D", 5: "V"}
+
+# A printf conversion as binlog_put_arguments() walks it
+CONVERSION = re.compile(r"%(?P<flags>[-+ #0]*)(?P<width>\*|\d+)?(?:\.(?P<precision>\*|\d*))?"
+                        r"(?P<length>[hlLqjzt]*)(?P<conversion>[diouxXcpfFeEgGaAs%])")
+
+ELF_HEADER = struct.Struct("<16sHHIIIIIHHHHHH")
+SECTION_HEADER = struct.Struct("<IIIIIIIIII")
+SHF_ALLOC = 0x2
+SHT_NOBITS = 8
+
+
+class LogError(ValueError):
+    pass
+
+
+class ElfImage:
+    """Initialized contents of a 32-bit little-endian ELF, addressed like the target's memory."""
+
+    def __init__(self, path):
+        with open(path, "rb") as f:
+            self.data = f.read()
+        self.sha256_prefix = hashlib.sha256(self.data).digest()[:4]
+
+        ident, _, _, _, _, _, shoff, _, _, _, _, shentsize, shnum, _ = ELF_HEADER.unpack_from(self.data)
+        if ident[:4] != b"\x7fELF" or ident[4] != 1 or ident[5] != 1:
+            raise LogError(f"{path}: not a 32-bit little-endian ELF")
+        self.sections = []
+        for i in range(shnum):
+            _, kind, flags, address, offset, size, _, _, _, _ = SECTION_HEADER.unpack_from(self.data, shoff + i * shentsize)
+            if flags & SHF_ALLOC and kind != SHT_NOBITS and size:
+                self.sections.append((address, size, offset))
+
+    def read(self, address, length):
+        for start, size, offset in self.sections:
+            if start <= address and address + length <= start + size:
+                return self.data[offset + address - start:offset + address - start + length]
+        raise LogError(f"address 0x{address:08x} is not in the ELF")
+
+    def u32(self, address):
+        return struct.unpack("<I", self.read(address, 4))[0]
+
+    def string(self, address):
+        for start, size, offset in self.sections:
+            if start <= address < start + size:
+                begin = offset + address - start
+                end = self.data.find(b"\0", begin, offset + size)
+                if end < 0:
+                    break
+                return self.data[begin:end].decode("utf-8", "replace")
+        raise LogError(f"no string at 0x{address:08x}")
+
+
+class SiteTable:
+    """Site address -> level, tag, format, file and line, from the ELF or from an exported table."""
+
+    def __init__(self, elf=None, sites=None, sha256_prefix=None):
+        self.elf = elf
+        self.sites = sites if sites is not None else {}
+        self.sha256_prefix = elf.sha256_prefix if elf else sha256_prefix
+
+    @classmethod
+    def from_elf(cls, path):
+        return cls(elf=ElfImage(path))
+
+    @classmethod
+    def from_json(cls, path):
+        with open(path) as f:
+            table = json.load(f)
+        sites = {int(address, 0): site for address, site in table["sites"].items()}
+        return cls(sites=sites, sha256_prefix=bytes.fromhex(table["elf_sha256_prefix"]))
+
+    def site(self, address):
+        if address not in self.sites:
+            if not self.elf:
+                raise LogError(f"unknown log site 0x{address:08x}")
+            magic, level, line, tag, fmt, file = SITE.unpack(self.elf.read(address, SITE.size))
+            if magic != SITE_MAGIC:
+                raise LogError(f"no log site at 0x{address:08x}, wrong ELF?")
+            self.sites[address] = {"level": level, "tag": self.elf.string(self.elf.u32(tag)),
+                                   "format": self.elf.string(fmt), "file": self.elf.string(file), "line": line}
+        return self.sites[address]
+
+    def scan(self):
+        """Every site descriptor in the ELF, found by its magic on 4-byte boundaries."""
+        magic = struct.pack("<I", SITE_MAGIC)
+        for start, size, offset in self.elf.sections:
+            position = self.elf.data.find(magic, offset, offset + size)
+            while position >= 0:
+                if (position - offset) % 4 == 0:
+                    try:
+                        self.site(start + position - offset)
+                    except (LogError, struct.error):
+                        pass
+                position = self.elf.data.find(magic, position + 1, offset + size)
+        return self.sites
+
+    def export(self, path):
+        self.scan()
+        table = {"elf_sha256_prefix": self.sha256_prefix.hex(),
+                 "sites": {f"0x{address:08x}": site for address, site in sorted(self.sites.items())}}
+        with open(path, "w") as f:
+            json.dump(table, f, indent=2)
+        return len(self.sites)
+
+
+def decode_payload(payload, table):
+    """Header and records of one payload; a record's args are the raw argument bytes."""
+    if len(payload) < HEADER.size:
+        raise LogError("payload shorter than its header")
+    magic, version, sha256_prefix = HEADER.unpack_from(payload)
+    if magic != MAGIC:
+        raise LogError("bad magic")
+    if version not in SUPPORTED_VERSIONS:
+        raise LogError(f"unsupported version {version}")
+
+    records = []
+    position = HEADER.size
+    while position < len(payload):
+        if position + RECORD.size > len(payload):
+            raise LogError("record cut short")
+        address, timestamp, argument_length = RECORD.unpack_from(payload, position)
+        position += RECORD.size
+        length = argument_length & ~ARGS_TRUNCATED
+        if position + length > len(payload):
+            raise LogError("arguments cut short")
+        records.append({"site": table.site(address), "timestamp": timestamp,
+                        "args": payload[position:position + length],
+                        "truncated": bool(argument_length & ARGS_TRUNCATED)})
+        position += length
+
+    header = {"version": version, "elf_match": table.sha256_prefix is None or sha256_prefix == table.sha256_prefix}
+    return header, records
+
+
+def format_record(record):
+    """The log text the device would have printed, '?' for arguments that did not fit the record."""
+    args, position = record["args"], 0
+
+    def take(size, fmt):
+        nonlocal position
+        if position + size > len(args):
+            raise IndexError
+        value = struct.unpack_from(fmt, args, position)[0]
+        position += size
+        return value
+
+    def take_string():
+        nonlocal position
+        if position >= len(args):
+            raise IndexError
+        length = args[position]
+        value = args[position + 1:position + 1 + length].decode("utf-8", "replace")
+        position += 1 + length
+        return value
+
+    def expand(match):
+        conversion = match["conversion"]
+        if conversion == "%":
+            return "%"
+        try:
+            width = str(take(4, "<i")) if match["width"] == "*" else (match["width"] or "")
+            precision = match["precision"]
+            if precision == "*":
+                precision = str(take(4, "<i"))
+            spec = "%" + match["flags"] + width + ("." + precision if precision is not None else "")
+
+            length = match["length"]
+            wide = length.count("l") >= 2 or any(c in length for c in "qjL")
+            if conversion in "di":
+                return (spec + "d") % take(*((8, "<q") if wide else (4, "<i")))
+            if conversion in "ouxX":
+                return (spec + ("d" if conversion == "u" else conversion)) % take(*((8, "<Q") if wide else (4, "<I")))
+            if conversion == "c":
+                return (spec + "c") % (take(*((8, "<Q") if wide else (4, "<I"))) & 0xFF)
+            if conversion == "p":
+                return f"0x{take(4, '<I'):x}"
+            if conversion in "aA":
+                value = float.hex(take(8, "<d"))
+                return (spec + "s") % (value.upper() if conversion == "A" else value)
+            if conversion == "s":
+                return (spec + "s") % take_string()
+            return (spec + conversion) % take(8, "<d")
+        except IndexError:
+            return "?"
+
+    text = CONVERSION.sub(expand, record["site"]["format"])
+    return text + (" [truncated]" if record["truncated"] else "")
+
+
+def format_line(record):
+    site = record["site"]
+    return f"{LEVEL_LETTERS.get(site['level'], '?')} ({record['timestamp']}) {site['tag']}: {format_record(record)}"
+
+
+def print_payload(table, payload, source, mismatched):
+    try:
+        header, records = decode_payload(payload, table)
+    except LogError as e:
+        print(f"{source}: {e}", file=sys.stderr)
+        return
+    if not header["elf_match"] and source not in mismatched:
+        mismatched.add(source)
+        print(f"{source}: payloads are from a different build than the ELF or table", file=sys.stderr)
+    for record in records:
+        print(f"{source} {format_line(record)}")
+
+
+def decode_files(paths, table):
+    mismatched = set()
+    for path in paths:
+        with open(path, "rb") as f:
+            print_payload(table, f.read(), path, mismatched)
+    return 0
+
+
+def load_mqtt_settings(args):
+    broker, port, username, password = args.broker, args.port, None, None
+    try:
+        from dotenv import load_dotenv
+        if load_dotenv():
+            broker = os.environ.get("MQTT_BROKER", broker)
+            port = int(os.environ.get("MQTT_PORT", port))
+            username = os.environ.get("MQTT_USERNAME")
+            password = os.environ.get("MQTT_PASSWORD")
+    except ImportError:
+        pass
+    return broker, port, username, password
+
+
+def run_mqtt(args, table):
+    try:
+        import paho.mqtt.client as mqtt
+    except ImportError:
+        print("Error: paho-mqtt library not found. Install with: pip install paho-mqtt", file=sys.stderr)
+        return 1
+
+    broker, port, username, password = load_mqtt_settings(args)
+    mismatched = set()
+
+    def on_connect(client, userdata, flags, rc):
+        client.subscribe([(BINARY_LOG_TOPIC, 0), (CRASH_BINARY_LOG_TOPIC, 1)])
+        print(f"Subscribed to {BINARY_LOG_TOPIC} and {CRASH_BINARY_LOG_TOPIC} on {broker}:{port}", file=sys.stderr)
+
+    def on_message(client, userdata, msg):
+        print_payload(table, msg.payload, msg.topic.split("/")[1], mismatched)
+
+    client = mqtt.Client()
+    if username:
+        client.username_pw_set(username, password)
+    client.on_connect = on_connect
+    client.on_message = on_message
+    client.connect(broker, port, 60)
+
+    try:
+        client.loop_forever()
+    except KeyboardInterrupt:
+        pass
+    finally:
+        client.disconnect()
+    return 0
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Decoder for Grid Frequency Monitor binary log records")
+    parser.add_argument("files", nargs="*", help="Payload files to decode (raw MQTT payloads); omit to subscribe")
+    parser.add_argument("--elf", help="Firmware ELF of the running build (build/open-grid-monitor.elf)")
+    parser.add_argument("--table", help="Site table exported with --export, instead of the ELF")
+    parser.add_argument("--export", metavar="FILE", help="Write the site table of --elf as JSON and exit")
+    parser.add_argument("--list", action="store_true", help="List the log sites of --elf and exit")
+    parser.add_argument("--broker", default="localhost", help="MQTT broker (default: localhost, or MQTT_BROKER in .env)")
+    parser.add_argument("--port", type=int, default=1883, help="MQTT port (default: 1883)")
+    args = parser.parse_args()
+
+    if bool(args.elf) == bool(args.table):
+        parser.error("give exactly one of --elf and --table")
+    try:
+        table = SiteTable.from_elf(args.elf) if args.elf else SiteTable.from_json(args.table)
+        if args.export or args.list:
+            if not args.elf:
+                parser.error("--export and --list need --elf")
+            if args.export:
+                print(f"{table.export(args.export)} log sites written to {args.export}")
+            else:
+                for address, site in sorted(table.scan().items()):
+                    print(f"0x{address:08x} {LEVEL_LETTERS.get(site['level'], '?')} {site['tag']} "
+                          f"{os.path.basename(site['file'])}:{site['line']} {site['format']!r}")
+            return 0
+    except (OSError, LogError) as e:
+        print(f"Error: {e}", file=sys.stderr)
+        return 1
+
+    if args.files:
+        return decode_files(args.files, table)
+    return run_mqtt(args, table)
+
+
+if __name__ == "__main__":
+    sys.exit(main())
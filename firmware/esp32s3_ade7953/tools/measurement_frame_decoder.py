@@ -0,0 +1,437 @@
+#!/usr/bin/env python3
+"""
+Grid Frequency Monitor - Measurement Frame Decoder
+Unpacks the binary batched measurement frames published on
+open_grid_monitor/{device_id}/measurement/frame (see main/measurement_frame.h),
+and the frames spooled to flash during an outage and replayed on
+open_grid_monitor/{device_id}/measurement/backfill after it.
+
+Can be imported (decode_frame) or run as a tool:
+  - print the decoded samples of live frames or of frame files
+  - benchmark: size and decode time of columnar frames against one JSON message per sample
+  - bridge: republish every frame as one JSON array on .../measurement, which the
+    existing Telegraf json input turns into one grid_data point per sample
+
+Frames carry raw register codes, the acquisition sequence number of every sample
+and the ID of the calibration set they were taken under. Gaps in the sample
+sequence are reported, so a loss anywhere between acquisition and here shows up;
+the device's own loss counters by cause are on .../system. The units are computed here, with the factors sent in the frame unless
+--calibration supplies corrected ones for that ID, so a recalibration can be
+applied to stored frames (or to the codes kept in InfluxDB) after the fact.
+"""
+
+import sys
+import os
+import json
+import struct
+import argparse
+import random
+import time
+
+BASE_TOPIC = "open_grid_monitor"
+FRAME_TOPIC = f"{BASE_TOPIC}/+/measurement/frame"
+BACKFILL_TOPIC = f"{BASE_TOPIC}/+/measurement/backfill"
+
+MAGIC = b"OG"
+HEADER = struct.Struct("<2sBB6sHIq")    # magic, version, encoding, device MAC, count, sequence, base timestamp
+PACKED_SAMPLE = struct.Struct("<Iff")   # offset us, frequency, voltage
+COLUMNAR_HEADER_V1 = struct.Struct("<Bff")  # frequency unit, period clock Hz, volts per VRMS LSB
+COLUMNAR_HEADER_V2 = struct.Struct("<BBff") # frequency unit, calibration ID, period clock Hz, volts per VRMS LSB
+COLUMNAR_HEADER = struct.Struct("<BBffI")   # the same and the sequence number of the first sample
+SUPPORTED_VERSIONS = (1, 2, 3)
+FRAME_VERSION = 3
+ENCODING_PACKED = 0
+ENCODING_COLUMNAR = 1
+FREQUENCY_UNIT_PERIOD = 0
+FREQUENCY_UNIT_MICROHERTZ = 1
+JSON_FREQUENCY_TOLERANCE = 0.5e-6 + 1e-12    # The firmware writes 6 and 3 decimals
+JSON_VOLTAGE_TOLERANCE = 0.5e-3 + 1e-9
+
+
+class FrameError(ValueError):
+    pass
+
+
+def f32(value):
+    """Round to float32. Doing one float32 operation in double and rounding gives the exact float32 result."""
+    return struct.unpack("<f", struct.pack("<f", value))[0]
+
+
+def read_varint(payload, position):
+    value = shift = 0
+    while True:
+        if position >= len(payload):
+            raise FrameError("truncated varint")
+        byte = payload[position]
+        position += 1
+        value |= (byte & 0x7F) << shift
+        if byte < 0x80:
+            return value, position
+        shift += 7
+
+
+def unzigzag(value):
+    return (value >> 1) ^ -(value & 1)
+
+
+def write_varint(out, value):
+    while value >= 0x80:
+        out.append((value & 0x7F) | 0x80)
+        value >>= 7
+    out.append(value)
+
+
+def zigzag(value):
+    return value << 1 if value >= 0 else (-value << 1) - 1
+
+
+def decode_packed(payload, count, base_us):
+    expected = HEADER.size + count * PACKED_SAMPLE.size
+    if len(payload) != expected:
+        raise FrameError(f"length {len(payload)} does not match {count} samples ({expected} bytes)")
+    return [
+        {"timestamp": base_us + offset_us, "frequency": frequency, "voltage": voltage}
+        for offset_us, frequency, voltage in PACKED_SAMPLE.iter_unpack(payload[HEADER.size:])
+    ]
+
+
+def load_calibrations(path):
+    """JSON object of calibration ID -> {"period_clock": Hz, "volts_per_lsb": V}, overriding the frame factors."""
+    with open(path) as f:
+        table = json.load(f)
+    return {int(calibration_id): (f32(entry["period_clock"]), f32(entry["volts_per_lsb"]))
+            for calibration_id, entry in table.items()}
+
+
+def decode_columnar(payload, count, base_us, version=FRAME_VERSION, calibrations=None):
+    columnar_header = {1: COLUMNAR_HEADER_V1, 2: COLUMNAR_HEADER_V2}.get(version, COLUMNAR_HEADER)
+    if len(payload) < HEADER.size + columnar_header.size:
+        raise FrameError("columnar header missing")
+    calibration_id = first_sequence = None
+    if version >= 3:
+        unit, calibration_id, period_clock, volts_per_lsb, first_sequence = columnar_header.unpack_from(payload, HEADER.size)
+    elif version == 2:
+        unit, calibration_id, period_clock, volts_per_lsb = columnar_header.unpack_from(payload, HEADER.size)
+    else:
+        unit, period_clock, volts_per_lsb = columnar_header.unpack_from(payload, HEADER.size)
+    if calibrations and calibration_id in calibrations:
+        period_clock, volts_per_lsb = calibrations[calibration_id]
+    position = HEADER.size + columnar_header.size
+
+    # Sample sequence numbers: consecutive except at the listed gaps
+    sequences = [None] * count
+    if first_sequence is not None:
+        missing = [0] * count
+        gap_count, position = read_varint(payload, position)
+        index = 0
+        for _ in range(gap_count):
+            index_delta, position = read_varint(payload, position)
+            skipped, position = read_varint(payload, position)
+            index += index_delta
+            if not 0 < index < count:
+                raise FrameError(f"sequence gap at sample {index} of {count}")
+            missing[index] = skipped
+        sequence = first_sequence
+        for i in range(count):
+            if i > 0:
+                sequence = (sequence + 1 + missing[i]) & 0xFFFFFFFF
+            sequences[i] = sequence
+
+    columns = []
+    for _ in range(3):
+        column = []
+        for _ in range(count):
+            value, position = read_varint(payload, position)
+            column.append(unzigzag(value))
+        columns.append(column)
+    if position != len(payload):
+        raise FrameError(f"{len(payload) - position} trailing bytes")
+
+    samples = []
+    timestamp = base_us
+    delta = frequency_code = voltage_code = 0
+    for delta_change, frequency_delta, voltage_delta, sequence in zip(*columns, sequences):
+        delta += delta_change
+        timestamp += delta
+        frequency_code += frequency_delta
+        voltage_code += voltage_delta
+
+        # Same float32 arithmetic as the firmware
+        if unit == FREQUENCY_UNIT_PERIOD:
+            frequency = f32(period_clock / f32(frequency_code)) if frequency_code else 0.0
+        elif unit == FREQUENCY_UNIT_MICROHERTZ:
+            frequency = f32(frequency_code / 1e6)
+        else:
+            raise FrameError(f"unknown frequency unit {unit}")
+        voltage = f32(f32(voltage_code) * volts_per_lsb)
+
+        samples.append({
+            "timestamp": timestamp,
+            "sequence": sequence,
+            "frequency": frequency,
+            "voltage": voltage,
+            "frequency_code": frequency_code,
+            "voltage_code": voltage_code,
+            "calibration_id": calibration_id,
+        })
+    return samples
+
+
+def encode_columnar_frame(device_id, sequence, samples, unit=FREQUENCY_UNIT_MICROHERTZ, calibration_id=1,
+                          period_clock=223750.0, volts_per_lsb=0.00003879):
+    """Reference encoder, byte-identical to measurement_frame_finish() for the same input.
+    samples are (timestamp_us, frequency_code, voltage_code, sample_sequence) tuples."""
+    out = bytearray(HEADER.pack(MAGIC, FRAME_VERSION, ENCODING_COLUMNAR, bytes.fromhex(device_id),
+                                len(samples), sequence, samples[0][0]))
+    out += COLUMNAR_HEADER.pack(unit, calibration_id, period_clock, volts_per_lsb, samples[0][3])
+
+    gaps = [(i, (samples[i][3] - samples[i - 1][3] - 1) & 0xFFFFFFFF)
+            for i in range(1, len(samples)) if (samples[i][3] - samples[i - 1][3]) & 0xFFFFFFFF != 1]
+    write_varint(out, len(gaps))
+    previous_gap = 0
+    for index, skipped in gaps:
+        write_varint(out, index - previous_gap)
+        write_varint(out, skipped)
+        previous_gap = index
+
+    previous_delta = 0
+    for i, (timestamp, _, _, _) in enumerate(samples):
+        delta = timestamp - samples[i - 1][0] if i > 0 else 0
+        write_varint(out, zigzag(delta - previous_delta))
+        previous_delta = delta
+    for column in (1, 2):
+        previous = 0
+        for sample in samples:
+            write_varint(out, zigzag(sample[column] - previous))
+            previous = sample[column]
+    return bytes(out)
+
+
+def decode_frame(payload, calibrations=None):
+    """Decode one frame into (header dict, list of sample dicts with absolute UTC timestamps in us).
+    calibrations optionally maps calibration IDs to corrected (period clock, volts per LSB) factors."""
+    if len(payload) < HEADER.size:
+        raise FrameError(f"frame too short ({len(payload)} bytes)")
+
+    magic, version, encoding, device, count, sequence, base_us = HEADER.unpack_from(payload)
+    if magic != MAGIC:
+        raise FrameError(f"bad magic {magic!r}")
+    if version not in SUPPORTED_VERSIONS:
+        raise FrameError(f"unsupported version {version}")
+    if encoding == ENCODING_PACKED:
+        samples = decode_packed(payload, count, base_us)
+    elif encoding == ENCODING_COLUMNAR:
+        samples = decode_columnar(payload, count, base_us, version, calibrations)
+    else:
+        raise FrameError(f"unsupported encoding {encoding}")
+
+    header = {
+        "version": version,
+        "encoding": encoding,
+        "device_id": device.hex(),
+        "sample_count": count,
+        "sequence": sequence,
+        "base_timestamp": base_us,
+    }
+    return header, samples
+
+
+class SequenceTracker:
+    """Counts what is missing from per-device sequence numbers, of frames or of samples."""
+
+    def __init__(self):
+        self.last = {}
+        self.lost = {}
+
+    def update(self, device_id, sequence, last=None):
+        """sequence is the first of the next run and last (default: the same) its end; gaps inside a run go to add()."""
+        lost = 0
+        if device_id in self.last:
+            lost = (sequence - self.last[device_id] - 1) & 0xFFFFFFFF
+            if lost > 0x7FFFFFFF:
+                lost = 0    # Device restarted or frames reordered
+        self.last[device_id] = sequence if last is None else last
+        self.lost[device_id] = self.lost.get(device_id, 0) + lost
+        return lost
+
+    def add(self, device_id, lost):
+        self.lost[device_id] = self.lost.get(device_id, 0) + lost
+        return lost
+
+
+def print_frame(header, samples):
+    print(f"{header['device_id']} seq={header['sequence']} samples={header['sample_count']} "
+          f"base={header['base_timestamp']}")
+    for sample in samples:
+        sequence = f"#{sample['sequence']} " if sample.get("sequence") is not None else ""
+        print(f"  {sequence}{sample['timestamp']} {sample['frequency']:.4f} Hz {sample['voltage']:.2f} V")
+
+
+def decode_files(paths, calibrations=None):
+    status = 0
+    for path in paths:
+        with open(path, "rb") as f:
+            payload = f.read()
+        try:
+            print_frame(*decode_frame(payload, calibrations))
+        except FrameError as e:
+            print(f"{path}: {e}", file=sys.stderr)
+            status = 1
+    return status
+
+
+def benchmark(frames, samples_per_frame=50):
+    """Round trip of synthetic waveform-mode seconds: columnar frame against per-sample JSON messages."""
+    rng = random.Random(1)
+    seconds = []
+    sample_sequence = -1
+    for n in range(frames):
+        timestamp = 1760000000000000 + n * 1000000
+        frequency_code, voltage_code = 50000000, 5930000
+        samples = []
+        for _ in range(samples_per_frame):
+            timestamp += 20000 + rng.randint(-20, 20)
+            frequency_code += rng.randint(-2000, 2000)
+            voltage_code += rng.randint(-4000, 4000)
+            sample_sequence += 1 + (rng.randint(1, 3) if rng.random() < 0.01 else 0)    # The odd lost sample
+            samples.append((timestamp, frequency_code, voltage_code, sample_sequence))
+        seconds.append(samples)
+
+    payloads = [encode_columnar_frame("000000000000", n, samples) for n, samples in enumerate(seconds)]
+    messages = []
+    for samples in seconds:
+        for timestamp, frequency_code, voltage_code, sample_sequence in samples:
+            # Same fields and precision the firmware JSON path sends (json_writer, compact, µHz and mV)
+            frequency, voltage = f32(frequency_code / 1e6), f32(f32(voltage_code) * f32(0.00003879))
+            messages.append((f'{{"timestamp":{timestamp},"sequence":{sample_sequence},'
+                             f'"frequency":{frequency:.6f},"voltage":{voltage:.3f}}}').encode())
+
+    start = time.perf_counter()
+    decoded = [decode_frame(payload)[1] for payload in payloads]
+    frame_s = time.perf_counter() - start
+
+    start = time.perf_counter()
+    parsed = [json.loads(message) for message in messages]
+    json_s = time.perf_counter() - start
+
+    # Lossless: codes and timestamps come back exactly, the floats within the JSON path's rounding
+    flat = [sample for frame in decoded for sample in frame]
+    for sample, original, message in zip(flat, (s for frame in seconds for s in frame), parsed):
+        if (sample["timestamp"], sample["frequency_code"], sample["voltage_code"], sample["sequence"]) != original:
+            raise FrameError("round trip mismatch")
+        if abs(sample["frequency"] - message["frequency"]) > JSON_FREQUENCY_TOLERANCE or \
+                abs(sample["voltage"] - message["voltage"]) > JSON_VOLTAGE_TOLERANCE:
+            raise FrameError("float mismatch against the JSON path")
+
+    frame_bytes = sum(len(payload) for payload in payloads)
+    json_bytes = sum(len(message) for message in messages)
+    total = len(flat)
+    print(f"{total} samples in {frames} frames, round trip exact")
+    print(f"columnar: {frame_bytes} bytes ({frame_bytes / total:.1f} B/sample) in {frames} messages, "
+          f"decode {frame_s * 1e6 / total:.2f} us/sample")
+    print(f"JSON:     {json_bytes} bytes ({json_bytes / total:.1f} B/sample) in {total} messages, "
+          f"parse {json_s * 1e6 / total:.2f} us/sample")
+    print(f"size ratio {json_bytes / frame_bytes:.1f}x, message ratio {total / frames:.0f}x")
+    return 0
+
+
+def load_mqtt_settings(args):
+    broker, port, username, password = args.broker, args.port, None, None
+    try:
+        from dotenv import load_dotenv
+        if load_dotenv():
+            broker = os.environ.get("MQTT_BROKER", broker)
+            port = int(os.environ.get("MQTT_PORT", port))
+            username = os.environ.get("MQTT_USERNAME")
+            password = os.environ.get("MQTT_PASSWORD")
+    except ImportError:
+        pass
+    return broker, port, username, password
+
+
+def run_mqtt(args, calibrations=None):
+    try:
+        import paho.mqtt.client as mqtt
+    except ImportError:
+        print("Error: paho-mqtt library not found. Install with: pip install paho-mqtt", file=sys.stderr)
+        return 1
+
+    broker, port, username, password = load_mqtt_settings(args)
+    tracker = SequenceTracker()
+    sample_tracker = SequenceTracker()
+
+    def on_connect(client, userdata, flags, rc):
+        client.subscribe([(FRAME_TOPIC, 0), (BACKFILL_TOPIC, 1)])
+        print(f"Subscribed to {FRAME_TOPIC} and {BACKFILL_TOPIC} on {broker}:{port}", file=sys.stderr)
+
+    def on_message(client, userdata, msg):
+        try:
+            header, samples = decode_frame(msg.payload, calibrations)
+        except FrameError as e:
+            print(f"{msg.topic}: {e}", file=sys.stderr)
+            return
+
+        # Replayed frames are old, only the live stream says whether frames went missing
+        backfill = msg.topic.endswith("/backfill")
+        lost = 0 if backfill else tracker.update(header["device_id"], header["sequence"])
+        if lost:
+            print(f"{header['device_id']}: {lost} frame(s) lost before sequence {header['sequence']} "
+                  f"({tracker.lost[header['device_id']]} in total)", file=sys.stderr)
+
+        # Samples can also go missing on the device, before or inside a frame; .../system says why
+        if not backfill and samples and samples[0]["sequence"] is not None:
+            device_id = header["device_id"]
+            lost = sample_tracker.update(device_id, samples[0]["sequence"], samples[-1]["sequence"])
+            lost += sample_tracker.add(device_id, sum((b["sequence"] - a["sequence"] - 1) & 0xFFFFFFFF
+                                                      for a, b in zip(samples, samples[1:])))
+            if lost:
+                print(f"{device_id}: {lost} sample(s) missing up to sample {samples[-1]['sequence']} "
+                      f"({sample_tracker.lost[device_id]} in total)", file=sys.stderr)
+
+        if args.bridge:
+            device_id = msg.topic.split("/")[1]
+            client.publish(f"{BASE_TOPIC}/{device_id}/measurement", json.dumps(samples))
+        else:
+            if backfill:
+                print("backfill ", end="")
+            print_frame(header, samples)
+
+    client = mqtt.Client()
+    if username:
+        client.username_pw_set(username, password)
+    client.on_connect = on_connect
+    client.on_message = on_message
+    client.connect(broker, port, 60)
+
+    try:
+        client.loop_forever()
+    except KeyboardInterrupt:
+        pass
+    finally:
+        client.disconnect()
+    return 0
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Decoder for Grid Frequency Monitor binary measurement frames")
+    parser.add_argument("files", nargs="*", help="Frame files to decode (raw MQTT payloads); omit to subscribe")
+    parser.add_argument("--broker", default="localhost", help="MQTT broker (default: localhost, or MQTT_BROKER in .env)")
+    parser.add_argument("--port", type=int, default=1883, help="MQTT port (default: 1883)")
+    parser.add_argument("--bridge", action="store_true",
+                        help="Republish each frame as a JSON array on .../measurement for Telegraf")
+    parser.add_argument("--calibration", metavar="FILE",
+                        help="JSON calibration table by ID, overriding the factors sent in the frames")
+    parser.add_argument("--benchmark", type=int, metavar="FRAMES",
+                        help="Round-trip FRAMES synthetic one-second frames and compare with the JSON path")
+    args = parser.parse_args()
+
+    calibrations = load_calibrations(args.calibration) if args.calibration else None
+    if args.benchmark:
+        return benchmark(args.benchmark)
+    if args.files:
+        return decode_files(args.files, calibrations)
+    return run_mqtt(args, calibrations)
+
+
+if __name__ == "__main__":
+    sys.exit(main())